@@ -0,0 +1,401 @@
+// Microbenchmarks for the asset and rendering hot paths: OBJ loading, occlusion
+// bakes, texture decode and block compression, staging uploads, mip generation,
+// camera updates, command buffer recording and clustered lighting. Results are
+// written as JSON so they can be tracked per commit.
+//
+// The Vulkan cases run on a headless Engine. For numbers that compare across
+// machines, pin them to lavapipe, e.g.
+//     VK_ICD_FILENAMES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json impgine_bench
+// Run from the repository root so models/, textures/ and shaders/ resolve.
+//
+// Usage: impgine_bench [--filter=substring] [--min-time=seconds] [--output=file.json]
+
+#include "engine.hpp"
+#include "assets/block_compression.hpp"
+#include "assets/texture_decode.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    struct Result {
+        std::string name;
+        uint64_t iterations;
+        double meanNs;
+        double medianNs;
+        double minNs;
+        double p95Ns;
+        double bytesPerIteration; // 0 when throughput is meaningless
+    };
+
+    // Runs each case until it has used up minSeconds, after one untimed
+    // iteration that absorbs first-touch allocations and lazy driver work
+    class Runner {
+        public: Runner(std::string filter, double minSeconds): filter {
+            std::move(filter)
+        }, minSeconds {
+            minSeconds
+        } {}
+
+        bool matches(const std::string & name) const {
+            return filter.empty() || name.find(filter) != std::string::npos;
+        }
+
+        void run(const std::string & name, double bytesPerIteration,
+            const std::function < void() > & body) {
+            if (!matches(name)) {
+                return;
+            }
+
+            body();
+
+            std::vector < double > samples;
+            auto start = Clock::now();
+            do {
+                auto iterationStart = Clock::now();
+                body();
+                samples.push_back(std::chrono::duration < double, std::nano > (Clock::now() - iterationStart).count());
+            } while (samples.size() < MIN_ITERATIONS ||
+                std::chrono::duration < double > (Clock::now() - start).count() < minSeconds);
+
+            std::sort(samples.begin(), samples.end());
+            Result result {};
+            result.name = name;
+            result.iterations = samples.size();
+            for (double sample: samples) {
+                result.meanNs += sample;
+            }
+            result.meanNs /= static_cast < double > (samples.size());
+            result.medianNs = samples[samples.size() / 2];
+            result.minNs = samples.front();
+            result.p95Ns = samples[std::min(samples.size() - 1, static_cast < size_t > (std::ceil(0.95 * samples.size())) - 1)];
+            result.bytesPerIteration = bytesPerIteration;
+            results.push_back(result);
+
+            std::cerr << "  " << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(1) <<
+                std::setw(12) << result.medianNs / 1000.0 << " us median  (" << result.iterations << " iterations)\n";
+        }
+
+        const std::vector < Result > & getResults() const {
+            return results;
+        }
+
+        private: static constexpr size_t MIN_ITERATIONS = 5;
+
+        std::string filter;
+        double minSeconds;
+        std::vector < Result > results;
+    };
+
+    std::string jsonString(const std::string & value) {
+        std::string escaped = "\"";
+        for (char c: value) {
+            if (c == '"' || c == '\\') {
+                escaped += '\\';
+            }
+            escaped += c;
+        }
+        return escaped + "\"";
+    }
+
+    void writeJson(std::ostream & out,
+        const std::string & deviceName,
+            const std::vector < Result > & results) {
+        out << std::fixed << std::setprecision(1);
+        out << "{\n  \"device\": " << (deviceName.empty() ? "null" : jsonString(deviceName)) << ",\n";
+        out << "  \"benchmarks\": [";
+        for (size_t i = 0; i < results.size(); i++) {
+            const Result & result = results[i];
+            out << (i == 0 ? "\n" : ",\n") << "    {\"name\": " << jsonString(result.name) <<
+                ", \"iterations\": " << result.iterations <<
+                ", \"mean_ns\": " << result.meanNs <<
+                ", \"median_ns\": " << result.medianNs <<
+                ", \"min_ns\": " << result.minNs <<
+                ", \"p95_ns\": " << result.p95Ns;
+            if (result.bytesPerIteration > 0.0) {
+                out << ", \"bytes_per_second\": " << result.bytesPerIteration * 1.0e9 / result.medianNs;
+            }
+            out << "}";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+    void benchCpuPaths(Runner & runner) {
+        runner.run("obj_parse_dedup", 0.0, []() {
+            impgine::MeshData mesh = impgine::loadObjMesh(impgine::Engine::MODEL_PATH);
+            if (mesh.indices.empty()) {
+                throw std::runtime_error("model has no indices");
+            }
+        });
+
+        impgine::JobSystem jobs;
+        runner.run("obj_parse_dedup_parallel", 0.0, [ & jobs]() {
+            impgine::MeshData mesh = impgine::loadObjMesh(impgine::Engine::MODEL_PATH, {}, & jobs);
+            if (mesh.indices.empty()) {
+                throw std::runtime_error("model has no indices");
+            }
+        });
+
+        // The bake alone, on the already processed meshes
+        const std::pair < std::string, std::string > bakeModels[] = {
+            {"ao_bake_viking_room", impgine::Engine::MODEL_PATH},
+            {"ao_bake_heart", "models/12190_Heart_v1_L3.obj"}
+        };
+        for (const auto & model: bakeModels) {
+            if (!runner.matches(model.first)) {
+                continue;
+            }
+            impgine::MeshData mesh = impgine::loadObjMesh(model.second, {}, & jobs);
+            runner.run(model.first, 0.0, [ & mesh, & jobs]() {
+                impgine::bakeVertexOcclusion(mesh.vertices, mesh.indices, {}, & jobs);
+            });
+        }
+
+        int width = 0, height = 0, channels = 0;
+        if (!stbi_info(impgine::Engine::TEXTURE_PATH.c_str(), & width, & height, & channels)) {
+            throw std::runtime_error("failed to read " + impgine::Engine::TEXTURE_PATH);
+        }
+        runner.run("stb_image_decode", static_cast < double > (width) * height * 4, []() {
+            int w, h, c;
+            stbi_uc * pixels = stbi_load(impgine::Engine::TEXTURE_PATH.c_str(), & w, & h, & c, STBI_rgb_alpha);
+            if (!pixels) {
+                throw std::runtime_error("failed to decode " + impgine::Engine::TEXTURE_PATH);
+            }
+            stbi_image_free(pixels);
+        });
+        // The engine's path: decoding straight into a preallocated (staging) buffer
+        std::vector < uint8_t > decoded(impgine::decodeBufferSize(static_cast < uint32_t > (width), static_cast < uint32_t > (height)));
+        runner.run("texture_decode_into", static_cast < double > (width) * height * 4, [ & ]() {
+            impgine::decodeTextureInto(impgine::Engine::TEXTURE_PATH, decoded.data(), static_cast < uint32_t > (width), static_cast < uint32_t > (height));
+        });
+        // The texture cache's encode on a miss, single-threaded; hits skip it entirely
+        for (impgine::BlockFormat format: {
+                impgine::BlockFormat::BC1, impgine::BlockFormat::BC7
+            }) {
+            std::vector < uint8_t > chain(impgine::compressedMipChainSize(format, static_cast < uint32_t > (width), static_cast < uint32_t > (height)));
+            runner.run(std::string("texture_compress_") + impgine::blockFormatName(format), static_cast < double > (width) * height * 4, [ & ]() {
+                impgine::compressMipChain(decoded.data(), static_cast < uint32_t > (width), static_cast < uint32_t > (height), format, chain.data());
+            });
+        }
+
+        impgine::Camera camera;
+        float angle = 0.0f;
+        runner.run("camera_update", 0.0, [ & ]() {
+            // One frame's worth: projection for the current aspect plus a new view
+            for (int i = 0; i < 1000; i++) {
+                angle += 0.001f;
+                camera.setPerspectiveProjection(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+                camera.setViewYXZ(glm::vec3 {
+                    std::cos(angle), std::sin(angle), 1.5f
+                }, glm::vec3 {
+                    0.4f, angle, 0.0f
+                });
+            }
+        });
+    }
+
+} // namespace
+
+namespace impgine {
+
+    // Reaches the private upload, mip and recording paths (see the friend
+    // declaration in Engine). Never renders a frame
+    class EngineBench {
+        public: explicit EngineBench(Engine & engine): engine {
+            engine
+        } {}
+
+        std::string deviceName() const {
+            VkPhysicalDeviceProperties properties;
+            vkGetPhysicalDeviceProperties(engine.physicalDevice, & properties);
+            return properties.deviceName;
+        }
+
+        void benchUpload(Runner & runner, VkDeviceSize size) {
+            std::string name = "staging_upload_" + std::to_string(size / 1024) + "k";
+            if (!runner.matches(name)) {
+                return;
+            }
+
+            VkBuffer stagingBuffer, buffer;
+            VkDeviceMemory stagingBufferMemory, bufferMemory;
+            engine.createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+            engine.createBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer, bufferMemory);
+            std::vector < uint8_t > source(static_cast < size_t > (size), 0x5a);
+
+            // The same steps as createVertexBuffer, plus the wait the engine defers to the next fence
+            runner.run(name, static_cast < double > (size), [ & ]() {
+                void * data;
+                vkMapMemory(engine.device, stagingBufferMemory, 0, size, 0, & data);
+                memcpy(data, source.data(), source.size());
+                vkUnmapMemory(engine.device, stagingBufferMemory);
+                engine.copyBuffer(stagingBuffer, buffer, size);
+                drainUploads();
+            });
+
+            vkDestroyBuffer(engine.device, buffer, nullptr);
+            vkFreeMemory(engine.device, bufferMemory, nullptr);
+            vkDestroyBuffer(engine.device, stagingBuffer, nullptr);
+            vkFreeMemory(engine.device, stagingBufferMemory, nullptr);
+        }
+
+        void benchMipmaps(Runner & runner, uint32_t size) {
+            std::string name = "mip_generation_" + std::to_string(size);
+            if (!runner.matches(name)) {
+                return;
+            }
+
+            const VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
+            uint32_t mipLevels = static_cast < uint32_t > (std::floor(std::log2(size))) + 1;
+            VkImage image;
+            VkDeviceMemory imageMemory;
+            engine.createImage(size, size, mipLevels, VK_SAMPLE_COUNT_1_BIT, format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, imageMemory);
+
+            // Starting from UNDEFINED discards the previous iteration's contents,
+            // which the blit chain doesn't care about
+            runner.run(name, 0.0, [ & ]() {
+                engine.transitionImageLayout(image, format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevels);
+                engine.generateMipmaps(image, format, static_cast < int32_t > (size), static_cast < int32_t > (size), mipLevels);
+                drainUploads();
+            });
+
+            vkDestroyImage(engine.device, image, nullptr);
+            vkFreeMemory(engine.device, imageMemory, nullptr);
+        }
+
+        void benchRecording(Runner & runner, size_t drawCount) {
+            std::string name = "record_commands_" + std::to_string(drawCount) + "_draws";
+            if (!runner.matches(name)) {
+                return;
+            }
+
+            FrameSnapshot snapshot = engine.captureSnapshot();
+            DrawItem item = snapshot.drawList.front();
+            snapshot.drawList.assign(drawCount, item);
+
+            // Never submitted, so the slot's command buffer is free to re-record
+            VkCommandBuffer commandBuffer = engine.commandBuffers[engine.currentFrame];
+            runner.run(name, 0.0, [ & ]() {
+                vkResetCommandBuffer(commandBuffer, 0);
+                engine.recordCommandBuffer(commandBuffer, engine.currentFrame, snapshot);
+            });
+        }
+
+        void benchLighting(Runner & runner, uint32_t lightCount) {
+            std::string name = "clustered_lighting_" + std::to_string(lightCount) + "_lights";
+            if (!runner.matches(name)) {
+                return;
+            }
+
+            // Same bounds as --lights; denser scenes put more lights in every cluster
+            engine.setLights(scatterPointLights(lightCount, glm::vec3(-1.2f, -1.2f, 0.0f), glm::vec3(1.2f, 1.2f, 1.0f), 0.35f));
+            FrameSnapshot snapshot = engine.captureSnapshot();
+
+            // A whole frame, culling and shading included, until the GPU is done with it
+            runner.run(name, 0.0, [ & ]() {
+                engine.drawFrame(snapshot);
+                vkQueueWaitIdle(engine.graphicsQueue);
+            });
+
+            engine.setLights({});
+        }
+
+        // Waits for the submitted work and frees what the single-time commands retired
+        private: void drainUploads() {
+            vkQueueWaitIdle(engine.graphicsQueue);
+            engine.deletionQueue.collect(engine.nextFrameNumber());
+        }
+
+        Engine & engine;
+    };
+
+} // namespace impgine
+
+int main(int argc, char * argv[]) {
+    std::string filter;
+    std::string outputPath;
+    double minSeconds = 0.5;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--filter=", 0) == 0) {
+            filter = arg.substr(9);
+        } else if (arg.rfind("--min-time=", 0) == 0) {
+            minSeconds = std::atof(arg.c_str() + 11);
+        } else if (arg.rfind("--output=", 0) == 0) {
+            outputPath = arg.substr(9);
+        } else {
+            std::cerr << "usage: impgine_bench [--filter=substring] [--min-time=seconds] [--output=file.json]\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    Runner runner(filter, minSeconds);
+    std::string deviceName;
+    try {
+        std::cerr << "CPU paths\n";
+        benchCpuPaths(runner);
+
+        // Without a usable device the CPU results are still worth reporting
+        std::unique_ptr < impgine::Engine > engine;
+        try {
+            impgine::EngineConfig config;
+            config.headless = true;
+            config.headlessExtent = {
+                256,
+                256
+            };
+            engine = std::make_unique < impgine::Engine > (config);
+        } catch (const std::exception & e) {
+            std::cerr << "skipping Vulkan paths: " << e.what() << "\n";
+        }
+
+        if (engine) {
+            impgine::EngineBench bench( * engine);
+            deviceName = bench.deviceName();
+            std::cerr << "Vulkan paths on " << deviceName << "\n";
+            for (VkDeviceSize size: {
+                    64 * 1024, 1024 * 1024, 16 * 1024 * 1024
+                }) {
+                bench.benchUpload(runner, size);
+            }
+            bench.benchMipmaps(runner, 1024);
+            bench.benchMipmaps(runner, 4096);
+            bench.benchRecording(runner, 1);
+            bench.benchRecording(runner, 1024);
+            for (uint32_t lightCount: {
+                    16, 64, 256, 1024, 4096
+                }) {
+                bench.benchLighting(runner, lightCount);
+            }
+        }
+    } catch (const std::exception & e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (outputPath.empty()) {
+        writeJson(std::cout, deviceName, runner.getResults());
+    } else {
+        std::ofstream file(outputPath);
+        writeJson(file, deviceName, runner.getResults());
+        if (!file) {
+            std::cerr << "failed to write " << outputPath << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::cerr << "Wrote " << outputPath << "\n";
+    }
+
+    return EXIT_SUCCESS;
+}
\ No newline at end of file
@@ -0,0 +1,118 @@
+// Microbenchmarks for the job system: per-job scheduling overhead and
+// parallelFor scaling from one worker up to every hardware thread.
+//
+// Usage: job_system_bench [iterations]
+
+#include "core/job_system.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    double elapsedMs(Clock::time_point start) {
+        return std::chrono::duration < double, std::milli > (Clock::now() - start).count();
+    }
+
+    // Cost of submitting and running jobs that do nothing
+    void benchEmptyJobs(unsigned workerCount, int jobCount) {
+        impgine::JobSystem jobs(workerCount);
+
+        impgine::JobCounter counter;
+        auto start = Clock::now();
+        for (int i = 0; i < jobCount; i++) {
+            jobs.submit([]() {}, & counter);
+        }
+        jobs.wait(counter);
+        double totalMs = elapsedMs(start);
+
+        std::cout << "  empty jobs    workers " << std::setw(2) << workerCount << ": " <<
+            std::fixed << std::setprecision(1) << totalMs * 1.0e6 / jobCount << " ns/job\n";
+    }
+
+    // Cost of a dependency chain where every job waits for the previous one
+    void benchChain(unsigned workerCount, int jobCount) {
+        impgine::JobSystem jobs(workerCount);
+
+        std::vector < impgine::JobCounter > counters(jobCount);
+        auto start = Clock::now();
+        jobs.submit([]() {}, & counters[0]);
+        for (int i = 1; i < jobCount; i++) {
+            jobs.submitAfter(counters[i - 1], []() {}, & counters[i]);
+        }
+        jobs.wait(counters[jobCount - 1]);
+        double totalMs = elapsedMs(start);
+
+        std::cout << "  chained jobs  workers " << std::setw(2) << workerCount << ": " <<
+            std::fixed << std::setprecision(1) << totalMs * 1.0e6 / jobCount << " ns/job\n";
+    }
+
+    // A compute-bound loop split with parallelFor; reports speedup over one worker
+    double benchParallelFor(unsigned workerCount, const std::vector < float > & input,
+        std::vector < float > & output, double baselineMs) {
+        impgine::JobSystem jobs(workerCount);
+
+        auto start = Clock::now();
+        jobs.parallelFor(0, input.size(), 4096, [ & ](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                float value = input[i];
+                for (int j = 0; j < 32; j++) {
+                    value = std::sqrt(value * value + 1.0f);
+                }
+                output[i] = value;
+            }
+        });
+        double totalMs = elapsedMs(start);
+
+        std::cout << "  parallelFor   workers " << std::setw(2) << workerCount << ": " <<
+            std::fixed << std::setprecision(2) << totalMs << " ms";
+        if (baselineMs > 0.0) {
+            std::cout << " (" << std::setprecision(2) << baselineMs / totalMs << "x)";
+        }
+        std::cout << "\n";
+        return totalMs;
+    }
+
+} // namespace
+
+int main(int argc, char * argv[]) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 200000;
+    if (iterations <= 0) {
+        std::cerr << "iterations must be positive\n";
+        return EXIT_FAILURE;
+    }
+
+    unsigned maxWorkers = std::thread::hardware_concurrency();
+    if (maxWorkers == 0) {
+        maxWorkers = 1;
+    }
+
+    std::cout << "scheduling overhead (" << iterations << " jobs)\n";
+    for (unsigned workers = 1; workers <= maxWorkers; workers *= 2) {
+        benchEmptyJobs(workers, iterations);
+    }
+    benchChain(1, iterations / 10);
+
+    std::vector < float > input(4 * 1024 * 1024);
+    std::vector < float > output(input.size());
+    for (size_t i = 0; i < input.size(); i++) {
+        input[i] = static_cast < float > (i % 1024);
+    }
+
+    std::cout << "parallelFor scaling (" << input.size() << " elements)\n";
+    double baselineMs = benchParallelFor(1, input, output, 0.0);
+    for (unsigned workers = 2; workers <= maxWorkers; workers *= 2) {
+        benchParallelFor(workers, input, output, baselineMs);
+    }
+    if ((maxWorkers & (maxWorkers - 1)) != 0) {
+        benchParallelFor(maxWorkers, input, output, baselineMs);
+    }
+
+    return EXIT_SUCCESS;
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#include "adaptive_msaa.hpp"
+
+#include <stdexcept>
+
+namespace impgine {
+
+    namespace {
+
+        constexpr double SMOOTHING = 0.1; // weight of the newest sample
+        // Frames in flight after a switch still ran at the old count
+        constexpr uint32_t SETTLE_FRAMES = 4;
+        constexpr uint32_t MEASURE_FRAMES = 30;
+        // Doubling the samples rarely doubles the frame, but leave room in case it does
+        constexpr double STEP_UP_HEADROOM = 0.6;
+        constexpr uint32_t RETRY_FRAMES = 1800;
+
+    } // namespace
+
+    AdaptiveMsaa::AdaptiveMsaa(double targetGpuMs, VkSampleCountFlagBits maxSamples): targetGpuMs {
+        targetGpuMs
+    }, maxSamples {
+        maxSamples
+    }, ceiling {
+        maxSamples
+    } {
+        if (!(targetGpuMs > 0.0)) {
+            throw std::runtime_error("invalid adaptive MSAA budget!");
+        }
+    }
+
+    void AdaptiveMsaa::update(double gpuMs) {
+        if (!(gpuMs > 0.0)) {
+            return;
+        }
+        if (settleFrames > 0) {
+            settleFrames--;
+            return;
+        }
+
+        smoothedGpuMs = measuredFrames == 0 ? gpuMs : smoothedGpuMs + SMOOTHING * (gpuMs - smoothedGpuMs);
+        if (++measuredFrames < MEASURE_FRAMES) {
+            return;
+        }
+
+        if (smoothedGpuMs > targetGpuMs) {
+            framesSinceMiss = 0;
+            if (samples > VK_SAMPLE_COUNT_1_BIT) {
+                ceiling = static_cast < VkSampleCountFlagBits > (samples >> 1);
+                setSamples(ceiling);
+            }
+            return;
+        }
+
+        // The scene may have become cheaper since a count missed
+        if (ceiling < maxSamples && ++framesSinceMiss >= RETRY_FRAMES) {
+            ceiling = maxSamples;
+        }
+
+        VkSampleCountFlagBits next = static_cast < VkSampleCountFlagBits > (samples << 1);
+        if (next <= ceiling && smoothedGpuMs < targetGpuMs * STEP_UP_HEADROOM) {
+            setSamples(next);
+        }
+    }
+
+    void AdaptiveMsaa::setSamples(VkSampleCountFlagBits newSamples) {
+        samples = newSamples;
+        settleFrames = SETTLE_FRAMES;
+        measuredFrames = 0;
+    }
+
+} // namespace impgine
\ No newline at end of file
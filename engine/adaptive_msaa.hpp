@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+
+namespace impgine {
+
+    // Picks the highest MSAA sample count whose GPU frame time fits a budget.
+    // Each count is measured for a while before deciding; a count that missed
+    // the budget is not retried until the budget has held for a long stretch,
+    // so the setting doesn't flip back and forth every few frames.
+    class AdaptiveMsaa {
+        public: AdaptiveMsaa(double targetGpuMs, VkSampleCountFlagBits maxSamples);
+
+        // Feed one frame's GPU time; a changed count applies to frames recorded afterwards
+        void update(double gpuMs);
+
+        VkSampleCountFlagBits getSamples() const {
+            return samples;
+        }
+        double getTargetGpuMs() const {
+            return targetGpuMs;
+        }
+
+        private: void setSamples(VkSampleCountFlagBits newSamples);
+
+        double targetGpuMs;
+        VkSampleCountFlagBits maxSamples;
+        // Starts low and climbs, so the first frames never stall a slow device
+        VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+        // Highest count not known to miss the budget
+        VkSampleCountFlagBits ceiling;
+        uint32_t settleFrames = 0;
+        uint32_t measuredFrames = 0;
+        uint32_t framesSinceMiss = 0;
+        double smoothedGpuMs = 0.0;
+    };
+
+} // namespace impgine
\ No newline at end of file
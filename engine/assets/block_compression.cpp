@@ -0,0 +1,553 @@
+#include "block_compression.hpp"
+
+#include "../core/job_system.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+namespace impgine {
+
+    namespace {
+
+        // Rows of blocks per job: a 1024-texel-wide image is 256 blocks a row
+        constexpr size_t BLOCK_ROW_GRAIN = 4;
+        constexpr size_t PIXEL_ROW_GRAIN = 64;
+
+        // Interpolation weights (of the second endpoint, out of 64) for 4-bit BC7 indices
+        constexpr int BC7_WEIGHTS[16] = {
+            0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64
+        };
+
+        template < typename Body >
+            void forEachChunk(JobSystem * jobs, size_t count, size_t grainSize, Body body) {
+                if (jobs) {
+                    jobs -> parallelFor(0, count, grainSize, body);
+                } else if (count > 0) {
+                    body(0, count);
+                }
+            }
+
+        struct SrgbTables {
+            float toLinear[256];
+            uint8_t fromLinear[4096];
+
+            SrgbTables() {
+                for (int i = 0; i < 256; i++) {
+                    float c = i / 255.0f;
+                    toLinear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+                }
+                for (int i = 0; i < 4096; i++) {
+                    float c = i / 4095.0f;
+                    float encoded = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+                    fromLinear[i] = static_cast < uint8_t > (std::lround(std::min(std::max(encoded, 0.0f), 1.0f) * 255.0f));
+                }
+            }
+        };
+
+        const SrgbTables & srgbTables() {
+            static const SrgbTables tables;
+            return tables;
+        }
+
+        int clampInt(long value, int low, int high) {
+            return static_cast < int > (std::min < long > (std::max < long > (value, low), high));
+        }
+
+        // The 4x4 texels of block (blockX, blockY), clamped at the image edges
+        void fetchBlock(const uint8_t * rgba, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY,
+            uint8_t texels[16][4]) {
+            for (uint32_t y = 0; y < 4; y++) {
+                uint32_t sourceY = std::min(blockY * 4 + y, height - 1);
+                for (uint32_t x = 0; x < 4; x++) {
+                    uint32_t sourceX = std::min(blockX * 4 + x, width - 1);
+                    std::memcpy(texels[y * 4 + x], rgba + (static_cast < size_t > (sourceY) * width + sourceX) * 4, 4);
+                }
+            }
+        }
+
+        // Mean and principal axis of the first `channels` channels; the axis is
+        // zero for a flat block
+        void principalAxis(const uint8_t texels[16][4], int channels, float mean[4], float axis[4]) {
+            for (int c = 0; c < 4; c++) {
+                mean[c] = 0.0f;
+                axis[c] = 0.0f;
+                for (int i = 0; i < 16; i++) {
+                    mean[c] += texels[i][c];
+                }
+                mean[c] /= 16.0f;
+            }
+
+            float covariance[4][4] = {};
+            for (int i = 0; i < 16; i++) {
+                for (int a = 0; a < channels; a++) {
+                    for (int b = 0; b < channels; b++) {
+                        covariance[a][b] += (texels[i][a] - mean[a]) * (texels[i][b] - mean[b]);
+                    }
+                }
+            }
+
+            // Power iteration from the row of the widest channel, which can't be
+            // orthogonal to the dominant direction
+            int widest = 0;
+            for (int c = 1; c < channels; c++) {
+                if (covariance[c][c] > covariance[widest][widest]) {
+                    widest = c;
+                }
+            }
+            if (covariance[widest][widest] <= 0.0f) {
+                return;
+            }
+            for (int c = 0; c < channels; c++) {
+                axis[c] = covariance[widest][c];
+            }
+            for (int iteration = 0; iteration < 8; iteration++) {
+                float next[4] = {};
+                float largest = 0.0f;
+                for (int a = 0; a < channels; a++) {
+                    for (int b = 0; b < channels; b++) {
+                        next[a] += covariance[a][b] * axis[b];
+                    }
+                    largest = std::max(largest, std::fabs(next[a]));
+                }
+                if (largest <= 0.0f) {
+                    break;
+                }
+                for (int c = 0; c < channels; c++) {
+                    axis[c] = next[c] / largest;
+                }
+            }
+
+            float length = 0.0f;
+            for (int c = 0; c < channels; c++) {
+                length += axis[c] * axis[c];
+            }
+            length = std::sqrt(length);
+            for (int c = 0; c < channels; c++) {
+                axis[c] /= length;
+            }
+        }
+
+        // The texels' extent along the axis, as the two endpoint colors
+        void axisEndpoints(const uint8_t texels[16][4], int channels, float high[4], float low[4]) {
+            float mean[4], axis[4];
+            principalAxis(texels, channels, mean, axis);
+            float minT = 0.0f, maxT = 0.0f;
+            for (int i = 0; i < 16; i++) {
+                float t = 0.0f;
+                for (int c = 0; c < channels; c++) {
+                    t += (texels[i][c] - mean[c]) * axis[c];
+                }
+                minT = std::min(minT, t);
+                maxT = std::max(maxT, t);
+            }
+            for (int c = 0; c < 4; c++) {
+                high[c] = std::min(std::max(mean[c] + axis[c] * maxT, 0.0f), 255.0f);
+                low[c] = std::min(std::max(mean[c] + axis[c] * minT, 0.0f), 255.0f);
+            }
+        }
+
+        // Least-squares endpoints for fixed indices: texel i is
+        // (1 - weights[i]) * first + weights[i] * second. False if the indices
+        // don't pin both endpoints down
+        bool refitEndpoints(const uint8_t texels[16][4], int channels, const float weights[16], float first[4],
+            float second[4]) {
+            float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+            float ax[4] = {}, bx[4] = {};
+            for (int i = 0; i < 16; i++) {
+                float b = weights[i];
+                float a = 1.0f - b;
+                aa += a * a;
+                ab += a * b;
+                bb += b * b;
+                for (int c = 0; c < channels; c++) {
+                    ax[c] += a * texels[i][c];
+                    bx[c] += b * texels[i][c];
+                }
+            }
+            float determinant = aa * bb - ab * ab;
+            if (std::fabs(determinant) < 1e-6f) {
+                return false;
+            }
+            for (int c = 0; c < channels; c++) {
+                first[c] = std::min(std::max((ax[c] * bb - bx[c] * ab) / determinant, 0.0f), 255.0f);
+                second[c] = std::min(std::max((bx[c] * aa - ax[c] * ab) / determinant, 0.0f), 255.0f);
+            }
+            return true;
+        }
+
+        uint16_t packRgb565(const float color[4]) {
+            int r = clampInt(std::lround(color[0] * 31.0f / 255.0f), 0, 31);
+            int g = clampInt(std::lround(color[1] * 63.0f / 255.0f), 0, 63);
+            int b = clampInt(std::lround(color[2] * 31.0f / 255.0f), 0, 31);
+            return static_cast < uint16_t > ((r << 11) | (g << 5) | b);
+        }
+
+        void unpackRgb565(uint16_t packed, int color[3]) {
+            int r = packed >> 11, g = (packed >> 5) & 63, b = packed & 31;
+            color[0] = (r << 3) | (r >> 2);
+            color[1] = (g << 2) | (g >> 4);
+            color[2] = (b << 3) | (b >> 2);
+        }
+
+        // Nearest of the four-color palette per texel; returns the squared error
+        int selectColorIndices(const uint8_t texels[16][4], uint16_t first, uint16_t second, uint8_t indices[16]) {
+            int palette[4][3];
+            unpackRgb565(first, palette[0]);
+            unpackRgb565(second, palette[1]);
+            for (int c = 0; c < 3; c++) {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+
+            int total = 0;
+            for (int i = 0; i < 16; i++) {
+                int bestError = INT32_MAX;
+                for (uint8_t candidate = 0; candidate < 4; candidate++) {
+                    int error = 0;
+                    for (int c = 0; c < 3; c++) {
+                        int d = texels[i][c] - palette[candidate][c];
+                        error += d * d;
+                    }
+                    if (error < bestError) {
+                        bestError = error;
+                        indices[i] = candidate;
+                    }
+                }
+                total += bestError;
+            }
+            return total;
+        }
+
+        // BC1 block in four-color mode, which BC3's color half always uses
+        void encodeColorBlock(const uint8_t texels[16][4], uint8_t * out) {
+            constexpr float INDEX_WEIGHTS[4] = {
+                0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f
+            };
+
+            float high[4], low[4];
+            axisEndpoints(texels, 3, high, low);
+            uint16_t first = packRgb565(high), second = packRgb565(low);
+            uint8_t indices[16];
+            int error = selectColorIndices(texels, first, second, indices);
+
+            // One least-squares pass over the chosen indices usually pulls the
+            // endpoints off the block's extremes towards a lower error
+            float weights[16];
+            for (int i = 0; i < 16; i++) {
+                weights[i] = INDEX_WEIGHTS[indices[i]];
+            }
+            if (refitEndpoints(texels, 3, weights, high, low)) {
+                uint16_t refitFirst = packRgb565(high), refitSecond = packRgb565(low);
+                uint8_t refitIndices[16];
+                int refitError = selectColorIndices(texels, refitFirst, refitSecond, refitIndices);
+                if (refitError < error) {
+                    first = refitFirst;
+                    second = refitSecond;
+                    std::memcpy(indices, refitIndices, sizeof(indices));
+                }
+            }
+
+            // first > second selects four colors; swapping the endpoints swaps
+            // indices 0 <-> 1 and 2 <-> 3. Equal endpoints make every texel index 0
+            if (first < second) {
+                std::swap(first, second);
+                for (uint8_t & index: indices) {
+                    index ^= 1;
+                }
+            } else if (first == second) {
+                std::fill(indices, indices + 16, 0);
+            }
+
+            uint32_t bits = 0;
+            for (int i = 0; i < 16; i++) {
+                bits |= static_cast < uint32_t > (indices[i]) << (2 * i);
+            }
+            out[0] = static_cast < uint8_t > (first);
+            out[1] = static_cast < uint8_t > (first >> 8);
+            out[2] = static_cast < uint8_t > (second);
+            out[3] = static_cast < uint8_t > (second >> 8);
+            for (int b = 0; b < 4; b++) {
+                out[4 + b] = static_cast < uint8_t > (bits >> (8 * b));
+            }
+        }
+
+        // BC3's alpha half: the block's alpha range in eight steps
+        void encodeAlphaBlock(const uint8_t texels[16][4], uint8_t * out) {
+            int high = 0, low = 255;
+            for (int i = 0; i < 16; i++) {
+                high = std::max < int > (high, texels[i][3]);
+                low = std::min < int > (low, texels[i][3]);
+            }
+            out[0] = static_cast < uint8_t > (high);
+            out[1] = static_cast < uint8_t > (low);
+
+            uint64_t bits = 0;
+            if (high > low) {
+                int palette[8] = {
+                    high, low
+                };
+                for (int step = 1; step < 7; step++) {
+                    palette[step + 1] = ((7 - step) * high + step * low) / 7;
+                }
+                for (int i = 0; i < 16; i++) {
+                    uint64_t best = 0;
+                    int bestError = INT32_MAX;
+                    for (int candidate = 0; candidate < 8; candidate++) {
+                        int error = std::abs(texels[i][3] - palette[candidate]);
+                        if (error < bestError) {
+                            bestError = error;
+                            best = static_cast < uint64_t > (candidate);
+                        }
+                    }
+                    bits |= best << (3 * i);
+                }
+            }
+            for (int b = 0; b < 6; b++) {
+                out[2 + b] = static_cast < uint8_t > (bits >> (8 * b));
+            }
+        }
+
+        // A BC7 mode 6 endpoint: 7 bits per channel and a p-bit as every channel's low bit
+        struct Bc7Endpoint {
+            int value[4];
+            int pBit;
+        };
+
+        Bc7Endpoint quantizeBc7(const float color[4]) {
+            Bc7Endpoint best {};
+            float bestError = -1.0f;
+            for (int pBit = 0; pBit < 2; pBit++) {
+                Bc7Endpoint candidate {};
+                candidate.pBit = pBit;
+                float error = 0.0f;
+                for (int c = 0; c < 4; c++) {
+                    candidate.value[c] = clampInt(std::lround((color[c] - pBit) / 2.0f), 0, 127);
+                    float d = color[c] - static_cast < float > ((candidate.value[c] << 1) | pBit);
+                    error += d * d;
+                }
+                if (bestError < 0.0f || error < bestError) {
+                    best = candidate;
+                    bestError = error;
+                }
+            }
+            return best;
+        }
+
+        int selectBc7Indices(const uint8_t texels[16][4], const Bc7Endpoint & first, const Bc7Endpoint & second,
+            uint8_t indices[16]) {
+            int palette[16][4];
+            for (int c = 0; c < 4; c++) {
+                int a = (first.value[c] << 1) | first.pBit;
+                int b = (second.value[c] << 1) | second.pBit;
+                for (int index = 0; index < 16; index++) {
+                    palette[index][c] = ((64 - BC7_WEIGHTS[index]) * a + BC7_WEIGHTS[index] * b + 32) >> 6;
+                }
+            }
+
+            int total = 0;
+            for (int i = 0; i < 16; i++) {
+                int bestError = INT32_MAX;
+                for (uint8_t candidate = 0; candidate < 16; candidate++) {
+                    int error = 0;
+                    for (int c = 0; c < 4; c++) {
+                        int d = texels[i][c] - palette[candidate][c];
+                        error += d * d;
+                    }
+                    if (error < bestError) {
+                        bestError = error;
+                        indices[i] = candidate;
+                    }
+                }
+                total += bestError;
+            }
+            return total;
+        }
+
+        // Packs fields least significant bit first, as BC7 lays out its 128 bits.
+        // The block is assembled in two words and stored once, so `out` is only
+        // ever written, never read back
+        struct BlockBitWriter {
+            uint64_t words[2] = {};
+            uint32_t position = 0;
+
+            void write(uint32_t value, uint32_t bits) {
+                uint64_t field = value & ((uint64_t(1) << bits) - 1);
+                uint32_t shift = position % 64;
+                words[position / 64] |= field << shift;
+                if (shift + bits > 64) {
+                    words[position / 64 + 1] |= field >> (64 - shift);
+                }
+                position += bits;
+            }
+
+            void store(uint8_t * out) const {
+                for (int b = 0; b < 16; b++) {
+                    out[b] = static_cast < uint8_t > (words[b / 8] >> (8 * (b % 8)));
+                }
+            }
+        };
+
+        void encodeBc7Block(const uint8_t texels[16][4], uint8_t * out) {
+            float high[4], low[4];
+            axisEndpoints(texels, 4, high, low);
+            Bc7Endpoint first = quantizeBc7(low), second = quantizeBc7(high);
+            uint8_t indices[16];
+            int error = selectBc7Indices(texels, first, second, indices);
+
+            float weights[16];
+            for (int i = 0; i < 16; i++) {
+                weights[i] = BC7_WEIGHTS[indices[i]] / 64.0f;
+            }
+            if (refitEndpoints(texels, 4, weights, low, high)) {
+                Bc7Endpoint refitFirst = quantizeBc7(low), refitSecond = quantizeBc7(high);
+                uint8_t refitIndices[16];
+                int refitError = selectBc7Indices(texels, refitFirst, refitSecond, refitIndices);
+                if (refitError < error) {
+                    first = refitFirst;
+                    second = refitSecond;
+                    std::memcpy(indices, refitIndices, sizeof(indices));
+                }
+            }
+
+            // The first texel's index drops its top bit, so it has to be in the lower half
+            if (indices[0] & 8) {
+                std::swap(first, second);
+                for (uint8_t & index: indices) {
+                    index = static_cast < uint8_t > (15 - index);
+                }
+            }
+
+            BlockBitWriter writer;
+            writer.write(1 << 6, 7); // mode 6
+            for (int c = 0; c < 4; c++) {
+                writer.write(static_cast < uint32_t > (first.value[c]), 7);
+                writer.write(static_cast < uint32_t > (second.value[c]), 7);
+            }
+            writer.write(static_cast < uint32_t > (first.pBit), 1);
+            writer.write(static_cast < uint32_t > (second.pBit), 1);
+            writer.write(indices[0], 3);
+            for (int i = 1; i < 16; i++) {
+                writer.write(indices[i], 4);
+            }
+            writer.store(out);
+        }
+
+    } // namespace
+
+    uint32_t blockBytes(BlockFormat format) {
+        return format == BlockFormat::BC1 ? 8 : 16;
+    }
+
+    const char * blockFormatName(BlockFormat format) {
+        switch (format) {
+        case BlockFormat::BC1:
+            return "bc1";
+        case BlockFormat::BC3:
+            return "bc3";
+        case BlockFormat::BC7:
+            return "bc7";
+        }
+        return "";
+    }
+
+    uint32_t mipLevelCount(uint32_t width, uint32_t height) {
+        return static_cast < uint32_t > (std::floor(std::log2(std::max(width, height)))) + 1;
+    }
+
+    size_t compressedLevelSize(BlockFormat format, uint32_t width, uint32_t height) {
+        return static_cast < size_t > ((width + 3) / 4) * ((height + 3) / 4) * blockBytes(format);
+    }
+
+    size_t compressedMipChainSize(BlockFormat format, uint32_t width, uint32_t height) {
+        size_t size = 0;
+        for (uint32_t level = 0; level < mipLevelCount(width, height); level++) {
+            size += compressedLevelSize(format, std::max(1u, width >> level), std::max(1u, height >> level));
+        }
+        return size;
+    }
+
+    void compressImage(const uint8_t * rgba, uint32_t width, uint32_t height, BlockFormat format,
+        uint8_t * destination, JobSystem * jobs) {
+        uint32_t blocksX = (width + 3) / 4;
+        uint32_t blocksY = (height + 3) / 4;
+        uint32_t bytes = blockBytes(format);
+
+        // Blocks are independent, so any split gives the same bytes
+        forEachChunk(jobs, blocksY, BLOCK_ROW_GRAIN, [ & ](size_t begin, size_t end) {
+            uint8_t texels[16][4];
+            for (size_t blockY = begin; blockY < end; blockY++) {
+                for (uint32_t blockX = 0; blockX < blocksX; blockX++) {
+                    fetchBlock(rgba, width, height, blockX, static_cast < uint32_t > (blockY), texels);
+                    uint8_t * out = destination + (blockY * blocksX + blockX) * bytes;
+                    switch (format) {
+                    case BlockFormat::BC1:
+                        encodeColorBlock(texels, out);
+                        break;
+                    case BlockFormat::BC3:
+                        encodeAlphaBlock(texels, out);
+                        encodeColorBlock(texels, out + 8);
+                        break;
+                    case BlockFormat::BC7:
+                        encodeBc7Block(texels, out);
+                        break;
+                    }
+                }
+            }
+        });
+    }
+
+    std::vector < uint8_t > downsampleSrgb(const uint8_t * rgba, uint32_t width, uint32_t height, JobSystem * jobs) {
+        const SrgbTables & tables = srgbTables();
+        uint32_t nextWidth = std::max(1u, width / 2);
+        uint32_t nextHeight = std::max(1u, height / 2);
+        std::vector < uint8_t > next(static_cast < size_t > (nextWidth) * nextHeight * 4);
+
+        forEachChunk(jobs, nextHeight, PIXEL_ROW_GRAIN, [ & ](size_t begin, size_t end) {
+            for (size_t y = begin; y < end; y++) {
+                const uint8_t * rows[2] = {
+                    rgba + std::min < size_t > (2 * y, height - 1) * width * 4,
+                    rgba + std::min < size_t > (2 * y + 1, height - 1) * width * 4
+                };
+                for (uint32_t x = 0; x < nextWidth; x++) {
+                    size_t columns[2] = {
+                        std::min < size_t > (2 * x, width - 1) * 4,
+                        std::min < size_t > (2 * x + 1, width - 1) * 4
+                    };
+                    uint8_t * out = next.data() + (y * nextWidth + x) * 4;
+                    for (int c = 0; c < 3; c++) {
+                        float sum = 0.0f;
+                        for (const uint8_t * row: rows) {
+                            for (size_t column: columns) {
+                                sum += tables.toLinear[row[column + c]];
+                            }
+                        }
+                        out[c] = tables.fromLinear[std::lround(sum / 4.0f * 4095.0f)];
+                    }
+                    int alpha = rows[0][columns[0] + 3] + rows[0][columns[1] + 3] + rows[1][columns[0] + 3] + rows[1][columns[1] + 3];
+                    out[3] = static_cast < uint8_t > ((alpha + 2) / 4);
+                }
+            }
+        });
+        return next;
+    }
+
+    void compressMipChain(const uint8_t * rgba, uint32_t width, uint32_t height, BlockFormat format,
+        uint8_t * destination, JobSystem * jobs) {
+        std::vector < uint8_t > level;
+        const uint8_t * pixels = rgba;
+        uint32_t levels = mipLevelCount(width, height);
+        for (uint32_t i = 0; i < levels; i++) {
+            compressImage(pixels, width, height, format, destination, jobs);
+            destination += compressedLevelSize(format, width, height);
+            if (i + 1 < levels) {
+                level = downsampleSrgb(pixels, width, height, jobs);
+                pixels = level.data();
+                width = std::max(1u, width / 2);
+                height = std::max(1u, height / 2);
+            }
+        }
+    }
+
+} // namespace impgine
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace impgine {
+
+    class JobSystem;
+
+    // GPU block-compressed formats; every one codes 4x4 texels at a time
+    enum class BlockFormat {
+        // 565 endpoints and 2-bit indices, no alpha: 8 bytes per block
+        BC1,
+        // BC1 color plus a separately interpolated alpha: 16 bytes per block
+        BC3,
+        // Mode 6 only (one subset, RGBA endpoints, 4-bit indices): 16 bytes
+        // per block, noticeably better color than BC1/BC3 at the size of BC3
+        BC7
+    };
+
+    uint32_t blockBytes(BlockFormat format);
+    const char * blockFormatName(BlockFormat format);
+
+    // Levels in a full chain down to 1x1, as the engine creates them
+    uint32_t mipLevelCount(uint32_t width, uint32_t height);
+    size_t compressedLevelSize(BlockFormat format, uint32_t width, uint32_t height);
+    size_t compressedMipChainSize(BlockFormat format, uint32_t width, uint32_t height);
+
+    // Encodes 8-bit RGBA pixels into width x height rounded up to whole blocks;
+    // edge blocks repeat the last row and column. Blocks are spread over `jobs`
+    void compressImage(const uint8_t * rgba, uint32_t width, uint32_t height, BlockFormat format,
+        uint8_t * destination, JobSystem * jobs = nullptr);
+
+    // The next mip level of sRGB-encoded pixels, box filtered in linear space
+    // like the GPU's blit of an SRGB image
+    std::vector < uint8_t > downsampleSrgb(const uint8_t * rgba, uint32_t width, uint32_t height,
+        JobSystem * jobs = nullptr);
+
+    // The full chain of `rgba`, base level first and tightly packed, which is
+    // both the KTX2 level order the cache reads back and the layout the upload copies from
+    void compressMipChain(const uint8_t * rgba, uint32_t width, uint32_t height, BlockFormat format,
+        uint8_t * destination, JobSystem * jobs = nullptr);
+
+} // namespace impgine
\ No newline at end of file
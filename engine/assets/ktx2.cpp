@@ -0,0 +1,276 @@
+#include "ktx2.hpp"
+
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace impgine {
+
+    namespace {
+
+        constexpr uint8_t IDENTIFIER[12] = {
+            0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
+        };
+        // Anything larger in a key/value block means a corrupt or foreign file
+        constexpr uint32_t MAX_KEY_VALUE_DATA = 1 << 16;
+
+        // Khronos Data Format constants for the basic descriptor block
+        constexpr uint8_t DF_MODEL_BC1A = 128;
+        constexpr uint8_t DF_MODEL_BC3 = 130;
+        constexpr uint8_t DF_MODEL_BC7 = 134;
+        constexpr uint8_t DF_PRIMARIES_BT709 = 1;
+        constexpr uint8_t DF_TRANSFER_SRGB = 2;
+        constexpr uint8_t DF_CHANNEL_COLOR = 0;
+        constexpr uint8_t DF_CHANNEL_ALPHA = 15;
+        // Marks a channel that sRGB decoding leaves linear, i.e. alpha
+        constexpr uint8_t DF_SAMPLE_LINEAR = 0x10;
+
+        struct Header {
+            uint8_t identifier[12];
+            uint32_t vkFormat;
+            uint32_t typeSize;
+            uint32_t pixelWidth;
+            uint32_t pixelHeight;
+            uint32_t pixelDepth;
+            uint32_t layerCount;
+            uint32_t faceCount;
+            uint32_t levelCount;
+            uint32_t supercompressionScheme;
+            uint32_t dfdByteOffset;
+            uint32_t dfdByteLength;
+            uint32_t kvdByteOffset;
+            uint32_t kvdByteLength;
+            uint64_t sgdByteOffset;
+            uint64_t sgdByteLength;
+        };
+        static_assert(sizeof(Header) == 80, "KTX2 header must match the file layout");
+
+        struct LevelIndex {
+            uint64_t byteOffset;
+            uint64_t byteLength;
+            uint64_t uncompressedByteLength;
+        };
+
+        uint32_t vulkanFormat(BlockFormat format) {
+            switch (format) {
+            case BlockFormat::BC1:
+                return VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+            case BlockFormat::BC3:
+                return VK_FORMAT_BC3_SRGB_BLOCK;
+            case BlockFormat::BC7:
+                return VK_FORMAT_BC7_SRGB_BLOCK;
+            }
+            return VK_FORMAT_UNDEFINED;
+        }
+
+        size_t alignUp(size_t value, size_t alignment) {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        template < typename T >
+            void append(std::vector < uint8_t > & out, T value) {
+                const uint8_t * bytes = reinterpret_cast < const uint8_t * > ( & value);
+                out.insert(out.end(), bytes, bytes + sizeof(value));
+            }
+
+        void appendSample(std::vector < uint8_t > & out, uint16_t bitOffset, uint8_t bitLength, uint8_t channel) {
+            append < uint16_t > (out, bitOffset);
+            append < uint8_t > (out, static_cast < uint8_t > (bitLength - 1));
+            append < uint8_t > (out, channel);
+            append < uint32_t > (out, 0); // sample position, all zero for block formats
+            append < uint32_t > (out, 0);
+            append < uint32_t > (out, 0xFFFFFFFFu);
+        }
+
+        // Data format descriptor: one basic block describing the BC format as sRGB
+        std::vector < uint8_t > dataFormatDescriptor(BlockFormat format) {
+            std::vector < uint8_t > samples;
+            uint8_t model = DF_MODEL_BC7;
+            switch (format) {
+            case BlockFormat::BC1:
+                model = DF_MODEL_BC1A;
+                appendSample(samples, 0, 64, DF_CHANNEL_COLOR);
+                break;
+            case BlockFormat::BC3:
+                model = DF_MODEL_BC3;
+                appendSample(samples, 0, 64, DF_CHANNEL_ALPHA | DF_SAMPLE_LINEAR);
+                appendSample(samples, 64, 64, DF_CHANNEL_COLOR);
+                break;
+            case BlockFormat::BC7:
+                appendSample(samples, 0, 128, DF_CHANNEL_COLOR);
+                break;
+            }
+
+            std::vector < uint8_t > block;
+            append < uint32_t > (block, 0); // Khronos vendor, basic descriptor type
+            append < uint16_t > (block, 2); // version 1.3
+            append < uint16_t > (block, static_cast < uint16_t > (24 + samples.size()));
+            block.push_back(model);
+            block.push_back(DF_PRIMARIES_BT709);
+            block.push_back(DF_TRANSFER_SRGB);
+            block.push_back(0); // straight alpha
+            const uint8_t blockDimensions[4] = {
+                3, 3, 0, 0
+            }; // 4x4x1x1, each stored minus one
+            block.insert(block.end(), blockDimensions, blockDimensions + 4);
+            block.push_back(static_cast < uint8_t > (blockBytes(format)));
+            block.insert(block.end(), 7, 0);
+            block.insert(block.end(), samples.begin(), samples.end());
+
+            std::vector < uint8_t > descriptor;
+            append < uint32_t > (descriptor, static_cast < uint32_t > (4 + block.size()));
+            descriptor.insert(descriptor.end(), block.begin(), block.end());
+            return descriptor;
+        }
+
+        std::vector < uint8_t > keyValueData(std::vector < std::pair < std::string, std::string >> keyValues) {
+            std::sort(keyValues.begin(), keyValues.end());
+            std::vector < uint8_t > data;
+            for (const auto & keyValue: keyValues) {
+                uint32_t length = static_cast < uint32_t > (keyValue.first.size() + 1 + keyValue.second.size() + 1);
+                append < uint32_t > (data, length);
+                data.insert(data.end(), keyValue.first.begin(), keyValue.first.end());
+                data.push_back(0);
+                data.insert(data.end(), keyValue.second.begin(), keyValue.second.end());
+                data.push_back(0);
+                data.resize(alignUp(data.size(), 4), 0);
+            }
+            return data;
+        }
+
+        bool parseKeyValueData(const std::vector < uint8_t > & data,
+            std::vector < std::pair < std::string, std::string >> & keyValues) {
+            size_t offset = 0;
+            while (offset + 4 <= data.size()) {
+                uint32_t length;
+                std::memcpy( & length, data.data() + offset, 4);
+                offset += 4;
+                if (length > data.size() - offset) {
+                    return false;
+                }
+                const char * entry = reinterpret_cast < const char * > (data.data() + offset);
+                const char * keyEnd = static_cast < const char * > (std::memchr(entry, 0, length));
+                if (!keyEnd) {
+                    return false;
+                }
+                std::string key(entry, keyEnd);
+                std::string value(keyEnd + 1, entry + length);
+                if (!value.empty() && value.back() == '\0') {
+                    value.pop_back();
+                }
+                keyValues.emplace_back(std::move(key), std::move(value));
+                offset = alignUp(offset + length, 4);
+            }
+            return true;
+        }
+
+    } // namespace
+
+    bool writeKtx2(const std::string & path, const Ktx2Image & image, const uint8_t * levels) {
+        uint32_t levelCount = mipLevelCount(image.width, image.height);
+        std::vector < uint8_t > descriptor = dataFormatDescriptor(image.format);
+        std::vector < uint8_t > keyValues = keyValueData(image.keyValues);
+
+        Header header {};
+        std::memcpy(header.identifier, IDENTIFIER, sizeof(IDENTIFIER));
+        header.vkFormat = vulkanFormat(image.format);
+        header.typeSize = 1;
+        header.pixelWidth = image.width;
+        header.pixelHeight = image.height;
+        header.faceCount = 1;
+        header.levelCount = levelCount;
+        header.dfdByteOffset = static_cast < uint32_t > (sizeof(Header) + levelCount * sizeof(LevelIndex));
+        header.dfdByteLength = static_cast < uint32_t > (descriptor.size());
+        header.kvdByteOffset = keyValues.empty() ? 0 : header.dfdByteOffset + header.dfdByteLength;
+        header.kvdByteLength = static_cast < uint32_t > (keyValues.size());
+
+        // Levels are stored smallest first so a streaming reader gets a usable
+        // image early; each starts on a multiple of the block size
+        std::vector < LevelIndex > index(levelCount);
+        std::vector < size_t > packedOffsets(levelCount);
+        size_t packedOffset = 0;
+        for (uint32_t level = 0; level < levelCount; level++) {
+            packedOffsets[level] = packedOffset;
+            index[level].byteLength = compressedLevelSize(image.format, std::max(1u, image.width >> level),
+                std::max(1u, image.height >> level));
+            index[level].uncompressedByteLength = index[level].byteLength;
+            packedOffset += index[level].byteLength;
+        }
+        size_t fileOffset = header.dfdByteOffset + descriptor.size() + keyValues.size();
+        for (uint32_t level = levelCount; level-- > 0;) {
+            fileOffset = alignUp(fileOffset, blockBytes(image.format));
+            index[level].byteOffset = fileOffset;
+            fileOffset += index[level].byteLength;
+        }
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            return false;
+        }
+        file.write(reinterpret_cast < const char * > ( & header), sizeof(header));
+        file.write(reinterpret_cast < const char * > (index.data()), index.size() * sizeof(LevelIndex));
+        file.write(reinterpret_cast < const char * > (descriptor.data()), descriptor.size());
+        file.write(reinterpret_cast < const char * > (keyValues.data()), keyValues.size());
+        for (uint32_t level = levelCount; level-- > 0;) {
+            static const char padding[16] = {};
+            file.write(padding, index[level].byteOffset - static_cast < uint64_t > (file.tellp()));
+            file.write(reinterpret_cast < const char * > (levels + packedOffsets[level]), index[level].byteLength);
+        }
+        return static_cast < bool > (file.flush());
+    }
+
+    bool readKtx2(const std::string & path, const Ktx2Image & expected, uint8_t * destination) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            return false;
+        }
+
+        Header header {};
+        uint32_t levelCount = mipLevelCount(expected.width, expected.height);
+        if (!file.read(reinterpret_cast < char * > ( & header), sizeof(header)) ||
+            std::memcmp(header.identifier, IDENTIFIER, sizeof(IDENTIFIER)) != 0 ||
+            header.vkFormat != vulkanFormat(expected.format) || header.pixelWidth != expected.width ||
+            header.pixelHeight != expected.height || header.pixelDepth != 0 || header.layerCount != 0 ||
+            header.faceCount != 1 || header.levelCount != levelCount || header.supercompressionScheme != 0 ||
+            header.kvdByteLength > MAX_KEY_VALUE_DATA) {
+            return false;
+        }
+
+        std::vector < LevelIndex > index(levelCount);
+        if (!file.read(reinterpret_cast < char * > (index.data()), index.size() * sizeof(LevelIndex))) {
+            return false;
+        }
+
+        std::vector < uint8_t > keyValueBytes(header.kvdByteLength);
+        std::vector < std::pair < std::string, std::string >> keyValues;
+        if (!file.seekg(header.kvdByteOffset) ||
+            !file.read(reinterpret_cast < char * > (keyValueBytes.data()), keyValueBytes.size()) ||
+            !parseKeyValueData(keyValueBytes, keyValues)) {
+            return false;
+        }
+        for (const auto & wanted: expected.keyValues) {
+            if (std::find(keyValues.begin(), keyValues.end(), wanted) == keyValues.end()) {
+                return false;
+            }
+        }
+
+        for (uint32_t level = 0; level < levelCount; level++) {
+            size_t size = compressedLevelSize(expected.format, std::max(1u, expected.width >> level),
+                std::max(1u, expected.height >> level));
+            if (index[level].byteLength != size) {
+                return false;
+            }
+        }
+        for (uint32_t level = 0; level < levelCount; level++) {
+            if (!file.seekg(static_cast < std::streamoff > (index[level].byteOffset)) ||
+                !file.read(reinterpret_cast < char * > (destination), index[level].byteLength)) {
+                return false;
+            }
+            destination += index[level].byteLength;
+        }
+        return true;
+    }
+
+} // namespace impgine
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "block_compression.hpp"
+
+namespace impgine {
+
+    // What a KTX2 file holds, as far as the engine uses the format: one 2D,
+    // sRGB, BC-compressed image with its full mip chain and no supercompression
+    struct Ktx2Image {
+        BlockFormat format = BlockFormat::BC7;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        // Written as NUL-terminated strings; sorted by key on write, as the spec requires
+        std::vector < std::pair < std::string, std::string >> keyValues;
+    };
+
+    // Writes `levels`, the mip chain packed base level first as compressMipChain
+    // lays it out, to `path`. Returns false on I/O failure
+    bool writeKtx2(const std::string & path, const Ktx2Image & image, const uint8_t * levels);
+
+    // Reads the mip chain of `path` into `destination` (compressedMipChainSize
+    // bytes, packed base level first) if the file matches `expected`: same
+    // format, size and full chain, and every one of its key/value pairs present
+    // with the same value. Everything is checked before any level data is read
+    bool readKtx2(const std::string & path, const Ktx2Image & expected, uint8_t * destination);
+
+} // namespace impgine
\ No newline at end of file
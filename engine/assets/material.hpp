@@ -0,0 +1,31 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#define GLM_FORCE_DEFAULT_ALIGNED_GENTYPES
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+
+namespace impgine {
+
+    // The subset of an MTL material the renderer uses
+    struct Material {
+        // Empty for the material of faces that name none
+        std::string name;
+        glm::vec3 diffuseColor {
+            1.0f
+        };
+        // map_Kd resolved against the OBJ's directory; empty when untextured
+        std::string diffuseTexture;
+    };
+
+    // A contiguous run of a mesh's indices that uses a single material
+    struct MeshRange {
+        uint32_t firstIndex = 0;
+        uint32_t indexCount = 0;
+        uint32_t materialIndex = 0;
+    };
+
+} // namespace impgine
\ No newline at end of file
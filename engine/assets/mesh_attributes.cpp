@@ -0,0 +1,212 @@
+#include "mesh_attributes.hpp"
+
+#include "../core/job_system.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+namespace impgine {
+
+    namespace {
+
+        // Triangles per job; small enough to spread a mesh of a few thousand
+        // triangles over the workers, large enough to amortize a submission
+        constexpr size_t TRIANGLE_GRAIN = 2048;
+        constexpr size_t POSITION_GRAIN = 4096;
+
+        template < typename Body >
+            void forEachChunk(JobSystem * jobs, size_t count, size_t grainSize, Body body) {
+                if (jobs) {
+                    jobs -> parallelFor(0, count, grainSize, body);
+                } else if (count > 0) {
+                    body(0, count);
+                }
+            }
+
+        // Angle at `corner` between the edges towards the other two
+        float cornerAngle(const glm::vec3 & corner, const glm::vec3 & next, const glm::vec3 & previous) {
+            glm::vec3 a = next - corner;
+            glm::vec3 b = previous - corner;
+            float lengths = glm::length(a) * glm::length(b);
+            if (!(lengths > 0.0f)) {
+                return 0.0f;
+            }
+            return std::acos(glm::clamp(glm::dot(a, b) / lengths, -1.0f, 1.0f));
+        }
+
+        std::vector < float > computeCornerAngles(const TriangleCorners & mesh, JobSystem * jobs) {
+            std::vector < float > angles(mesh.positionIndices.size());
+            forEachChunk(jobs, mesh.positionIndices.size() / 3, TRIANGLE_GRAIN, [ & ](size_t begin, size_t end) {
+                for (size_t triangle = begin; triangle < end; triangle++) {
+                    for (size_t i = 0; i < 3; i++) {
+                        angles[3 * triangle + i] = cornerAngle(
+                            mesh.positions[mesh.positionIndices[3 * triangle + i]],
+                            mesh.positions[mesh.positionIndices[3 * triangle + (i + 1) % 3]],
+                            mesh.positions[mesh.positionIndices[3 * triangle + (i + 2) % 3]]);
+                    }
+                }
+            });
+            return angles;
+        }
+
+        // Any unit vector perpendicular to `normal`
+        glm::vec3 perpendicular(const glm::vec3 & normal) {
+            glm::vec3 axis = std::abs(normal.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+            return glm::normalize(axis - normal * glm::dot(normal, axis));
+        }
+
+    } // namespace
+
+    CornerAdjacency buildCornerAdjacency(const TriangleCorners & mesh, JobSystem * jobs) {
+        size_t positionCount = mesh.positions.size();
+        size_t triangleCount = mesh.positionIndices.size() / 3;
+
+        // Count the corners per position, then turn the counts into each
+        // group's write cursor
+        std::vector < std::atomic < uint32_t >> cursors(positionCount);
+        forEachChunk(jobs, triangleCount, TRIANGLE_GRAIN, [ & ](size_t begin, size_t end) {
+            for (size_t corner = 3 * begin; corner < 3 * end; corner++) {
+                cursors[mesh.positionIndices[corner]].fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+
+        CornerAdjacency adjacency;
+        adjacency.offsets.resize(positionCount + 1);
+        adjacency.offsets[0] = 0;
+        for (size_t position = 0; position < positionCount; position++) {
+            uint32_t count = cursors[position].load(std::memory_order_relaxed);
+            adjacency.offsets[position + 1] = adjacency.offsets[position] + count;
+            cursors[position].store(adjacency.offsets[position], std::memory_order_relaxed);
+        }
+
+        adjacency.corners.resize(mesh.positionIndices.size());
+        forEachChunk(jobs, triangleCount, TRIANGLE_GRAIN, [ & ](size_t begin, size_t end) {
+            for (size_t corner = 3 * begin; corner < 3 * end; corner++) {
+                uint32_t slot = cursors[mesh.positionIndices[corner]].fetch_add(1, std::memory_order_relaxed);
+                adjacency.corners[slot] = static_cast < uint32_t > (corner);
+            }
+        });
+
+        // The fill order varies between runs; sorting keeps the float sums below reproducible
+        forEachChunk(jobs, positionCount, POSITION_GRAIN, [ & ](size_t begin, size_t end) {
+            for (size_t position = begin; position < end; position++) {
+                std::sort(adjacency.corners.begin() + adjacency.offsets[position],
+                    adjacency.corners.begin() + adjacency.offsets[position + 1]);
+            }
+        });
+        return adjacency;
+    }
+
+    std::vector < glm::vec3 > generateNormals(const TriangleCorners & mesh, const CornerAdjacency & adjacency,
+        NormalWeighting weighting, float creaseAngle, JobSystem * jobs) {
+        size_t triangleCount = mesh.positionIndices.size() / 3;
+
+        std::vector < glm::vec3 > faceNormals(triangleCount);
+        std::vector < float > weights = weighting == NormalWeighting::Angle ? computeCornerAngles(mesh, jobs) :
+            std::vector < float > (mesh.positionIndices.size());
+        forEachChunk(jobs, triangleCount, TRIANGLE_GRAIN, [ & ](size_t begin, size_t end) {
+            for (size_t triangle = begin; triangle < end; triangle++) {
+                const glm::vec3 & p0 = mesh.positions[mesh.positionIndices[3 * triangle + 0]];
+                const glm::vec3 & p1 = mesh.positions[mesh.positionIndices[3 * triangle + 1]];
+                const glm::vec3 & p2 = mesh.positions[mesh.positionIndices[3 * triangle + 2]];
+                glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+                float doubleArea = glm::length(normal);
+                faceNormals[triangle] = doubleArea > 0.0f ? normal / doubleArea : glm::vec3(0.0f);
+                if (weighting == NormalWeighting::Area) {
+                    weights[3 * triangle + 0] = weights[3 * triangle + 1] = weights[3 * triangle + 2] = doubleArea;
+                }
+            }
+        });
+
+        float creaseCosine = std::cos(creaseAngle);
+        std::vector < glm::vec3 > normals(mesh.positionIndices.size());
+        forEachChunk(jobs, triangleCount, TRIANGLE_GRAIN, [ & ](size_t begin, size_t end) {
+            for (size_t corner = 3 * begin; corner < 3 * end; corner++) {
+                const glm::vec3 & faceNormal = faceNormals[corner / 3];
+                // A degenerate face has no direction of its own, so it takes its neighbours'
+                bool degenerate = faceNormal == glm::vec3(0.0f);
+
+                uint32_t position = mesh.positionIndices[corner];
+                glm::vec3 sum(0.0f);
+                for (uint32_t i = adjacency.offsets[position]; i < adjacency.offsets[position + 1]; i++) {
+                    uint32_t other = adjacency.corners[i];
+                    const glm::vec3 & otherNormal = faceNormals[other / 3];
+                    if (degenerate || glm::dot(otherNormal, faceNormal) >= creaseCosine) {
+                        sum += otherNormal * weights[other];
+                    }
+                }
+
+                float length = glm::length(sum);
+                if (length > 1e-20f) {
+                    normals[corner] = sum / length;
+                } else {
+                    normals[corner] = degenerate ? glm::vec3(0.0f, 0.0f, 1.0f) : faceNormal;
+                }
+            }
+        });
+        return normals;
+    }
+
+    std::vector < glm::vec4 > generateTangents(const TriangleCorners & mesh, const CornerAdjacency & adjacency,
+        const std::vector < glm::vec3 > & normals, JobSystem * jobs) {
+        size_t triangleCount = mesh.positionIndices.size() / 3;
+
+        // Face tangents along +u, with the UV orientation as handedness; 0 marks
+        // triangles whose UVs span no area
+        std::vector < glm::vec3 > faceTangents(triangleCount);
+        std::vector < float > faceSigns(triangleCount);
+        std::vector < float > angles = computeCornerAngles(mesh, jobs);
+        forEachChunk(jobs, triangleCount, TRIANGLE_GRAIN, [ & ](size_t begin, size_t end) {
+            for (size_t triangle = begin; triangle < end; triangle++) {
+                const glm::vec3 & p0 = mesh.positions[mesh.positionIndices[3 * triangle + 0]];
+                glm::vec3 edge1 = mesh.positions[mesh.positionIndices[3 * triangle + 1]] - p0;
+                glm::vec3 edge2 = mesh.positions[mesh.positionIndices[3 * triangle + 2]] - p0;
+                glm::vec2 deltaUv1 = mesh.texCoords[3 * triangle + 1] - mesh.texCoords[3 * triangle];
+                glm::vec2 deltaUv2 = mesh.texCoords[3 * triangle + 2] - mesh.texCoords[3 * triangle];
+
+                float signedUvArea = deltaUv1.x * deltaUv2.y - deltaUv2.x * deltaUv1.y;
+                glm::vec3 tangent = (edge1 * deltaUv2.y - edge2 * deltaUv1.y) * (signedUvArea > 0.0f ? 1.0f : -1.0f);
+                float length = glm::length(tangent);
+                if (signedUvArea == 0.0f || !(length > 0.0f)) {
+                    faceTangents[triangle] = glm::vec3(0.0f);
+                    faceSigns[triangle] = 0.0f;
+                } else {
+                    faceTangents[triangle] = tangent / length;
+                    faceSigns[triangle] = signedUvArea > 0.0f ? 1.0f : -1.0f;
+                }
+            }
+        });
+
+        std::vector < glm::vec4 > tangents(mesh.positionIndices.size());
+        forEachChunk(jobs, triangleCount, TRIANGLE_GRAIN, [ & ](size_t begin, size_t end) {
+            for (size_t corner = 3 * begin; corner < 3 * end; corner++) {
+                const glm::vec3 & normal = normals[corner];
+                float sign = faceSigns[corner / 3];
+
+                glm::vec3 sum(0.0f);
+                if (sign != 0.0f) {
+                    uint32_t position = mesh.positionIndices[corner];
+                    for (uint32_t i = adjacency.offsets[position]; i < adjacency.offsets[position + 1]; i++) {
+                        uint32_t other = adjacency.corners[i];
+                        if (faceSigns[other / 3] != sign || !(normals[other] == normal) ||
+                            !(mesh.texCoords[other] == mesh.texCoords[corner])) {
+                            continue;
+                        }
+                        glm::vec3 projected = faceTangents[other / 3] - normal * glm::dot(normal, faceTangents[other / 3]);
+                        float length = glm::length(projected);
+                        if (length > 0.0f) {
+                            sum += projected * (angles[other] / length);
+                        }
+                    }
+                }
+
+                float length = glm::length(sum);
+                glm::vec3 tangent = length > 1e-20f ? sum / length : perpendicular(normal);
+                tangents[corner] = glm::vec4(tangent, sign < 0.0f ? -1.0f : 1.0f);
+            }
+        });
+        return tangents;
+    }
+
+} // namespace impgine
\ No newline at end of file
@@ -0,0 +1,59 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#define GLM_FORCE_DEFAULT_ALIGNED_GENTYPES
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace impgine {
+
+    class JobSystem;
+
+    enum class NormalWeighting {
+        // Each face counts in proportion to its area
+        Area,
+        // Each face counts with the angle it spans at the vertex, which keeps
+        // the result independent of how a surface is tessellated
+        Angle
+    };
+
+    // An unindexed triangle list: corner c belongs to triangle c / 3. Corners
+    // at the same file position share a position index, which is what the
+    // smoothing and tangent averaging group by
+    struct TriangleCorners {
+        std::vector < glm::vec3 > positions;
+        std::vector < uint32_t > positionIndices;
+        // Per corner, in the file's convention (v pointing up)
+        std::vector < glm::vec2 > texCoords;
+    };
+
+    // The corners at each position in CSR form: those of position p are
+    // corners[offsets[p]] to corners[offsets[p + 1]]. Each group is sorted, so
+    // nothing computed from it depends on thread timing
+    struct CornerAdjacency {
+        std::vector < uint32_t > offsets;
+        std::vector < uint32_t > corners;
+    };
+
+    // All of these split the work into triangle chunks on `jobs`, or run on the
+    // calling thread when it is null. Every output element is written by a
+    // single chunk; the only shared state is the atomic counters that bucket
+    // corners by position
+    CornerAdjacency buildCornerAdjacency(const TriangleCorners & mesh, JobSystem * jobs);
+
+    // Smooth per-corner normals: a corner sums the weighted normals of the faces
+    // around its position that lie within `creaseAngle` radians of its own face
+    std::vector < glm::vec3 > generateNormals(const TriangleCorners & mesh, const CornerAdjacency & adjacency,
+        NormalWeighting weighting, float creaseAngle, JobSystem * jobs);
+
+    // Per-corner tangents following MikkTSpace's conventions: the face tangents
+    // are projected onto the corner normal and angle-weighted, averaged over
+    // the corners sharing position, normal, UV and handedness. w holds the
+    // handedness, with bitangent = w * cross(normal, tangent.xyz)
+    std::vector < glm::vec4 > generateTangents(const TriangleCorners & mesh, const CornerAdjacency & adjacency,
+        const std::vector < glm::vec3 > & normals, JobSystem * jobs);
+
+} // namespace impgine
\ No newline at end of file
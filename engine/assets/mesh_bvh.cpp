@@ -0,0 +1,206 @@
+#include "mesh_bvh.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IMPGINE_BVH_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace impgine {
+
+    namespace {
+
+        // Rejects triangles nearly parallel to the ray along with the padding lanes
+        constexpr float DETERMINANT_EPSILON = 1e-12f;
+        // Deep enough for any tree built from 32-bit triangle counts
+        constexpr size_t MAX_STACK_DEPTH = 64;
+
+        bool intersectsBounds(const glm::vec3 & boundsMin, const glm::vec3 & boundsMax, const glm::vec3 & origin,
+            const glm::vec3 & inverseDirection, float minDistance, float maxDistance) {
+            for (int axis = 0; axis < 3; axis++) {
+                float t0 = (boundsMin[axis] - origin[axis]) * inverseDirection[axis];
+                float t1 = (boundsMax[axis] - origin[axis]) * inverseDirection[axis];
+                if (t0 > t1) {
+                    std::swap(t0, t1);
+                }
+                // NaN from 0 * inf (a ray in a slab's plane) keeps the bounds open
+                minDistance = t0 > minDistance ? t0 : minDistance;
+                maxDistance = t1 < maxDistance ? t1 : maxDistance;
+                if (minDistance > maxDistance) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+    } // namespace
+
+    MeshBvh::MeshBvh(const std::vector < glm::vec3 > & positions, const std::vector < uint32_t > & indices) {
+        size_t triangleCount = indices.size() / 3;
+        std::vector < glm::vec3 > centroids(triangleCount);
+        std::vector < uint32_t > triangles(triangleCount);
+        for (size_t triangle = 0; triangle < triangleCount; triangle++) {
+            centroids[triangle] = (positions[indices[3 * triangle]] + positions[indices[3 * triangle + 1]] +
+                positions[indices[3 * triangle + 2]]) / 3.0f;
+            triangles[triangle] = static_cast < uint32_t > (triangle);
+        }
+
+        nodes.reserve(2 * (triangleCount / LEAF_SIZE + 1));
+        packets.reserve(triangleCount / LEAF_SIZE + 1);
+        if (triangleCount > 0) {
+            build(triangles, 0, triangleCount, centroids, positions, indices);
+        }
+    }
+
+    uint32_t MeshBvh::build(std::vector < uint32_t > & triangles, size_t begin, size_t end,
+        const std::vector < glm::vec3 > & centroids, const std::vector < glm::vec3 > & positions,
+            const std::vector < uint32_t > & indices) {
+        uint32_t nodeIndex = static_cast < uint32_t > (nodes.size());
+        nodes.emplace_back();
+
+        glm::vec3 boundsMin(std::numeric_limits < float > ::max());
+        glm::vec3 boundsMax(std::numeric_limits < float > ::lowest());
+        glm::vec3 centroidMin = boundsMin;
+        glm::vec3 centroidMax = boundsMax;
+        for (size_t i = begin; i < end; i++) {
+            for (int corner = 0; corner < 3; corner++) {
+                const glm::vec3 & position = positions[indices[3 * triangles[i] + corner]];
+                boundsMin = glm::min(boundsMin, position);
+                boundsMax = glm::max(boundsMax, position);
+            }
+            centroidMin = glm::min(centroidMin, centroids[triangles[i]]);
+            centroidMax = glm::max(centroidMax, centroids[triangles[i]]);
+        }
+        nodes[nodeIndex].boundsMin = boundsMin;
+        nodes[nodeIndex].boundsMax = boundsMax;
+
+        if (end - begin <= LEAF_SIZE) {
+            TrianglePacket packet {};
+            for (size_t lane = 0; lane < end - begin; lane++) {
+                uint32_t triangle = triangles[begin + lane];
+                const glm::vec3 & v0 = positions[indices[3 * triangle]];
+                glm::vec3 edge1 = positions[indices[3 * triangle + 1]] - v0;
+                glm::vec3 edge2 = positions[indices[3 * triangle + 2]] - v0;
+                for (int axis = 0; axis < 3; axis++) {
+                    packet.v0[axis][lane] = v0[axis];
+                    packet.edge1[axis][lane] = edge1[axis];
+                    packet.edge2[axis][lane] = edge2[axis];
+                }
+            }
+            nodes[nodeIndex].index = static_cast < uint32_t > (packets.size());
+            nodes[nodeIndex].isLeaf = 1;
+            packets.push_back(packet);
+            return nodeIndex;
+        }
+
+        // Median split along the widest axis of the centroids
+        glm::vec3 extent = centroidMax - centroidMin;
+        int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+        size_t middle = begin + (end - begin) / 2;
+        std::nth_element(triangles.begin() + begin, triangles.begin() + middle, triangles.begin() + end,
+            [ & centroids, axis](uint32_t a, uint32_t b) {
+                return centroids[a][axis] < centroids[b][axis];
+            });
+
+        build(triangles, begin, middle, centroids, positions, indices);
+        uint32_t second = build(triangles, middle, end, centroids, positions, indices);
+        nodes[nodeIndex].index = second;
+        nodes[nodeIndex].isLeaf = 0;
+        return nodeIndex;
+    }
+
+    bool MeshBvh::occluded(const glm::vec3 & origin, const glm::vec3 & direction, float minDistance,
+        float maxDistance) const {
+        if (nodes.empty()) {
+            return false;
+        }
+        glm::vec3 inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+
+        uint32_t stack[MAX_STACK_DEPTH];
+        size_t stackSize = 0;
+        stack[stackSize++] = 0;
+        while (stackSize > 0) {
+            uint32_t nodeIndex = stack[--stackSize];
+            const Node & node = nodes[nodeIndex];
+            if (!intersectsBounds(node.boundsMin, node.boundsMax, origin, inverseDirection, minDistance, maxDistance)) {
+                continue;
+            }
+            if (node.isLeaf) {
+                if (intersectsPacket(packets[node.index], origin, direction, minDistance, maxDistance)) {
+                    return true;
+                }
+            } else {
+                stack[stackSize++] = node.index;
+                stack[stackSize++] = nodeIndex + 1;
+            }
+        }
+        return false;
+    }
+
+    // Möller-Trumbore against all four lanes
+    bool MeshBvh::intersectsPacket(const TrianglePacket & packet, const glm::vec3 & origin,
+        const glm::vec3 & direction, float minDistance, float maxDistance) const {
+#ifdef IMPGINE_BVH_SSE
+        const __m128 dx = _mm_set1_ps(direction.x), dy = _mm_set1_ps(direction.y), dz = _mm_set1_ps(direction.z);
+        const __m128 e1x = _mm_load_ps(packet.edge1[0]), e1y = _mm_load_ps(packet.edge1[1]), e1z = _mm_load_ps(packet.edge1[2]);
+        const __m128 e2x = _mm_load_ps(packet.edge2[0]), e2y = _mm_load_ps(packet.edge2[1]), e2z = _mm_load_ps(packet.edge2[2]);
+
+        // p = direction x edge2
+        __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+        __m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+        __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+        __m128 determinant = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+        __m128 absDeterminant = _mm_andnot_ps(_mm_set1_ps(-0.0f), determinant);
+        __m128 valid = _mm_cmpgt_ps(absDeterminant, _mm_set1_ps(DETERMINANT_EPSILON));
+        if (_mm_movemask_ps(valid) == 0) {
+            return false;
+        }
+        __m128 inverse = _mm_div_ps(_mm_set1_ps(1.0f), determinant);
+
+        // s = origin - v0
+        __m128 sx = _mm_sub_ps(_mm_set1_ps(origin.x), _mm_load_ps(packet.v0[0]));
+        __m128 sy = _mm_sub_ps(_mm_set1_ps(origin.y), _mm_load_ps(packet.v0[1]));
+        __m128 sz = _mm_sub_ps(_mm_set1_ps(origin.z), _mm_load_ps(packet.v0[2]));
+        __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), inverse);
+
+        // q = s x edge1
+        __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+        __m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+        __m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+        __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), inverse);
+        __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inverse);
+
+        const __m128 zero = _mm_setzero_ps();
+        valid = _mm_and_ps(valid, _mm_cmpge_ps(u, zero));
+        valid = _mm_and_ps(valid, _mm_cmpge_ps(v, zero));
+        valid = _mm_and_ps(valid, _mm_cmple_ps(_mm_add_ps(u, v), _mm_set1_ps(1.0f)));
+        valid = _mm_and_ps(valid, _mm_cmpgt_ps(t, _mm_set1_ps(minDistance)));
+        valid = _mm_and_ps(valid, _mm_cmplt_ps(t, _mm_set1_ps(maxDistance)));
+        return _mm_movemask_ps(valid) != 0;
+#else
+        for (uint32_t lane = 0; lane < LEAF_SIZE; lane++) {
+            glm::vec3 edge1(packet.edge1[0][lane], packet.edge1[1][lane], packet.edge1[2][lane]);
+            glm::vec3 edge2(packet.edge2[0][lane], packet.edge2[1][lane], packet.edge2[2][lane]);
+            glm::vec3 p = glm::cross(direction, edge2);
+            float determinant = glm::dot(edge1, p);
+            if (!(std::abs(determinant) > DETERMINANT_EPSILON)) {
+                continue;
+            }
+            float inverse = 1.0f / determinant;
+            glm::vec3 s = origin - glm::vec3(packet.v0[0][lane], packet.v0[1][lane], packet.v0[2][lane]);
+            float u = glm::dot(s, p) * inverse;
+            glm::vec3 q = glm::cross(s, edge1);
+            float v = glm::dot(direction, q) * inverse;
+            float t = glm::dot(edge2, q) * inverse;
+            if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t > minDistance && t < maxDistance) {
+                return true;
+            }
+        }
+        return false;
+#endif
+    }
+
+} // namespace impgine
\ No newline at end of file
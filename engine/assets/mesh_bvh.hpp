@@ -0,0 +1,59 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#define GLM_FORCE_DEFAULT_ALIGNED_GENTYPES
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace impgine {
+
+    // Bounding volume hierarchy over a triangle mesh for CPU ray queries. Each
+    // leaf holds up to four triangles in structure-of-arrays form, so one ray
+    // is tested against all of them at once with SSE (scalar elsewhere).
+    // Immutable after construction, so any number of threads can query it
+    class MeshBvh {
+        public: static constexpr uint32_t LEAF_SIZE = 4;
+
+        MeshBvh(const std::vector < glm::vec3 > & positions, const std::vector < uint32_t > & indices);
+
+        // Whether anything lies along the ray between minDistance and maxDistance;
+        // stops at the first hit. `direction` need not be normalized, distances
+        // are in units of its length
+        bool occluded(const glm::vec3 & origin, const glm::vec3 & direction, float minDistance,
+            float maxDistance) const;
+
+        size_t getNodeCount() const {
+            return nodes.size();
+        }
+
+        private: struct Node {
+            glm::vec3 boundsMin;
+            glm::vec3 boundsMax;
+            // Second child or, in a leaf, the packet index. Nodes are stored in
+            // depth-first order, so the first child always directly follows its parent
+            uint32_t index;
+            uint32_t isLeaf;
+        };
+
+        // Four triangles as v0 and the edges to v1 and v2; unused lanes have
+        // zero edges, which the intersection test rejects
+        struct alignas(16) TrianglePacket {
+            float v0[3][LEAF_SIZE];
+            float edge1[3][LEAF_SIZE];
+            float edge2[3][LEAF_SIZE];
+        };
+
+        uint32_t build(std::vector < uint32_t > & triangles, size_t begin, size_t end,
+            const std::vector < glm::vec3 > & centroids, const std::vector < glm::vec3 > & positions,
+                const std::vector < uint32_t > & indices);
+        bool intersectsPacket(const TrianglePacket & packet, const glm::vec3 & origin, const glm::vec3 & direction,
+            float minDistance, float maxDistance) const;
+
+        std::vector < Node > nodes;
+        std::vector < TrianglePacket > packets;
+    };
+
+} // namespace impgine
\ No newline at end of file
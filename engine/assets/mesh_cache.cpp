@@ -0,0 +1,188 @@
+#include "mesh_cache.hpp"
+
+#include "../benchmark/frame_capture.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace impgine {
+
+    namespace {
+
+        constexpr char MAGIC[8] = {
+            'I', 'M', 'P', 'M', 'E', 'S', 'H', '\0'
+        };
+        // Bump whenever what loadObjMesh produces changes for the same input
+        constexpr uint32_t FORMAT_VERSION = 2;
+        // Material names and texture paths; anything longer means a corrupt file
+        constexpr uint32_t MAX_STRING_SIZE = 4096;
+
+        struct CacheHeader {
+            char magic[8];
+            uint32_t version;
+            uint32_t vertexSize;
+            uint64_t key;
+            uint64_t vertexCount;
+            uint64_t indexCount;
+            uint64_t materialCount;
+            uint64_t rangeCount;
+        };
+
+        void writeString(std::ostream & out, const std::string & value) {
+            uint32_t size = static_cast < uint32_t > (value.size());
+            out.write(reinterpret_cast < const char * > ( & size), sizeof(size));
+            out.write(value.data(), size);
+        }
+
+        bool readString(std::istream & in, std::string & value) {
+            uint32_t size = 0;
+            if (!in.read(reinterpret_cast < char * > ( & size), sizeof(size)) || size > MAX_STRING_SIZE) {
+                return false;
+            }
+            value.resize(size);
+            return static_cast < bool > (in.read( & value[0], size));
+        }
+
+        uint64_t cacheKey(const std::string & filepath, const MeshLoadOptions & options) {
+            uint64_t key = FrameCapture::hashFile(filepath);
+            // The MTL files are as much part of the result as the OBJ; these are
+            // exactly the ones loadObjMesh reads, so a missing one is left out of both
+            for (const std::string & library: objMaterialLibraries(filepath)) {
+                key = FrameCapture::hashBytes(library.data(), library.size(), key);
+                uint64_t contents = FrameCapture::hashFile(library);
+                key = FrameCapture::hashBytes( & contents, sizeof(contents), key);
+            }
+            // Field by field; the struct's padding is indeterminate
+            key = FrameCapture::hashBytes( & options.generateNormals, sizeof(options.generateNormals), key);
+            key = FrameCapture::hashBytes( & options.normalWeighting, sizeof(options.normalWeighting), key);
+            key = FrameCapture::hashBytes( & options.creaseAngle, sizeof(options.creaseAngle), key);
+            key = FrameCapture::hashBytes( & options.bakeOcclusion, sizeof(options.bakeOcclusion), key);
+            if (options.bakeOcclusion) {
+                key = FrameCapture::hashBytes( & options.occlusion.samples, sizeof(options.occlusion.samples), key);
+                key = FrameCapture::hashBytes( & options.occlusion.maxDistance, sizeof(options.occlusion.maxDistance), key);
+            }
+            return key;
+        }
+
+        bool readCache(const std::string & cachePath, uint64_t key, MeshData & mesh) {
+            std::ifstream file(cachePath, std::ios::binary);
+            if (!file) {
+                return false;
+            }
+
+            CacheHeader header {};
+            if (!file.read(reinterpret_cast < char * > ( & header), sizeof(header)) ||
+                std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != FORMAT_VERSION ||
+                header.vertexSize != sizeof(Vertex) || header.key != key || header.indexCount % 3 != 0 ||
+                header.materialCount > header.indexCount / 3 + 1 || header.rangeCount > header.materialCount) {
+                return false;
+            }
+
+            // The counts have to fit in what's left of the file before anything is
+            // sized from them, or a corrupt header would allocate instead of missing
+            std::streamoff offset = file.tellg();
+            file.seekg(0, std::ios::end);
+            uint64_t remaining = static_cast < uint64_t > (file.tellg() - offset);
+            file.seekg(offset);
+            if (header.vertexCount > remaining / sizeof(Vertex) ||
+                header.indexCount > (remaining - header.vertexCount * sizeof(Vertex)) / sizeof(uint32_t)) {
+                return false;
+            }
+
+            mesh.vertices.resize(header.vertexCount);
+            mesh.indices.resize(header.indexCount);
+            if (!file.read(reinterpret_cast < char * > (mesh.vertices.data()), sizeof(Vertex) * header.vertexCount) ||
+                !file.read(reinterpret_cast < char * > (mesh.indices.data()), sizeof(uint32_t) * header.indexCount)) {
+                return false;
+            }
+            for (uint32_t index: mesh.indices) {
+                if (index >= header.vertexCount) {
+                    return false;
+                }
+            }
+
+            mesh.materials.resize(header.materialCount);
+            for (Material & material: mesh.materials) {
+                if (!readString(file, material.name) ||
+                    !file.read(reinterpret_cast < char * > ( & material.diffuseColor), sizeof(material.diffuseColor)) ||
+                    !readString(file, material.diffuseTexture)) {
+                    return false;
+                }
+            }
+            mesh.ranges.resize(header.rangeCount);
+            if (!file.read(reinterpret_cast < char * > (mesh.ranges.data()), sizeof(MeshRange) * header.rangeCount)) {
+                return false;
+            }
+            for (const MeshRange & range: mesh.ranges) {
+                if (range.materialIndex >= header.materialCount || range.firstIndex > header.indexCount ||
+                    range.indexCount > header.indexCount - range.firstIndex) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool writeCache(const std::string & cachePath, uint64_t key, const MeshData & mesh) {
+            // Written aside and renamed over, so an interrupted write never leaves a torn cache
+            std::string temporaryPath = cachePath + ".tmp";
+            {
+                std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+                if (!file) {
+                    return false;
+                }
+
+                CacheHeader header {};
+                std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+                header.version = FORMAT_VERSION;
+                header.vertexSize = sizeof(Vertex);
+                header.key = key;
+                header.vertexCount = mesh.vertices.size();
+                header.indexCount = mesh.indices.size();
+                header.materialCount = mesh.materials.size();
+                header.rangeCount = mesh.ranges.size();
+                file.write(reinterpret_cast < const char * > ( & header), sizeof(header));
+                file.write(reinterpret_cast < const char * > (mesh.vertices.data()), sizeof(Vertex) * mesh.vertices.size());
+                file.write(reinterpret_cast < const char * > (mesh.indices.data()), sizeof(uint32_t) * mesh.indices.size());
+                for (const Material & material: mesh.materials) {
+                    writeString(file, material.name);
+                    file.write(reinterpret_cast < const char * > ( & material.diffuseColor), sizeof(material.diffuseColor));
+                    writeString(file, material.diffuseTexture);
+                }
+                file.write(reinterpret_cast < const char * > (mesh.ranges.data()), sizeof(MeshRange) * mesh.ranges.size());
+                if (!file.flush()) {
+                    return false;
+                }
+            }
+            std::remove(cachePath.c_str());
+            return std::rename(temporaryPath.c_str(), cachePath.c_str()) == 0;
+        }
+
+    } // namespace
+
+    MeshData loadCachedMesh(const std::string & filepath, const MeshLoadOptions & options, JobSystem * jobs) {
+        auto start = std::chrono::steady_clock::now();
+        std::string cachePath = filepath + ".meshcache";
+        uint64_t key = cacheKey(filepath, options);
+
+        MeshData mesh;
+        if (readCache(cachePath, key, mesh)) {
+            mesh.stats.fromCache = true;
+            mesh.stats.triangles = mesh.indices.size() / 3;
+            mesh.stats.vertices = mesh.vertices.size();
+            mesh.stats.materials = mesh.materials.size();
+            mesh.stats.cacheSeconds = std::chrono::duration < double > (std::chrono::steady_clock::now() - start).count();
+            return mesh;
+        }
+
+        mesh = loadObjMesh(filepath, options, jobs);
+        if (!writeCache(cachePath, key, mesh)) {
+            std::cerr << "Failed to write the mesh cache " << cachePath << std::endl;
+        }
+        return mesh;
+    }
+
+} // namespace impgine
\ No newline at end of file
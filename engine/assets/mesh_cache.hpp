@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+
+#include "model_loader.hpp"
+
+namespace impgine {
+
+    // Like loadObjMesh, but keeps the finished mesh, with its generated normals,
+    // tangents, baked occlusion and materials, in "<filepath>.meshcache". The
+    // cache is keyed on the contents of the OBJ and its MTL libraries, the load
+    // options and the vertex layout, and rewritten whenever any of them changes. Failing to write it only warns
+    MeshData loadCachedMesh(const std::string & filepath, const MeshLoadOptions & options = {},
+        JobSystem * jobs = nullptr);
+
+} // namespace impgine
\ No newline at end of file
@@ -0,0 +1,303 @@
+#define TINYOBJLOADER_IMPLEMENTATION
+#include "model_loader.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <tiny_obj_loader.h>
+
+namespace impgine {
+
+    namespace {
+
+        using Clock = std::chrono::steady_clock;
+
+        double secondsSince(Clock::time_point start) {
+            return std::chrono::duration < double > (Clock::now() - start).count();
+        }
+
+        std::string directoryOf(const std::string & filepath) {
+            size_t separator = filepath.find_last_of("/\\");
+            return separator == std::string::npos ? std::string() : filepath.substr(0, separator + 1);
+        }
+
+        Material convertMaterial(const tinyobj::material_t & source, const std::string & baseDirectory) {
+            Material material;
+            material.name = source.name;
+            material.diffuseColor = {
+                source.diffuse[0],
+                source.diffuse[1],
+                source.diffuse[2]
+            };
+            if (!source.diffuse_texname.empty()) {
+                std::string texture = source.diffuse_texname;
+                std::replace(texture.begin(), texture.end(), '\\', '/');
+                material.diffuseTexture = texture.front() == '/' ? texture : baseDirectory + texture;
+                // tinyobj can't tell a missing Kd from black; a black textured material is the less likely one
+                if (material.diffuseColor == glm::vec3(0.0f)) {
+                    material.diffuseColor = glm::vec3(1.0f);
+                }
+            }
+            return material;
+        }
+
+        // LoadObj's choice of MTL files: per mtllib line, the first file that
+        // exists and wasn't loaded already
+        template < typename Visit >
+            void forEachMaterialLibrary(const std::string & filepath, Visit visit) {
+                std::string baseDirectory = directoryOf(filepath);
+                std::set < std::string > loaded;
+                std::ifstream file(filepath);
+                std::string line;
+                while (std::getline(file, line)) {
+                    size_t start = line.find_first_not_of(" \t");
+                    if (start == std::string::npos || line.compare(start, 6, "mtllib") != 0 || start + 7 > line.size() ||
+                        (line[start + 6] != ' ' && line[start + 6] != '\t')) {
+                        continue;
+                    }
+                    if (line.back() == '\r') {
+                        line.pop_back();
+                    }
+                    std::vector < std::string > filenames;
+                    tinyobj::SplitString(line.substr(start + 7), ' ', '\\', filenames);
+                    for (const std::string & filename: filenames) {
+                        if (loaded.count(filename) > 0) {
+                            continue;
+                        }
+                        std::string path = baseDirectory + filename;
+                        if (std::ifstream(path)) {
+                            loaded.insert(filename);
+                            visit(path);
+                            break;
+                        }
+                    }
+                }
+            }
+
+    } // namespace
+
+    void MeshLoadStats::report(std::ostream & out) const {
+        if (fromCache) {
+            out << "Mesh load: " << triangles << " triangles, " << vertices << " vertices from the mesh cache in " <<
+                cacheSeconds * 1000.0 << " ms" << std::endl;
+            return;
+        }
+        out << "Mesh load: " << triangles << " triangles, " << vertices << " vertices, " << materials <<
+            " materials, " << (importedNormals ? "imported" : "generated") << " normals\n";
+        out << "  parse      " << parseSeconds * 1000.0 << " ms\n";
+        out << "  adjacency  " << adjacencySeconds * 1000.0 << " ms\n";
+        out << "  normals    " << normalsSeconds * 1000.0 << " ms\n";
+        out << "  tangents   " << tangentsSeconds * 1000.0 << " ms\n";
+        out << "  dedup      " << dedupSeconds * 1000.0 << " ms\n";
+        out << "  occlusion  " << occlusionSeconds * 1000.0 << " ms" << std::endl;
+    }
+
+    MeshData loadObjMesh(const std::string & filepath, const MeshLoadOptions & options, JobSystem * jobs) {
+        MeshData mesh;
+        Clock::time_point stageStart = Clock::now();
+
+        tinyobj::attrib_t attrib;
+        std::vector < tinyobj::shape_t > shapes;
+        std::vector < tinyobj::material_t > materials;
+        std::string warn, err;
+
+        std::string baseDirectory = directoryOf(filepath);
+        if (!tinyobj::LoadObj( & attrib, & shapes, & materials, & warn, & err, filepath.c_str(), baseDirectory.c_str())) {
+            throw std::runtime_error(err);
+        }
+
+        // Faces without a (known) material share an unnamed one, added only if used
+        for (const auto & material: materials) {
+            mesh.materials.push_back(convertMaterial(material, baseDirectory));
+        }
+        uint32_t unnamedMaterial = static_cast < uint32_t > (mesh.materials.size());
+
+        // Flatten the shapes into triangle corners; LoadObj triangulates
+        TriangleCorners corners;
+        size_t positionCount = attrib.vertices.size() / 3;
+        corners.positions.resize(positionCount);
+        for (size_t i = 0; i < positionCount; i++) {
+            corners.positions[i] = {
+                attrib.vertices[3 * i + 0],
+                attrib.vertices[3 * i + 1],
+                attrib.vertices[3 * i + 2]
+            };
+        }
+
+        size_t cornerCount = 0;
+        for (const auto & shape: shapes) {
+            cornerCount += shape.mesh.indices.size();
+        }
+        corners.positionIndices.reserve(cornerCount);
+        corners.texCoords.reserve(cornerCount);
+        std::vector < uint32_t > triangleMaterials;
+        triangleMaterials.reserve(cornerCount / 3);
+
+        // A file with normals on only some corners gets all of them generated
+        bool importNormals = !options.generateNormals && !attrib.normals.empty();
+        std::vector < glm::vec3 > normals;
+        if (importNormals) {
+            normals.reserve(cornerCount);
+        }
+
+        for (const auto & shape: shapes) {
+            for (size_t face = 0; face < shape.mesh.indices.size() / 3; face++) {
+                int material = face < shape.mesh.material_ids.size() ? shape.mesh.material_ids[face] : -1;
+                triangleMaterials.push_back(material >= 0 && static_cast < size_t > (material) < materials.size() ?
+                    static_cast < uint32_t > (material) : unnamedMaterial);
+            }
+            for (const auto & index: shape.mesh.indices) {
+                if (index.vertex_index < 0 || static_cast < size_t > (index.vertex_index) >= positionCount) {
+                    throw std::runtime_error("invalid vertex index in " + filepath);
+                }
+                corners.positionIndices.push_back(static_cast < uint32_t > (index.vertex_index));
+
+                if (index.texcoord_index >= 0 && static_cast < size_t > (index.texcoord_index) < attrib.texcoords.size() / 2) {
+                    corners.texCoords.push_back({
+                        attrib.texcoords[2 * index.texcoord_index + 0],
+                        attrib.texcoords[2 * index.texcoord_index + 1]
+                    });
+                } else {
+                    corners.texCoords.push_back({
+                        0.0f,
+                        0.0f
+                    });
+                }
+
+                if (importNormals) {
+                    glm::vec3 normal(0.0f);
+                    if (index.normal_index >= 0 && static_cast < size_t > (index.normal_index) < attrib.normals.size() / 3) {
+                        normal = {
+                            attrib.normals[3 * index.normal_index + 0],
+                            attrib.normals[3 * index.normal_index + 1],
+                            attrib.normals[3 * index.normal_index + 2]
+                        };
+                    }
+                    float length = glm::length(normal);
+                    if (length > 0.0f) {
+                        normals.push_back(normal / length);
+                    } else {
+                        importNormals = false;
+                    }
+                }
+            }
+        }
+        corners.positionIndices.resize(cornerCount / 3 * 3);
+        corners.texCoords.resize(corners.positionIndices.size());
+        mesh.stats.triangles = corners.positionIndices.size() / 3;
+        mesh.stats.parseSeconds = secondsSince(stageStart);
+
+        stageStart = Clock::now();
+        CornerAdjacency adjacency = buildCornerAdjacency(corners, jobs);
+        mesh.stats.adjacencySeconds = secondsSince(stageStart);
+
+        stageStart = Clock::now();
+        mesh.stats.importedNormals = importNormals;
+        if (importNormals) {
+            normals.resize(corners.positionIndices.size());
+        } else {
+            normals = generateNormals(corners, adjacency, options.normalWeighting, options.creaseAngle, jobs);
+        }
+        mesh.stats.normalsSeconds = secondsSince(stageStart);
+
+        stageStart = Clock::now();
+        std::vector < glm::vec4 > tangents = generateTangents(corners, adjacency, normals, jobs);
+        mesh.stats.tangentsSeconds = secondsSince(stageStart);
+
+        // Normal and tangent are part of the key, so hard edges and UV seams
+        // keep their own vertices
+        stageStart = Clock::now();
+        std::unordered_map < Vertex, uint32_t > uniqueVertices {};
+        uniqueVertices.reserve(corners.positionIndices.size());
+        mesh.indices.reserve(corners.positionIndices.size());
+
+        for (size_t corner = 0; corner < corners.positionIndices.size(); corner++) {
+            Vertex vertex {};
+            vertex.pos = corners.positions[corners.positionIndices[corner]];
+            vertex.color = {
+                1.0f,
+                1.0f,
+                1.0f
+            };
+            vertex.texCoord = {
+                corners.texCoords[corner].x,
+                1.0f - corners.texCoords[corner].y
+            };
+            vertex.normal = normals[corner];
+            vertex.tangent = tangents[corner];
+
+            auto inserted = uniqueVertices.emplace(vertex, static_cast < uint32_t > (mesh.vertices.size()));
+            if (inserted.second) {
+                mesh.vertices.push_back(vertex);
+            }
+            mesh.indices.push_back(inserted.first -> second);
+        }
+        mesh.stats.vertices = mesh.vertices.size();
+
+        // Counting sort of the triangles by material, stable so each range keeps the file's order
+        triangleMaterials.resize(mesh.stats.triangles);
+        if (std::find(triangleMaterials.begin(), triangleMaterials.end(), unnamedMaterial) != triangleMaterials.end()) {
+            mesh.materials.push_back(Material {});
+        }
+        std::vector < uint32_t > materialOffsets(mesh.materials.size() + 1, 0);
+        for (uint32_t material: triangleMaterials) {
+            materialOffsets[material + 1] += 3;
+        }
+        for (size_t material = 0; material < mesh.materials.size(); material++) {
+            if (materialOffsets[material + 1] > 0) {
+                mesh.ranges.push_back({
+                    materialOffsets[material], materialOffsets[material + 1], static_cast < uint32_t > (material)
+                });
+            }
+            materialOffsets[material + 1] += materialOffsets[material];
+        }
+        std::vector < uint32_t > sortedIndices(mesh.indices.size());
+        for (size_t triangle = 0; triangle < triangleMaterials.size(); triangle++) {
+            uint32_t & cursor = materialOffsets[triangleMaterials[triangle]];
+            std::copy_n(mesh.indices.begin() + 3 * triangle, 3, sortedIndices.begin() + cursor);
+            cursor += 3;
+        }
+        mesh.indices = std::move(sortedIndices);
+        mesh.stats.materials = mesh.materials.size();
+        mesh.stats.dedupSeconds = secondsSince(stageStart);
+
+        if (options.bakeOcclusion) {
+            stageStart = Clock::now();
+            bakeVertexOcclusion(mesh.vertices, mesh.indices, options.occlusion, jobs);
+            mesh.stats.occlusionSeconds = secondsSince(stageStart);
+        }
+
+        return mesh;
+    }
+
+    std::vector < std::string > objMaterialLibraries(const std::string & filepath) {
+        std::vector < std::string > libraries;
+        forEachMaterialLibrary(filepath, [ & ](const std::string & library) {
+            libraries.push_back(library);
+        });
+        return libraries;
+    }
+
+    std::vector < Material > loadObjMaterials(const std::string & filepath) {
+        std::string baseDirectory = directoryOf(filepath);
+        std::vector < tinyobj::material_t > materials;
+        std::map < std::string, int > materialMap;
+        forEachMaterialLibrary(filepath, [ & ](const std::string & library) {
+            std::ifstream file(library);
+            std::string warn, err;
+            tinyobj::LoadMtl( & materialMap, & materials, & file, & warn, & err);
+        });
+
+        std::vector < Material > converted;
+        for (const auto & material: materials) {
+            converted.push_back(convertMaterial(material, baseDirectory));
+        }
+        return converted;
+    }
+
+} // namespace impgine
\ No newline at end of file
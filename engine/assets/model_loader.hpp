@@ -0,0 +1,78 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#define GLM_FORCE_DEFAULT_ALIGNED_GENTYPES
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "../backend/pipeline.hpp"
+#include "material.hpp"
+#include "mesh_attributes.hpp"
+#include "occlusion_bake.hpp"
+
+namespace impgine {
+
+    class JobSystem;
+
+    struct MeshLoadOptions {
+        // Ignore the file's normals and always generate them
+        bool generateNormals = false;
+        NormalWeighting normalWeighting = NormalWeighting::Angle;
+        // Faces meeting at a sharper angle than this (radians) get a hard edge
+        float creaseAngle = glm::radians(60.0f);
+        // Ambient occlusion baked into the vertex colors, which stay white otherwise
+        bool bakeOcclusion = false;
+        OcclusionBakeOptions occlusion;
+    };
+
+    // Wall-clock time of each load stage
+    struct MeshLoadStats {
+        size_t triangles = 0;
+        size_t vertices = 0;
+        size_t materials = 0;
+        bool importedNormals = false;
+        // Read back from the mesh cache; only cacheSeconds is set then
+        bool fromCache = false;
+        double cacheSeconds = 0.0;
+        double parseSeconds = 0.0;
+        double adjacencySeconds = 0.0;
+        double normalsSeconds = 0.0;
+        double tangentsSeconds = 0.0;
+        double dedupSeconds = 0.0;
+        double occlusionSeconds = 0.0;
+
+        void report(std::ostream & out) const;
+    };
+
+    struct MeshData {
+        std::vector < Vertex > vertices;
+        std::vector < uint32_t > indices;
+        std::vector < Material > materials;
+        // Cover all indices, one range per material in use, in material order
+        std::vector < MeshRange > ranges;
+        MeshLoadStats stats;
+    };
+
+    // Parses a Wavefront OBJ and its MTL libraries into one indexed mesh,
+    // merging identical vertices and sorting the triangles by material.
+    // Normals come from the file when every corner has one and are generated
+    // otherwise; tangents are always generated, occlusion on request. These
+    // run on `jobs` when given.
+    // Touches no Vulkan state, so it is safe to call from any thread
+    MeshData loadObjMesh(const std::string & filepath, const MeshLoadOptions & options = {},
+        JobSystem * jobs = nullptr);
+
+    // The MTL files loadObjMesh reads for the OBJ: per mtllib line, the first
+    // of its files that exists
+    std::vector < std::string > objMaterialLibraries(const std::string & filepath);
+
+    // The materials loadObjMesh lists first, read from the MTL files alone.
+    // Only scans the OBJ for mtllib lines, so it's cheap next to a full load
+    std::vector < Material > loadObjMaterials(const std::string & filepath);
+
+} // namespace impgine
\ No newline at end of file
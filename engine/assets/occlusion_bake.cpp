@@ -0,0 +1,109 @@
+#include "occlusion_bake.hpp"
+
+#include "../core/job_system.hpp"
+#include "mesh_bvh.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+namespace impgine {
+
+    namespace {
+
+        constexpr size_t VERTEX_GRAIN = 256;
+        constexpr float TWO_PI = 6.28318530718f;
+        // Ray origins are pushed off the surface by this fraction of the diagonal
+        constexpr float SURFACE_OFFSET = 1e-4f;
+
+        uint64_t splitMix64(uint64_t value) {
+            value += 0x9e3779b97f4a7c15ull;
+            value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+            value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+            return value ^ (value >> 31);
+        }
+
+        // Van der Corput radical inverse in base 2
+        float radicalInverse(uint32_t bits) {
+            bits = (bits << 16u) | (bits >> 16u);
+            bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+            bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+            bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+            bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+            return static_cast < float > (bits) * 2.3283064365386963e-10f;
+        }
+
+        float fraction(float value) {
+            return value - std::floor(value);
+        }
+
+    } // namespace
+
+    void bakeVertexOcclusion(std::vector < Vertex > & vertices, const std::vector < uint32_t > & indices,
+        const OcclusionBakeOptions & options, JobSystem * jobs) {
+        if (vertices.empty() || options.samples == 0) {
+            return;
+        }
+
+        std::vector < glm::vec3 > positions(vertices.size());
+        glm::vec3 boundsMin(std::numeric_limits < float > ::max());
+        glm::vec3 boundsMax(std::numeric_limits < float > ::lowest());
+        for (size_t i = 0; i < vertices.size(); i++) {
+            positions[i] = vertices[i].pos;
+            boundsMin = glm::min(boundsMin, positions[i]);
+            boundsMax = glm::max(boundsMax, positions[i]);
+        }
+        MeshBvh bvh(positions, indices);
+
+        float diagonal = glm::length(boundsMax - boundsMin);
+        float offset = diagonal * SURFACE_OFFSET;
+        float maxDistance = diagonal * options.maxDistance;
+
+        auto bake = [ & ](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                Vertex & vertex = vertices[i];
+                float normalLength = glm::length(vertex.normal);
+                if (!(normalLength > 0.0f)) {
+                    vertex.color = glm::vec3(1.0f);
+                    continue;
+                }
+                glm::vec3 normal = vertex.normal / normalLength;
+                glm::vec3 axis = std::abs(normal.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+                glm::vec3 tangent = glm::normalize(glm::cross(axis, normal));
+                glm::vec3 bitangent = glm::cross(normal, tangent);
+
+                // Hammersley points, rotated per vertex so the banding of a fixed
+                // pattern turns into noise that neighbouring vertices average out
+                uint64_t seed = splitMix64(std::hash < glm::vec3 > ()(vertex.pos) ^
+                    (std::hash < glm::vec3 > ()(normal) << 1));
+                float rotationU = static_cast < float > (seed & 0xffffffu) / 16777216.0f;
+                float rotationV = static_cast < float > ((seed >> 24) & 0xffffffu) / 16777216.0f;
+
+                glm::vec3 origin = vertex.pos + normal * offset;
+                uint32_t escaped = 0;
+                for (uint32_t sample = 0; sample < options.samples; sample++) {
+                    float u = fraction((static_cast < float > (sample) + 0.5f) / static_cast < float > (options.samples) + rotationU);
+                    float v = fraction(radicalInverse(sample) + rotationV);
+
+                    // Cosine-weighted, so the average is the occlusion a diffuse surface sees
+                    float radius = std::sqrt(u);
+                    float phi = TWO_PI * v;
+                    glm::vec3 direction = tangent * (radius * std::cos(phi)) + bitangent * (radius * std::sin(phi)) +
+                        normal * std::sqrt(std::max(0.0f, 1.0f - u));
+                    if (!bvh.occluded(origin, direction, offset, maxDistance)) {
+                        escaped++;
+                    }
+                }
+                vertex.color = glm::vec3(static_cast < float > (escaped) / static_cast < float > (options.samples));
+            }
+        };
+
+        if (jobs) {
+            jobs -> parallelFor(0, vertices.size(), VERTEX_GRAIN, bake);
+        } else {
+            bake(0, vertices.size());
+        }
+    }
+
+} // namespace impgine
\ No newline at end of file
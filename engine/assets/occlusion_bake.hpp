@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "../backend/pipeline.hpp"
+
+namespace impgine {
+
+    class JobSystem;
+
+    struct OcclusionBakeOptions {
+        // Rays per vertex
+        uint32_t samples = 64;
+        // Rays stop after this fraction of the mesh's bounding box diagonal, so
+        // only nearby geometry darkens a vertex and open scenes stay lit
+        float maxDistance = 0.05f;
+    };
+
+    // Per-vertex ambient occlusion: the fraction of cosine-weighted rays over
+    // the normal's hemisphere that escape the mesh, cast against a MeshBvh and
+    // written as grey into each vertex color. Vertices with equal position and
+    // normal get the same sample pattern, so UV seams don't show. Runs vertex
+    // chunks on `jobs` when given
+    void bakeVertexOcclusion(std::vector < Vertex > & vertices, const std::vector < uint32_t > & indices,
+        const OcclusionBakeOptions & options, JobSystem * jobs);
+
+} // namespace impgine
\ No newline at end of file
@@ -0,0 +1,68 @@
+#include "texture_cache.hpp"
+
+#include "../benchmark/frame_capture.hpp"
+#include "ktx2.hpp"
+#include "texture_decode.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace impgine {
+
+    namespace {
+
+        // Bump whenever the encoder produces different blocks for the same input
+        constexpr uint32_t ENCODER_VERSION = 1;
+        constexpr const char * SOURCE_KEY = "impgine.source";
+
+        // The source's contents and the encoder version, as the cache's key/value entry
+        std::string sourceKey(const std::string & source) {
+            std::ostringstream key;
+            key << std::hex << FrameCapture::hashFile(source) << " " << std::dec << ENCODER_VERSION;
+            return key.str();
+        }
+
+    } // namespace
+
+    std::string compressedTexturePath(const std::string & source, BlockFormat format) {
+        return source + "." + blockFormatName(format) + ".ktx2";
+    }
+
+    bool loadCompressedTexture(const std::string & source, BlockFormat format, uint32_t width, uint32_t height,
+        uint8_t * destination, JobSystem * jobs) {
+        std::string cachePath = compressedTexturePath(source, format);
+        Ktx2Image image;
+        image.format = format;
+        image.width = width;
+        image.height = height;
+        image.keyValues.emplace_back(SOURCE_KEY, sourceKey(source));
+        if (readKtx2(cachePath, image, destination)) {
+            return true;
+        }
+
+        // Compressed into ordinary memory: `destination` is usually a mapped,
+        // uncached staging buffer, where the encoder's small writes and the
+        // cache write's reads would each be slow. It gets one copy at the end
+        std::vector < uint8_t > pixels(decodeBufferSize(width, height));
+        decodeTextureInto(source, pixels.data(), width, height);
+        std::vector < uint8_t > chain(compressedMipChainSize(format, width, height));
+        compressMipChain(pixels.data(), width, height, format, chain.data(), jobs);
+
+        // Written aside and renamed over, so an interrupted write never leaves a torn cache
+        image.keyValues.emplace_back("KTXwriter", "impgine");
+        std::string temporaryPath = cachePath + ".tmp";
+        bool written = writeKtx2(temporaryPath, image, chain.data());
+        if (written) {
+            std::remove(cachePath.c_str());
+        }
+        if (!written || std::rename(temporaryPath.c_str(), cachePath.c_str()) != 0) {
+            std::cerr << "Failed to write the texture cache " << cachePath << std::endl;
+        }
+        std::memcpy(destination, chain.data(), chain.size());
+        return false;
+    }
+
+} // namespace impgine
\ No newline at end of file
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+
+#include "block_compression.hpp"
+
+namespace impgine {
+
+    // Where the compressed chain of `source` is cached: "<source>.<format>.ktx2"
+    std::string compressedTexturePath(const std::string & source, BlockFormat format);
+
+    // Fills `destination` (compressedMipChainSize bytes) with the block-compressed
+    // mip chain of the image at `source`, width x height as readTextureSize
+    // reported. The chain is read from the KTX2 cache when that was written for
+    // the same source contents and encoder version; otherwise the image is
+    // decoded, compressed over `jobs` and the cache rewritten. Failing to write
+    // the cache only warns. Returns whether the cache was used
+    bool loadCompressedTexture(const std::string & source, BlockFormat format, uint32_t width, uint32_t height,
+        uint8_t * destination, JobSystem * jobs = nullptr);
+
+} // namespace impgine
\ No newline at end of file
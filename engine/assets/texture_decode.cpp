@@ -0,0 +1,110 @@
+#include "texture_decode.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+namespace impgine {
+
+    namespace {
+
+        // Where the decode running on this thread should put its output
+        struct DecodeTarget {
+            void * data = nullptr;
+            size_t pixelBytes = 0;
+            bool handedOut = false;
+        };
+
+        thread_local DecodeTarget * decodeTarget = nullptr;
+
+        bool isTarget(const void * pointer) {
+            return decodeTarget != nullptr && pointer == decodeTarget -> data;
+        }
+
+        void * decodeMalloc(size_t size) {
+            // The first allocation of the output size is the output buffer for
+            // the common formats; JPEG asks for one byte more
+            if (decodeTarget != nullptr && !decodeTarget -> handedOut &&
+                (size == decodeTarget -> pixelBytes || size == decodeTarget -> pixelBytes + 1)) {
+                decodeTarget -> handedOut = true;
+                return decodeTarget -> data;
+            }
+            return malloc(size);
+        }
+
+        void * decodeRealloc(void * pointer, size_t oldSize, size_t newSize) {
+            // The target can't grow; move whatever it held to the heap
+            if (isTarget(pointer)) {
+                void * moved = malloc(newSize);
+                if (moved != nullptr) {
+                    memcpy(moved, pointer, oldSize < newSize ? oldSize : newSize);
+                }
+                return moved;
+            }
+            return realloc(pointer, newSize);
+        }
+
+        void decodeFree(void * pointer) {
+            if (!isTarget(pointer)) {
+                free(pointer);
+            }
+        }
+
+        // Resets the target even when decoding throws
+        class ScopedDecodeTarget {
+            public: explicit ScopedDecodeTarget(DecodeTarget & target) {
+                decodeTarget = & target;
+            }
+            ~ScopedDecodeTarget() {
+                decodeTarget = nullptr;
+            }
+        };
+
+    } // namespace
+
+} // namespace impgine
+
+#define STBI_MALLOC(size) impgine::decodeMalloc(size)
+#define STBI_REALLOC_SIZED(pointer, oldSize, newSize) impgine::decodeRealloc(pointer, oldSize, newSize)
+#define STBI_FREE(pointer) impgine::decodeFree(pointer)
+#define STB_IMAGE_IMPLEMENTATION
+#include "../../external/stb_image.h"
+
+namespace impgine {
+
+    bool readTextureSize(const std::string & path, uint32_t & width, uint32_t & height) {
+        int w, h, channels;
+        if (!stbi_info(path.c_str(), & w, & h, & channels) || w <= 0 || h <= 0) {
+            return false;
+        }
+        width = static_cast < uint32_t > (w);
+        height = static_cast < uint32_t > (h);
+        return true;
+    }
+
+    size_t decodeBufferSize(uint32_t width, uint32_t height) {
+        return static_cast < size_t > (width) * height * 4 + 1;
+    }
+
+    void decodeTextureInto(const std::string & path, void * destination, uint32_t width, uint32_t height) {
+        DecodeTarget target;
+        target.data = destination;
+        target.pixelBytes = static_cast < size_t > (width) * height * 4;
+        ScopedDecodeTarget scope(target);
+
+        int w, h, channels;
+        stbi_uc * pixels = stbi_load(path.c_str(), & w, & h, & channels, STBI_rgb_alpha);
+        if (!pixels) {
+            throw std::runtime_error("failed to decode texture " + path + ": " + stbi_failure_reason());
+        }
+        if (static_cast < uint32_t > (w) != width || static_cast < uint32_t > (h) != height) {
+            stbi_image_free(pixels);
+            throw std::runtime_error("texture " + path + " changed size while loading");
+        }
+        if (pixels != destination) {
+            memcpy(destination, pixels, target.pixelBytes);
+        }
+        stbi_image_free(pixels);
+    }
+
+} // namespace impgine
\ No newline at end of file
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace impgine {
+
+    // Reads only the image header. Returns false when stb_image can't parse the file
+    bool readTextureSize(const std::string & path, uint32_t & width, uint32_t & height);
+
+    // Bytes decodeTextureInto needs for a width x height image: the RGBA8
+    // pixels plus the spare byte stb_image's JPEG decoder allocates
+    size_t decodeBufferSize(uint32_t width, uint32_t height);
+
+    // Decodes `path` as 8-bit RGBA into `destination`, which holds
+    // decodeBufferSize() bytes for the size readTextureSize reported. stb_image's
+    // output allocation on this thread is handed `destination` itself, so
+    // decoding into mapped staging memory needs no extra buffer or copy; the
+    // rare decoder that allocates the output twice falls back to one memcpy.
+    // Safe to call from several threads at once
+    void decodeTextureInto(const std::string & path, void * destination, uint32_t width, uint32_t height);
+
+} // namespace impgine
\ No newline at end of file
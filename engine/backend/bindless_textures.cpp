@@ -0,0 +1,182 @@
+#include "bindless_textures.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+namespace impgine {
+
+    const std::vector < const char * > & BindlessTextures::requiredDeviceExtensions() {
+        // Descriptor indexing is core in 1.2; before that it builds on maintenance3
+        static const std::vector < const char * > extensions = {
+            VK_KHR_MAINTENANCE3_EXTENSION_NAME,
+            VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME
+        };
+        return extensions;
+    }
+
+    uint32_t BindlessTextures::queryCapacity(VkInstance instance, VkPhysicalDevice physicalDevice) {
+        uint32_t extensionCount;
+        vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, & extensionCount, nullptr);
+        std::vector < VkExtensionProperties > availableExtensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, & extensionCount, availableExtensions.data());
+        for (const char * name: requiredDeviceExtensions()) {
+            bool found = std::any_of(availableExtensions.begin(), availableExtensions.end(),
+                [name](const VkExtensionProperties & extension) {
+                    return strcmp(extension.extensionName, name) == 0;
+                });
+            if (!found) {
+                return 0;
+            }
+        }
+
+        auto getFeatures2 = reinterpret_cast < PFN_vkGetPhysicalDeviceFeatures2KHR > (
+            vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceFeatures2KHR"));
+        auto getProperties2 = reinterpret_cast < PFN_vkGetPhysicalDeviceProperties2KHR > (
+            vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceProperties2KHR"));
+        if (getFeatures2 == nullptr || getProperties2 == nullptr) {
+            return 0;
+        }
+
+        VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexingFeatures {};
+        indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+        VkPhysicalDeviceFeatures2KHR features {};
+        features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
+        features.pNext = & indexingFeatures;
+        getFeatures2(physicalDevice, & features);
+
+        // The slot comes from a push constant, so the index is dynamically
+        // uniform and non-uniform indexing isn't needed
+        if (!features.features.shaderSampledImageArrayDynamicIndexing ||
+            !indexingFeatures.runtimeDescriptorArray ||
+            !indexingFeatures.descriptorBindingPartiallyBound ||
+            !indexingFeatures.descriptorBindingSampledImageUpdateAfterBind ||
+            !indexingFeatures.descriptorBindingUpdateUnusedWhilePending) {
+            return 0;
+        }
+
+        VkPhysicalDeviceDescriptorIndexingPropertiesEXT indexingProperties {};
+        indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+        VkPhysicalDeviceProperties2KHR properties {};
+        properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2_KHR;
+        properties.pNext = & indexingProperties;
+        getProperties2(physicalDevice, & properties);
+
+        return std::min({
+            MAX_TEXTURES,
+            indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages,
+            indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages
+        });
+    }
+
+    VkPhysicalDeviceDescriptorIndexingFeaturesEXT BindlessTextures::requiredFeatures() {
+        VkPhysicalDeviceDescriptorIndexingFeaturesEXT features {};
+        features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+        features.runtimeDescriptorArray = VK_TRUE;
+        features.descriptorBindingPartiallyBound = VK_TRUE;
+        features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+        features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+        return features;
+    }
+
+    BindlessTextures::BindlessTextures(VkDevice device, uint32_t capacity, VkSampler sampler): device {
+        device
+    }, capacity {
+        capacity
+    } {
+        if (capacity == 0) {
+            throw std::runtime_error("bindless textures need at least one slot!");
+        }
+
+        // Binding 0 is the shared sampler, binding 1 the images it is combined with in the shader
+        std::array < VkDescriptorSetLayoutBinding, 2 > bindings {};
+        bindings[0].binding = 0;
+        bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+        bindings[0].descriptorCount = 1;
+        bindings[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+        bindings[0].pImmutableSamplers = & sampler;
+        bindings[1].binding = 1;
+        bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        bindings[1].descriptorCount = capacity;
+        bindings[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+        // Unwritten slots are never sampled, and slots fill in while the set is
+        // bound, even by frames still executing that don't read them
+        std::array < VkDescriptorBindingFlagsEXT, 2 > bindingFlags = {
+            0,
+            VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT |
+            VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT
+        };
+        VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsInfo {};
+        bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+        bindingFlagsInfo.bindingCount = static_cast < uint32_t > (bindingFlags.size());
+        bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+
+        VkDescriptorSetLayoutCreateInfo layoutInfo {};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.pNext = & bindingFlagsInfo;
+        layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+        layoutInfo.bindingCount = static_cast < uint32_t > (bindings.size());
+        layoutInfo.pBindings = bindings.data();
+        if (vkCreateDescriptorSetLayout(device, & layoutInfo, nullptr, & descriptorSetLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create bindless texture descriptor set layout!");
+        }
+
+        std::array < VkDescriptorPoolSize, 2 > poolSizes {};
+        poolSizes[0].type = VK_DESCRIPTOR_TYPE_SAMPLER;
+        poolSizes[0].descriptorCount = 1;
+        poolSizes[1].type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        poolSizes[1].descriptorCount = capacity;
+
+        VkDescriptorPoolCreateInfo poolInfo {};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+        poolInfo.poolSizeCount = static_cast < uint32_t > (poolSizes.size());
+        poolInfo.pPoolSizes = poolSizes.data();
+        poolInfo.maxSets = 1;
+        if (vkCreateDescriptorPool(device, & poolInfo, nullptr, & descriptorPool) != VK_SUCCESS) {
+            vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+            throw std::runtime_error("failed to create bindless texture descriptor pool!");
+        }
+
+        VkDescriptorSetAllocateInfo allocInfo {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = descriptorPool;
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = & descriptorSetLayout;
+        if (vkAllocateDescriptorSets(device, & allocInfo, & descriptorSet) != VK_SUCCESS) {
+            vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+            vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+            throw std::runtime_error("failed to allocate the bindless texture descriptor set!");
+        }
+    }
+
+    BindlessTextures::~BindlessTextures() {
+        vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+        vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+    }
+
+    uint32_t BindlessTextures::registerTexture(VkImageView view) {
+        if (textureCount == capacity) {
+            throw std::runtime_error("out of bindless texture slots!");
+        }
+
+        VkDescriptorImageInfo imageInfo {};
+        imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        imageInfo.imageView = view;
+
+        VkWriteDescriptorSet write {};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = descriptorSet;
+        write.dstBinding = 1;
+        write.dstArrayElement = textureCount;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        write.descriptorCount = 1;
+        write.pImageInfo = & imageInfo;
+        vkUpdateDescriptorSets(device, 1, & write, 0, nullptr);
+
+        return textureCount++;
+    }
+
+} // namespace impgine
\ No newline at end of file
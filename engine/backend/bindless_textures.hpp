@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+
+namespace impgine {
+
+    // Every texture of the scene in one sampled-image array, so the main pass
+    // binds a single set per frame and each draw picks its texture through a
+    // push-constant slot index. The array is partially bound and updatable
+    // after binding (VK_EXT_descriptor_indexing): registering a texture only
+    // writes its slot, even while earlier frames that read the set are in flight.
+    //
+    // The main pipeline layout uses the layout as set 3 in place of the
+    // per-texture material sets.
+    class BindlessTextures {
+        public: static constexpr uint32_t MAX_TEXTURES = 4096;
+
+        // Device extensions the array needs on a Vulkan 1.0 device
+        static const std::vector < const char * > & requiredDeviceExtensions();
+
+        // How many slots the device supports, or 0 without descriptor
+        // indexing. The instance must have VK_KHR_get_physical_device_properties2
+        static uint32_t queryCapacity(VkInstance instance, VkPhysicalDevice physicalDevice);
+
+        // The descriptor indexing features to chain into VkDeviceCreateInfo
+        static VkPhysicalDeviceDescriptorIndexingFeaturesEXT requiredFeatures();
+
+        // Every slot samples with `sampler`
+        BindlessTextures(VkDevice device, uint32_t capacity, VkSampler sampler);
+        ~BindlessTextures();
+
+        // Delete copy constructor and assignment operator
+        BindlessTextures(const BindlessTextures & ) = delete;
+        BindlessTextures & operator = (const BindlessTextures & ) = delete;
+
+        VkDescriptorSetLayout getDescriptorSetLayout() const {
+            return descriptorSetLayout;
+        }
+        VkDescriptorSet getDescriptorSet() const {
+            return descriptorSet;
+        }
+        uint32_t getTextureCount() const {
+            return textureCount;
+        }
+
+        // Writes `view` into the next free slot and returns the slot. Frames in
+        // flight never use a fresh slot, so textures can be added mid-run. The
+        // image must already be in SHADER_READ_ONLY_OPTIMAL when it is sampled
+        uint32_t registerTexture(VkImageView view);
+
+        private: VkDevice device;
+        uint32_t capacity;
+        uint32_t textureCount = 0;
+
+        VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+        VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+        VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+    };
+
+} // namespace impgine
\ No newline at end of file
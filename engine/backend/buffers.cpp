@@ -92,7 +92,7 @@ namespace impgine {
         }
     }
 
-    void Buffer::writeToBuffer(void * data, VkDeviceSize size, VkDeviceSize offset) {
+    void Buffer::writeToBuffer(const void * data, VkDeviceSize size, VkDeviceSize offset) {
         assert(mapped && "Cannot copy to unmapped buffer");
 
         if (size == VK_WHOLE_SIZE) {
@@ -130,7 +130,7 @@ namespace impgine {
         };
     }
 
-    void Buffer::writeToIndex(void * data, int index) {
+    void Buffer::writeToIndex(const void * data, int index) {
         writeToBuffer(data, instanceSize, index * alignmentSize);
     }
 
@@ -0,0 +1,51 @@
+#include "compute_pipeline.hpp"
+
+#include <cassert>
+#include <stdexcept>
+
+#include "pipeline.hpp"
+
+namespace impgine {
+
+    ComputePipeline::ComputePipeline(VkDevice device, const std::string & compFilepath,
+        VkPipelineLayout pipelineLayout): device {
+        device
+    } {
+        assert(pipelineLayout != VK_NULL_HANDLE && "Cannot create compute pipeline: no pipelineLayout provided");
+
+        auto compCode = Pipeline::readFile(compFilepath);
+
+        VkShaderModuleCreateInfo moduleInfo {};
+        moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        moduleInfo.codeSize = compCode.size();
+        moduleInfo.pCode = reinterpret_cast <
+            const uint32_t * > (compCode.data());
+
+        if (vkCreateShaderModule(device, & moduleInfo, nullptr, & compShaderModule) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create shader module");
+        }
+
+        VkComputePipelineCreateInfo pipelineInfo {};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineInfo.stage.module = compShaderModule;
+        pipelineInfo.stage.pName = "main";
+        pipelineInfo.layout = pipelineLayout;
+
+        if (vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, & pipelineInfo, nullptr, & computePipeline) != VK_SUCCESS) {
+            vkDestroyShaderModule(device, compShaderModule, nullptr);
+            throw std::runtime_error("failed to create compute pipeline");
+        }
+    }
+
+    ComputePipeline::~ComputePipeline() {
+        vkDestroyShaderModule(device, compShaderModule, nullptr);
+        vkDestroyPipeline(device, computePipeline, nullptr);
+    }
+
+    void ComputePipeline::bind(VkCommandBuffer commandBuffer) {
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline);
+    }
+
+} // namespace impgine
\ No newline at end of file
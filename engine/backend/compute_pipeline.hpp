@@ -0,0 +1,25 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <string>
+
+namespace impgine {
+
+    // Compute counterpart of Pipeline: one shader stage and a caller-owned layout
+    class ComputePipeline {
+        public: ComputePipeline(VkDevice device, const std::string & compFilepath, VkPipelineLayout pipelineLayout);
+        ~ComputePipeline();
+
+        // Delete copy constructor and assignment operator
+        ComputePipeline(const ComputePipeline & ) = delete;
+        ComputePipeline & operator = (const ComputePipeline & ) = delete;
+
+        void bind(VkCommandBuffer commandBuffer);
+
+        private: VkDevice device;
+        VkPipeline computePipeline = VK_NULL_HANDLE;
+        VkShaderModule compShaderModule = VK_NULL_HANDLE;
+    };
+
+} // namespace impgine
\ No newline at end of file
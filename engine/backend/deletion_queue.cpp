@@ -0,0 +1,113 @@
+#include "deletion_queue.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+namespace impgine {
+
+    DeletionQueue::~DeletionQueue() {
+        assert(batches.empty() && "DeletionQueue destroyed with pending entries, call flush() first");
+    }
+
+    DeletionQueue::Batch & DeletionQueue::batchFor(uint64_t retireFrame) {
+        // Frames retire in order, so keeping batches sorted lets collect() stop early
+        assert((batches.empty() || batches.back().retireFrame <= retireFrame) &&
+            "Deletion entries must be pushed in frame order");
+
+        if (batches.empty() || batches.back().retireFrame != retireFrame) {
+            batches.emplace_back();
+            batches.back().retireFrame = retireFrame;
+        }
+
+        peak = std::max(peak, ++pending);
+        return batches.back();
+    }
+
+    void DeletionQueue::retireBuffer(uint64_t retireFrame, VkBuffer buffer) {
+        batchFor(retireFrame).buffers.push_back(buffer);
+    }
+
+    void DeletionQueue::retireImage(uint64_t retireFrame, VkImage image) {
+        batchFor(retireFrame).images.push_back(image);
+    }
+
+    void DeletionQueue::retireImageView(uint64_t retireFrame, VkImageView imageView) {
+        batchFor(retireFrame).imageViews.push_back(imageView);
+    }
+
+    void DeletionQueue::retireSampler(uint64_t retireFrame, VkSampler sampler) {
+        batchFor(retireFrame).samplers.push_back(sampler);
+    }
+
+    void DeletionQueue::retireFramebuffer(uint64_t retireFrame, VkFramebuffer framebuffer) {
+        batchFor(retireFrame).framebuffers.push_back(framebuffer);
+    }
+
+    void DeletionQueue::retireRenderPass(uint64_t retireFrame, VkRenderPass renderPass) {
+        batchFor(retireFrame).renderPasses.push_back(renderPass);
+    }
+
+    void DeletionQueue::retirePipeline(uint64_t retireFrame, VkPipeline pipeline) {
+        batchFor(retireFrame).pipelines.push_back(pipeline);
+    }
+
+    void DeletionQueue::retirePipelineLayout(uint64_t retireFrame, VkPipelineLayout pipelineLayout) {
+        batchFor(retireFrame).pipelineLayouts.push_back(pipelineLayout);
+    }
+
+    void DeletionQueue::retireDescriptorPool(uint64_t retireFrame, VkDescriptorPool descriptorPool) {
+        batchFor(retireFrame).descriptorPools.push_back(descriptorPool);
+    }
+
+    void DeletionQueue::retireMemory(uint64_t retireFrame, VkDeviceMemory memory) {
+        batchFor(retireFrame).memory.push_back(memory);
+    }
+
+    void DeletionQueue::retireCommandBuffer(uint64_t retireFrame, VkCommandPool pool,
+        VkCommandBuffer commandBuffer) {
+        batchFor(retireFrame).commandBuffers.emplace_back(pool, commandBuffer);
+    }
+
+    void DeletionQueue::push(uint64_t retireFrame, std::function < void() > deleter) {
+        batchFor(retireFrame).deleters.push_back(std::move(deleter));
+    }
+
+    void DeletionQueue::release(Batch & batch) {
+        assert(device != VK_NULL_HANDLE && "DeletionQueue used before setDevice()");
+
+        // Users before the things they use: framebuffers before views, views before
+        // images, everything before the memory backing it
+        for (auto & deleter: batch.deleters) deleter();
+        for (auto framebuffer: batch.framebuffers) vkDestroyFramebuffer(device, framebuffer, nullptr);
+        for (auto pipeline: batch.pipelines) vkDestroyPipeline(device, pipeline, nullptr);
+        for (auto layout: batch.pipelineLayouts) vkDestroyPipelineLayout(device, layout, nullptr);
+        for (auto renderPass: batch.renderPasses) vkDestroyRenderPass(device, renderPass, nullptr);
+        for (auto pool: batch.descriptorPools) vkDestroyDescriptorPool(device, pool, nullptr);
+        for (auto sampler: batch.samplers) vkDestroySampler(device, sampler, nullptr);
+        for (auto view: batch.imageViews) vkDestroyImageView(device, view, nullptr);
+        for (auto image: batch.images) vkDestroyImage(device, image, nullptr);
+        for (auto buffer: batch.buffers) vkDestroyBuffer(device, buffer, nullptr);
+        for (auto & entry: batch.commandBuffers) vkFreeCommandBuffers(device, entry.first, 1, & entry.second);
+        for (auto block: batch.memory) vkFreeMemory(device, block, nullptr);
+
+        pending -= batch.deleters.size() + batch.framebuffers.size() + batch.pipelines.size() +
+            batch.pipelineLayouts.size() + batch.renderPasses.size() + batch.descriptorPools.size() +
+            batch.samplers.size() + batch.imageViews.size() + batch.images.size() +
+            batch.buffers.size() + batch.commandBuffers.size() + batch.memory.size();
+    }
+
+    void DeletionQueue::collect(uint64_t completedFrame) {
+        while (!batches.empty() && batches.front().retireFrame <= completedFrame) {
+            // Pop before releasing so a throwing deleter can't run twice
+            Batch batch = std::move(batches.front());
+            batches.pop_front();
+            release(batch);
+        }
+    }
+
+    void DeletionQueue::flush() {
+        collect(UINT64_MAX);
+    }
+
+} // namespace impgine
\ No newline at end of file
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace impgine {
+
+    // Defers destruction of GPU objects until the frames that may still
+    // reference them have completed. Objects are tagged with the frame value
+    // after which they are no longer used and freed in bulk once the caller
+    // reports that frame as finished, so nothing needs vkDeviceWaitIdle.
+    //
+    // Handles get one method per type rather than overloads: non-dispatchable
+    // handles are all uint64_t on 32-bit targets.
+    class DeletionQueue {
+        public: DeletionQueue() = default;
+        ~DeletionQueue();
+
+        // Delete copy constructor and assignment operator
+        DeletionQueue(const DeletionQueue & ) = delete;
+        DeletionQueue & operator = (const DeletionQueue & ) = delete;
+
+        void setDevice(VkDevice logicalDevice) {
+            device = logicalDevice;
+        }
+
+        void retireBuffer(uint64_t retireFrame, VkBuffer buffer);
+        void retireImage(uint64_t retireFrame, VkImage image);
+        void retireImageView(uint64_t retireFrame, VkImageView imageView);
+        void retireSampler(uint64_t retireFrame, VkSampler sampler);
+        void retireFramebuffer(uint64_t retireFrame, VkFramebuffer framebuffer);
+        void retireRenderPass(uint64_t retireFrame, VkRenderPass renderPass);
+        void retirePipeline(uint64_t retireFrame, VkPipeline pipeline);
+        void retirePipelineLayout(uint64_t retireFrame, VkPipelineLayout pipelineLayout);
+        void retireDescriptorPool(uint64_t retireFrame, VkDescriptorPool descriptorPool);
+        void retireMemory(uint64_t retireFrame, VkDeviceMemory memory);
+        void retireCommandBuffer(uint64_t retireFrame, VkCommandPool pool, VkCommandBuffer commandBuffer);
+
+        // For objects that own several handles (SwapChain, Pipeline, ...)
+        void push(uint64_t retireFrame, std::function < void() > deleter);
+
+        // Releases every batch whose frame is <= completedFrame
+        void collect(uint64_t completedFrame);
+
+        // Releases everything regardless of frame; the device must be idle
+        void flush();
+
+        // Number of objects waiting to be released
+        size_t size() const {
+            return pending;
+        }
+        size_t peakSize() const {
+            return peak;
+        }
+
+        private: struct Batch {
+            uint64_t retireFrame = 0;
+            std::vector < std::function < void() >> deleters;
+            std::vector < VkFramebuffer > framebuffers;
+            std::vector < VkPipeline > pipelines;
+            std::vector < VkPipelineLayout > pipelineLayouts;
+            std::vector < VkRenderPass > renderPasses;
+            std::vector < VkDescriptorPool > descriptorPools;
+            std::vector < VkSampler > samplers;
+            std::vector < VkImageView > imageViews;
+            std::vector < VkImage > images;
+            std::vector < VkBuffer > buffers;
+            std::vector < VkDeviceMemory > memory;
+            std::vector < std::pair < VkCommandPool, VkCommandBuffer >> commandBuffers;
+        };
+
+        Batch & batchFor(uint64_t retireFrame);
+        void release(Batch & batch);
+
+        VkDevice device = VK_NULL_HANDLE;
+        std::deque < Batch > batches;
+        size_t pending = 0;
+        size_t peak = 0;
+    };
+
+} // namespace impgine
\ No newline at end of file
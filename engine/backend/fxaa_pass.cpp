@@ -0,0 +1,277 @@
+#include "fxaa_pass.hpp"
+
+#include <array>
+#include <stdexcept>
+
+#include "pipeline_layout.hpp"
+
+namespace impgine {
+
+    namespace {
+
+        constexpr uint32_t WORKGROUP_SIZE = 8; // matches local_size in fxaa.comp
+
+        VkImageMemoryBarrier colorImageBarrier(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout,
+            VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask) {
+            VkImageMemoryBarrier barrier {};
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            barrier.oldLayout = oldLayout;
+            barrier.newLayout = newLayout;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.image = image;
+            barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            barrier.subresourceRange.baseMipLevel = 0;
+            barrier.subresourceRange.levelCount = 1;
+            barrier.subresourceRange.baseArrayLayer = 0;
+            barrier.subresourceRange.layerCount = 1;
+            barrier.srcAccessMask = srcAccessMask;
+            barrier.dstAccessMask = dstAccessMask;
+            return barrier;
+        }
+
+    } // namespace
+
+    FxaaPass::FxaaPass(VkDevice device, VkPhysicalDevice physicalDevice, VkFormat format, VkExtent2D extent,
+        const std::vector < VkImage > & outputImages, VkImageLayout outputFinalLayout): device {
+        device
+    }, physicalDevice {
+        physicalDevice
+    }, extent {
+        extent
+    }, outputImages {
+        outputImages
+    }, outputFinalLayout {
+        outputFinalLayout
+    } {
+        createImage(format, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+            sourceImage, sourceImageMemory, sourceImageView);
+        createImage(RESULT_FORMAT, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+            resultImage, resultImageMemory, resultImageView);
+        createDescriptors();
+        pipeline = std::make_unique < ComputePipeline > (device, "shaders/fxaa_comp.spv", pipelineLayout);
+    }
+
+    FxaaPass::~FxaaPass() {
+        pipeline.reset();
+        vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+        vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+        vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+        vkDestroySampler(device, sampler, nullptr);
+        vkDestroyImageView(device, resultImageView, nullptr);
+        vkDestroyImage(device, resultImage, nullptr);
+        vkFreeMemory(device, resultImageMemory, nullptr);
+        vkDestroyImageView(device, sourceImageView, nullptr);
+        vkDestroyImage(device, sourceImage, nullptr);
+        vkFreeMemory(device, sourceImageMemory, nullptr);
+    }
+
+    void FxaaPass::createImage(VkFormat imageFormat, VkImageUsageFlags usage, VkImage & image,
+        VkDeviceMemory & imageMemory, VkImageView & imageView) {
+        VkImageCreateInfo imageInfo {};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent.width = extent.width;
+        imageInfo.extent.height = extent.height;
+        imageInfo.extent.depth = 1;
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.format = imageFormat;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.usage = usage;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        if (vkCreateImage(device, & imageInfo, nullptr, & image) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create FXAA image!");
+        }
+
+        VkMemoryRequirements memRequirements;
+        vkGetImageMemoryRequirements(device, image, & memRequirements);
+
+        VkMemoryAllocateInfo allocInfo {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = memRequirements.size;
+        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        if (vkAllocateMemory(device, & allocInfo, nullptr, & imageMemory) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate FXAA image memory!");
+        }
+        vkBindImageMemory(device, image, imageMemory, 0);
+
+        VkImageViewCreateInfo viewInfo {};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = image;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = imageFormat;
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        viewInfo.subresourceRange.baseMipLevel = 0;
+        viewInfo.subresourceRange.levelCount = 1;
+        viewInfo.subresourceRange.baseArrayLayer = 0;
+        viewInfo.subresourceRange.layerCount = 1;
+
+        if (vkCreateImageView(device, & viewInfo, nullptr, & imageView) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create FXAA image view!");
+        }
+    }
+
+    void FxaaPass::createDescriptors() {
+        // The edge search samples between texels, so the sampler filters
+        VkSamplerCreateInfo samplerInfo {};
+        samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        samplerInfo.magFilter = VK_FILTER_LINEAR;
+        samplerInfo.minFilter = VK_FILTER_LINEAR;
+        samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.maxLod = 0.0f;
+
+        if (vkCreateSampler(device, & samplerInfo, nullptr, & sampler) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create FXAA sampler!");
+        }
+
+        std::array < VkDescriptorSetLayoutBinding, 2 > bindings {};
+        bindings[0].binding = 0;
+        bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        bindings[0].descriptorCount = 1;
+        bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        bindings[1].binding = 1;
+        bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        bindings[1].descriptorCount = 1;
+        bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+        VkDescriptorSetLayoutCreateInfo layoutInfo {};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = static_cast < uint32_t > (bindings.size());
+        layoutInfo.pBindings = bindings.data();
+
+        if (vkCreateDescriptorSetLayout(device, & layoutInfo, nullptr, & descriptorSetLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create FXAA descriptor set layout!");
+        }
+
+        std::array < VkDescriptorPoolSize, 2 > poolSizes {};
+        poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        poolSizes[0].descriptorCount = 1;
+        poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        poolSizes[1].descriptorCount = 1;
+
+        VkDescriptorPoolCreateInfo poolInfo {};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.poolSizeCount = static_cast < uint32_t > (poolSizes.size());
+        poolInfo.pPoolSizes = poolSizes.data();
+        poolInfo.maxSets = 1;
+
+        if (vkCreateDescriptorPool(device, & poolInfo, nullptr, & descriptorPool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create FXAA descriptor pool!");
+        }
+
+        VkDescriptorSetAllocateInfo allocInfo {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = descriptorPool;
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = & descriptorSetLayout;
+
+        if (vkAllocateDescriptorSets(device, & allocInfo, & descriptorSet) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate FXAA descriptor set!");
+        }
+
+        VkDescriptorImageInfo sourceInfo {};
+        sourceInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        sourceInfo.imageView = sourceImageView;
+        sourceInfo.sampler = sampler;
+
+        VkDescriptorImageInfo resultInfo {};
+        resultInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+        resultInfo.imageView = resultImageView;
+
+        std::array < VkWriteDescriptorSet, 2 > writes {};
+        writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[0].dstSet = descriptorSet;
+        writes[0].dstBinding = 0;
+        writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        writes[0].descriptorCount = 1;
+        writes[0].pImageInfo = & sourceInfo;
+        writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[1].dstSet = descriptorSet;
+        writes[1].dstBinding = 1;
+        writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        writes[1].descriptorCount = 1;
+        writes[1].pImageInfo = & resultInfo;
+        vkUpdateDescriptorSets(device, static_cast < uint32_t > (writes.size()), writes.data(), 0, nullptr);
+
+        pipelineLayout = PipelineLayoutBuilder(device)
+            .addDescriptorSetLayout(descriptorSetLayout)
+            .addPushConstantRange(VK_SHADER_STAGE_COMPUTE_BIT, sizeof(PushConstants))
+            .build();
+    }
+
+    uint32_t FxaaPass::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const {
+        VkPhysicalDeviceMemoryProperties memProperties;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, & memProperties);
+
+        for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+            if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+                return i;
+            }
+        }
+
+        throw std::runtime_error("failed to find suitable memory type!");
+    }
+
+    void FxaaPass::record(VkCommandBuffer commandBuffer, uint32_t imageIndex) const {
+        // The previous contents are discarded; the frame-start barrier already
+        // ordered this against the last frame's blit
+        VkImageMemoryBarrier toGeneral = colorImageBarrier(resultImage, VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_IMAGE_LAYOUT_GENERAL, 0, VK_ACCESS_SHADER_WRITE_BIT);
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0, 0, nullptr, 0, nullptr, 1, & toGeneral);
+
+        pipeline -> bind(commandBuffer);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, & descriptorSet, 0, nullptr);
+
+        PushConstants push {};
+        push.inverseWidth = 1.0f / static_cast < float > (extent.width);
+        push.inverseHeight = 1.0f / static_cast < float > (extent.height);
+        vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), & push);
+
+        vkCmdDispatch(commandBuffer, (extent.width + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE,
+            (extent.height + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1);
+
+        // Swapchain images become writable once the acquire semaphore signals,
+        // which the submit waits for at the color output stage
+        std::array < VkImageMemoryBarrier, 2 > toTransfer = {
+            colorImageBarrier(resultImage, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT),
+            colorImageBarrier(outputImages[imageIndex], VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                0, VK_ACCESS_TRANSFER_WRITE_BIT)
+        };
+        vkCmdPipelineBarrier(commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr,
+            static_cast < uint32_t > (toTransfer.size()), toTransfer.data());
+
+        // Same size on both sides; the blit only converts the format
+        VkImageBlit region {};
+        region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.srcSubresource.layerCount = 1;
+        region.srcOffsets[1] = {
+            static_cast < int32_t > (extent.width),
+            static_cast < int32_t > (extent.height),
+            1
+        };
+        region.dstSubresource = region.srcSubresource;
+        region.dstOffsets[1] = region.srcOffsets[1];
+        vkCmdBlitImage(commandBuffer, resultImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            outputImages[imageIndex], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, & region, VK_FILTER_NEAREST);
+
+        // Covers both presenting and the readback copies of offscreen targets
+        VkImageMemoryBarrier toFinal = colorImageBarrier(outputImages[imageIndex], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            outputFinalLayout, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_MEMORY_READ_BIT);
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            0, 0, nullptr, 0, nullptr, 1, & toFinal);
+    }
+
+} // namespace impgine
\ No newline at end of file
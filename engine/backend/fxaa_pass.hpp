@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <memory>
+#include <vector>
+
+#include "compute_pipeline.hpp"
+
+namespace impgine {
+
+    // Post-process anti-aliasing for single-sample rendering. The main pass
+    // renders into the source image; a compute shader runs FXAA from it into
+    // a storage image that is then blitted onto the output image. Storage
+    // writes go to an internal image because swapchain formats (sRGB in
+    // particular) rarely support them; the outputs need TRANSFER_DST usage.
+    class FxaaPass {
+        public: FxaaPass(VkDevice device, VkPhysicalDevice physicalDevice, VkFormat format, VkExtent2D extent,
+            const std::vector < VkImage > & outputImages, VkImageLayout outputFinalLayout);
+        ~FxaaPass();
+
+        // Delete copy constructor and assignment operator
+        FxaaPass(const FxaaPass & ) = delete;
+        FxaaPass & operator = (const FxaaPass & ) = delete;
+
+        // Color target for the main pass; must end in SHADER_READ_ONLY_OPTIMAL
+        VkImageView getSourceImageView() const {
+            return sourceImageView;
+        }
+
+        // Records the filter and the blit onto output `imageIndex`, leaving it in the final layout
+        void record(VkCommandBuffer commandBuffer, uint32_t imageIndex) const;
+
+        private: struct PushConstants {
+            float inverseWidth;
+            float inverseHeight;
+        };
+
+        static constexpr VkFormat RESULT_FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT; // storage support is guaranteed
+
+        void createImage(VkFormat imageFormat, VkImageUsageFlags usage, VkImage & image,
+            VkDeviceMemory & imageMemory, VkImageView & imageView);
+        void createDescriptors();
+        uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+
+        VkDevice device;
+        VkPhysicalDevice physicalDevice;
+        VkExtent2D extent;
+        std::vector < VkImage > outputImages;
+        VkImageLayout outputFinalLayout;
+
+        VkImage sourceImage = VK_NULL_HANDLE;
+        VkDeviceMemory sourceImageMemory = VK_NULL_HANDLE;
+        VkImageView sourceImageView = VK_NULL_HANDLE;
+        VkImage resultImage = VK_NULL_HANDLE;
+        VkDeviceMemory resultImageMemory = VK_NULL_HANDLE;
+        VkImageView resultImageView = VK_NULL_HANDLE;
+        VkSampler sampler = VK_NULL_HANDLE;
+
+        VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+        VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+        VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+        VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+        std::unique_ptr < ComputePipeline > pipeline;
+    };
+
+} // namespace impgine
\ No newline at end of file
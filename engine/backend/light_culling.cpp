@@ -0,0 +1,178 @@
+#include "light_culling.hpp"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+#include "pipeline_layout.hpp"
+
+namespace impgine {
+
+    namespace {
+
+        constexpr uint32_t WORKGROUP_SIZE = 128; // matches local_size in light_cull.comp
+
+    } // namespace
+
+    static_assert(LightCulling::CLUSTER_COUNT % WORKGROUP_SIZE == 0, "clusters must fill whole workgroups");
+
+    LightCulling::LightCulling(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t frameCount): device {
+        device
+    } {
+        static_assert(sizeof(GpuLight) == 32, "GpuLight must match the std430 layout in the shaders");
+
+        // Written by the host every frame, so persistently mapped
+        for (uint32_t i = 0; i < frameCount; i++) {
+            paramBuffers.push_back(std::make_unique < Buffer > (device, physicalDevice, sizeof(Params), 1,
+                VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
+            paramBuffers.back() -> map();
+            lightBuffers.push_back(std::make_unique < Buffer > (device, physicalDevice, sizeof(GpuLight), MAX_LIGHTS,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
+            lightBuffers.back() -> map();
+        }
+        uploadedLights.resize(frameCount);
+        lightCounts.resize(frameCount, 0);
+
+        // A count per cluster followed by every cluster's fixed-size index slot
+        clusterBuffer = std::make_unique < Buffer > (device, physicalDevice, sizeof(uint32_t),
+            CLUSTER_COUNT * (1 + MAX_LIGHTS_PER_CLUSTER), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        createDescriptors();
+        pipelineLayout = PipelineLayoutBuilder(device)
+            .addDescriptorSetLayout(descriptorSetLayout)
+            .build();
+        pipeline = std::make_unique < ComputePipeline > (device, "shaders/light_cull_comp.spv", pipelineLayout);
+    }
+
+    LightCulling::~LightCulling() {
+        pipeline.reset();
+        vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+        vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+        vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+    }
+
+    void LightCulling::createDescriptors() {
+        // Culling and shading read the same set; only culling writes the clusters
+        std::array < VkDescriptorSetLayoutBinding, 3 > bindings {};
+        bindings[0].binding = 0;
+        bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        bindings[0].descriptorCount = 1;
+        bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+        bindings[1].binding = 1;
+        bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[1].descriptorCount = 1;
+        bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+        bindings[2].binding = 2;
+        bindings[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[2].descriptorCount = 1;
+        bindings[2].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+
+        VkDescriptorSetLayoutCreateInfo layoutInfo {};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = static_cast < uint32_t > (bindings.size());
+        layoutInfo.pBindings = bindings.data();
+        if (vkCreateDescriptorSetLayout(device, & layoutInfo, nullptr, & descriptorSetLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create light culling descriptor set layout!");
+        }
+
+        uint32_t frameCount = static_cast < uint32_t > (paramBuffers.size());
+        std::array < VkDescriptorPoolSize, 2 > poolSizes {};
+        poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        poolSizes[0].descriptorCount = frameCount;
+        poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        poolSizes[1].descriptorCount = 2 * frameCount;
+
+        VkDescriptorPoolCreateInfo poolInfo {};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.poolSizeCount = static_cast < uint32_t > (poolSizes.size());
+        poolInfo.pPoolSizes = poolSizes.data();
+        poolInfo.maxSets = frameCount;
+        if (vkCreateDescriptorPool(device, & poolInfo, nullptr, & descriptorPool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create light culling descriptor pool!");
+        }
+
+        std::vector < VkDescriptorSetLayout > layouts(frameCount, descriptorSetLayout);
+        VkDescriptorSetAllocateInfo allocInfo {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = descriptorPool;
+        allocInfo.descriptorSetCount = frameCount;
+        allocInfo.pSetLayouts = layouts.data();
+        descriptorSets.resize(frameCount);
+        if (vkAllocateDescriptorSets(device, & allocInfo, descriptorSets.data()) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate light culling descriptor sets!");
+        }
+
+        for (uint32_t i = 0; i < frameCount; i++) {
+            std::array < VkDescriptorBufferInfo, 3 > bufferInfos = {
+                paramBuffers[i] -> descriptorInfo(),
+                lightBuffers[i] -> descriptorInfo(),
+                clusterBuffer -> descriptorInfo()
+            };
+
+            std::array < VkWriteDescriptorSet, 3 > writes {};
+            for (uint32_t binding = 0; binding < writes.size(); binding++) {
+                writes[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                writes[binding].dstSet = descriptorSets[i];
+                writes[binding].dstBinding = binding;
+                writes[binding].descriptorType = bindings[binding].descriptorType;
+                writes[binding].descriptorCount = 1;
+                writes[binding].pBufferInfo = & bufferInfos[binding];
+            }
+            vkUpdateDescriptorSets(device, static_cast < uint32_t > (writes.size()), writes.data(), 0, nullptr);
+        }
+    }
+
+    void LightCulling::update(uint32_t frameIndex, const glm::mat4 & view, const glm::mat4 & proj,
+        VkExtent2D renderExtent, const std::shared_ptr < const std::vector < PointLight >> & lights) {
+        uint32_t lightCount = lights ? static_cast < uint32_t > (std::min < size_t > (lights -> size(), MAX_LIGHTS)) : 0;
+
+        // Holding on to the uploaded list keeps its address from being reused by a new one
+        if (lightCount > 0 && uploadedLights[frameIndex] != lights) {
+            GpuLight * gpuLights = static_cast < GpuLight * > (lightBuffers[frameIndex] -> getMappedMemory());
+            for (uint32_t i = 0; i < lightCount; i++) {
+                const PointLight & light = ( * lights)[i];
+                gpuLights[i].positionRadius = glm::vec4(light.position, light.radius);
+                gpuLights[i].colorIntensity = glm::vec4(light.color, light.intensity);
+            }
+            uploadedLights[frameIndex] = lights;
+        }
+        lightCounts[frameIndex] = lightCount;
+
+        // The depth slices follow the projection's own planes; for a
+        // zero-to-one perspective matrix they fall out of its third column
+        float near = proj[3][2] / proj[2][2];
+        float far = proj[3][2] / (proj[2][2] + 1.0f);
+
+        Params params {};
+        params.view = view;
+        params.inverseProjection = glm::inverse(proj);
+        params.cameraPosition = glm::inverse(view)[3];
+        params.gridSize = glm::uvec4(GRID_X, GRID_Y, GRID_Z, lightCount);
+        params.screen = glm::vec4(static_cast < float > (renderExtent.width), static_cast < float > (renderExtent.height),
+            near, far);
+        paramBuffers[frameIndex] -> writeToBuffer( & params, sizeof(params));
+    }
+
+    void LightCulling::record(VkCommandBuffer commandBuffer, uint32_t frameIndex) const {
+        // The fragment shader skips the cluster lookup without lights
+        if (lightCounts[frameIndex] == 0) {
+            return;
+        }
+
+        pipeline -> bind(commandBuffer);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1,
+            & descriptorSets[frameIndex], 0, nullptr);
+        vkCmdDispatch(commandBuffer, CLUSTER_COUNT / WORKGROUP_SIZE, 1, 1);
+
+        VkMemoryBarrier barrier {};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            0, 1, & barrier, 0, nullptr, 0, nullptr);
+    }
+
+} // namespace impgine
\ No newline at end of file
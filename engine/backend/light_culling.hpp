@@ -0,0 +1,89 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#define GLM_FORCE_DEFAULT_ALIGNED_GENTYPES
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <vector>
+
+#include "../point_light.hpp"
+#include "buffers.hpp"
+#include "compute_pipeline.hpp"
+
+namespace impgine {
+
+    // Clustered forward lighting. The view frustum is split into a grid of
+    // screen tiles times exponentially spaced depth slices; a compute pass
+    // writes the lights overlapping each cluster into a fixed-size slot, and
+    // the main pass's fragment shader only loops over its own cluster's list.
+    //
+    // Lights and the grid parameters live in per-frame buffers behind one
+    // descriptor set layout, which the main pipeline layout uses as set 1.
+    // The cluster lists are shared between frames: frames never overlap on the
+    // GPU (see the barrier at the start of every frame).
+    class LightCulling {
+        public: static constexpr uint32_t MAX_LIGHTS = 4096;
+        // Must match light_cull.comp and shader.frag
+        static constexpr uint32_t GRID_X = 16;
+        static constexpr uint32_t GRID_Y = 9;
+        static constexpr uint32_t GRID_Z = 24;
+        static constexpr uint32_t CLUSTER_COUNT = GRID_X * GRID_Y * GRID_Z;
+        // Lights past this in one cluster are dropped
+        static constexpr uint32_t MAX_LIGHTS_PER_CLUSTER = 128;
+
+        LightCulling(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t frameCount);
+        ~LightCulling();
+
+        // Delete copy constructor and assignment operator
+        LightCulling(const LightCulling & ) = delete;
+        LightCulling & operator = (const LightCulling & ) = delete;
+
+        VkDescriptorSetLayout getDescriptorSetLayout() const {
+            return descriptorSetLayout;
+        }
+        VkDescriptorSet getDescriptorSet(uint32_t frameIndex) const {
+            return descriptorSets[frameIndex];
+        }
+
+        // Fills frame `frameIndex`'s buffers once its fence has signalled. The
+        // light list is only copied when it is a different list than last time
+        void update(uint32_t frameIndex, const glm::mat4 & view, const glm::mat4 & proj, VkExtent2D renderExtent,
+            const std::shared_ptr < const std::vector < PointLight >> & lights);
+
+        // Bins the lights ahead of the main pass; records nothing without lights
+        void record(VkCommandBuffer commandBuffer, uint32_t frameIndex) const;
+
+        private: struct Params {
+            glm::mat4 view;
+            glm::mat4 inverseProjection;
+            glm::vec4 cameraPosition;
+            glm::uvec4 gridSize; // w = light count
+            glm::vec4 screen; // render width, render height, near, far
+        };
+
+        struct GpuLight {
+            glm::vec4 positionRadius;
+            glm::vec4 colorIntensity;
+        };
+
+        void createDescriptors();
+
+        VkDevice device;
+        std::vector < std::unique_ptr < Buffer >> paramBuffers;
+        std::vector < std::unique_ptr < Buffer >> lightBuffers;
+        std::unique_ptr < Buffer > clusterBuffer;
+        std::vector < std::shared_ptr < const std::vector < PointLight >>> uploadedLights;
+        std::vector < uint32_t > lightCounts;
+
+        VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+        VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+        std::vector < VkDescriptorSet > descriptorSets;
+        VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+        std::unique_ptr < ComputePipeline > pipeline;
+    };
+
+} // namespace impgine
\ No newline at end of file
@@ -0,0 +1,280 @@
+#include "offscreen_target.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace impgine {
+
+    OffscreenTarget::OffscreenTarget(VkDevice device, VkPhysicalDevice physicalDevice, VkExtent2D extent,
+        uint32_t imageCount): device {
+        device
+    }, physicalDevice {
+        physicalDevice
+    }, extent {
+        extent
+    } {
+        if (extent.width == 0 || extent.height == 0) {
+            throw std::runtime_error("offscreen target size must not be zero!");
+        }
+
+        images.resize(imageCount, VK_NULL_HANDLE);
+        imageMemorys.resize(imageCount, VK_NULL_HANDLE);
+        imageViews.resize(imageCount, VK_NULL_HANDLE);
+        createImages();
+        createSyncObjects();
+    }
+
+    OffscreenTarget::~OffscreenTarget() {
+        for (size_t i = 0; i < images.size(); i++) {
+            vkDestroyImageView(device, imageViews[i], nullptr);
+            vkDestroyImage(device, images[i], nullptr);
+            vkFreeMemory(device, imageMemorys[i], nullptr);
+        }
+
+        for (auto fence: inFlightFences) {
+            vkDestroyFence(device, fence, nullptr);
+        }
+
+        for (size_t i = 0; i < readbackBuffers.size(); i++) {
+            if (readbackMappings[i]) {
+                vkUnmapMemory(device, readbackMemorys[i]);
+            }
+            vkDestroyBuffer(device, readbackBuffers[i], nullptr);
+            vkFreeMemory(device, readbackMemorys[i], nullptr);
+        }
+    }
+
+    void OffscreenTarget::createImages() {
+        for (size_t i = 0; i < images.size(); i++) {
+            VkImageCreateInfo imageInfo {};
+            imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            imageInfo.imageType = VK_IMAGE_TYPE_2D;
+            imageInfo.extent.width = extent.width;
+            imageInfo.extent.height = extent.height;
+            imageInfo.extent.depth = 1;
+            imageInfo.mipLevels = 1;
+            imageInfo.arrayLayers = 1;
+            imageInfo.format = IMAGE_FORMAT;
+            imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+            imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+            imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+            imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+            if (vkCreateImage(device, & imageInfo, nullptr, & images[i]) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create offscreen image!");
+            }
+
+            VkMemoryRequirements memRequirements;
+            vkGetImageMemoryRequirements(device, images[i], & memRequirements);
+
+            VkMemoryAllocateInfo allocInfo {};
+            allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+            allocInfo.allocationSize = memRequirements.size;
+            allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+            if (vkAllocateMemory(device, & allocInfo, nullptr, & imageMemorys[i]) != VK_SUCCESS) {
+                throw std::runtime_error("failed to allocate offscreen image memory!");
+            }
+            vkBindImageMemory(device, images[i], imageMemorys[i], 0);
+
+            VkImageViewCreateInfo viewInfo {};
+            viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            viewInfo.image = images[i];
+            viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            viewInfo.format = IMAGE_FORMAT;
+            viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            viewInfo.subresourceRange.baseMipLevel = 0;
+            viewInfo.subresourceRange.levelCount = 1;
+            viewInfo.subresourceRange.baseArrayLayer = 0;
+            viewInfo.subresourceRange.layerCount = 1;
+
+            if (vkCreateImageView(device, & viewInfo, nullptr, & imageViews[i]) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create offscreen image view!");
+            }
+        }
+    }
+
+    void OffscreenTarget::createSyncObjects() {
+        inFlightFences.resize(images.size(), VK_NULL_HANDLE);
+
+        VkFenceCreateInfo fenceInfo {};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+        for (size_t i = 0; i < inFlightFences.size(); i++) {
+            if (vkCreateFence(device, & fenceInfo, nullptr, & inFlightFences[i]) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create offscreen synchronization objects!");
+            }
+        }
+    }
+
+    uint32_t OffscreenTarget::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const {
+        VkPhysicalDeviceMemoryProperties memProperties;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, & memProperties);
+
+        for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+            if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+                return i;
+            }
+        }
+
+        throw std::runtime_error("failed to find suitable memory type!");
+    }
+
+    void OffscreenTarget::createHostBuffer(VkBuffer & buffer, VkDeviceMemory & bufferMemory) const {
+        VkBufferCreateInfo bufferInfo {};
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = pixelDataSize();
+        bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        if (vkCreateBuffer(device, & bufferInfo, nullptr, & buffer) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create readback buffer!");
+        }
+
+        VkMemoryRequirements memRequirements;
+        vkGetBufferMemoryRequirements(device, buffer, & memRequirements);
+
+        VkMemoryAllocateInfo allocInfo {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = memRequirements.size;
+        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+        if (vkAllocateMemory(device, & allocInfo, nullptr, & bufferMemory) != VK_SUCCESS) {
+            vkDestroyBuffer(device, buffer, nullptr);
+            throw std::runtime_error("failed to allocate readback buffer memory!");
+        }
+        vkBindBufferMemory(device, buffer, bufferMemory, 0);
+    }
+
+    void OffscreenTarget::recordCopyToBuffer(VkCommandBuffer commandBuffer, uint32_t index, VkBuffer buffer) const {
+        // The render pass already left the image in TRANSFER_SRC_OPTIMAL; only
+        // its color writes still have to be made visible to the copy
+        VkImageMemoryBarrier imageBarrier {};
+        imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        imageBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        imageBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        imageBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageBarrier.image = images[index];
+        imageBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        imageBarrier.subresourceRange.baseMipLevel = 0;
+        imageBarrier.subresourceRange.levelCount = 1;
+        imageBarrier.subresourceRange.baseArrayLayer = 0;
+        imageBarrier.subresourceRange.layerCount = 1;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+            0, nullptr, 0, nullptr, 1, & imageBarrier);
+
+        VkBufferImageCopy region {};
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageExtent = {
+            extent.width,
+            extent.height,
+            1
+        };
+        vkCmdCopyImageToBuffer(commandBuffer, images[index], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, buffer, 1, & region);
+
+        // Make the transfer visible to host reads
+        VkBufferMemoryBarrier barrier {};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer = buffer;
+        barrier.offset = 0;
+        barrier.size = VK_WHOLE_SIZE;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+            0, nullptr, 1, & barrier, 0, nullptr);
+    }
+
+    void OffscreenTarget::readPixels(VkCommandPool commandPool, VkQueue queue, uint32_t index,
+        std::vector < uint8_t > & pixels) const {
+        VkBuffer buffer;
+        VkDeviceMemory bufferMemory;
+        createHostBuffer(buffer, bufferMemory);
+
+        VkCommandBufferAllocateInfo commandBufferInfo {};
+        commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        commandBufferInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        commandBufferInfo.commandPool = commandPool;
+        commandBufferInfo.commandBufferCount = 1;
+
+        VkCommandBuffer commandBuffer;
+        vkAllocateCommandBuffers(device, & commandBufferInfo, & commandBuffer);
+
+        VkCommandBufferBeginInfo beginInfo {};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(commandBuffer, & beginInfo);
+        recordCopyToBuffer(commandBuffer, index, buffer);
+        vkEndCommandBuffer(commandBuffer);
+
+        VkSubmitInfo submitInfo {};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = & commandBuffer;
+        vkQueueSubmit(queue, 1, & submitInfo, VK_NULL_HANDLE);
+
+        // One-off readback; blocking here keeps the caller simple
+        vkQueueWaitIdle(queue);
+
+        VkDeviceSize size = pixelDataSize();
+        pixels.resize(static_cast < size_t > (size));
+        void * data;
+        vkMapMemory(device, bufferMemory, 0, size, 0, & data);
+        memcpy(pixels.data(), data, pixels.size());
+        vkUnmapMemory(device, bufferMemory);
+
+        vkFreeCommandBuffers(device, commandPool, 1, & commandBuffer);
+        vkDestroyBuffer(device, buffer, nullptr);
+        vkFreeMemory(device, bufferMemory, nullptr);
+    }
+
+    void OffscreenTarget::enableReadback() {
+        if (!readbackBuffers.empty()) {
+            return;
+        }
+
+        readbackBuffers.resize(images.size(), VK_NULL_HANDLE);
+        readbackMemorys.resize(images.size(), VK_NULL_HANDLE);
+        readbackMappings.resize(images.size(), nullptr);
+        for (size_t i = 0; i < images.size(); i++) {
+            createHostBuffer(readbackBuffers[i], readbackMemorys[i]);
+            // Host coherent and only read after the fence, so it can stay mapped
+            vkMapMemory(device, readbackMemorys[i], 0, pixelDataSize(), 0, & readbackMappings[i]);
+        }
+    }
+
+    void OffscreenTarget::recordReadback(VkCommandBuffer commandBuffer, uint32_t index) const {
+        recordCopyToBuffer(commandBuffer, index, readbackBuffers[index]);
+    }
+
+    void OffscreenTarget::writePpm(const std::string & path, VkExtent2D extent,
+        const std::vector < uint8_t > & pixels) {
+        std::ofstream file(path, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("failed to open " + path + " for writing!");
+        }
+
+        file << "P6\n" << extent.width << " " << extent.height << "\n255\n";
+        size_t pixelCount = static_cast < size_t > (extent.width) * extent.height;
+        for (size_t i = 0; i < pixelCount; i++) {
+            file.write(reinterpret_cast < const char * > ( & pixels[i * 4]), 3);
+        }
+
+        if (!file) {
+            throw std::runtime_error("failed to write " + path + "!");
+        }
+    }
+
+} // namespace impgine
\ No newline at end of file
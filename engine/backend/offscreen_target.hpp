@@ -0,0 +1,87 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace impgine {
+
+    // Stand-in for SwapChain when rendering without a window or surface. Owns
+    // one color image and one in-flight fence per frame in flight; image i is
+    // rendered by frame slot i, so no acquire or present step is needed. The
+    // images end their render pass in TRANSFER_SRC_OPTIMAL for readback.
+    class OffscreenTarget {
+        public: static constexpr VkFormat IMAGE_FORMAT = VK_FORMAT_R8G8B8A8_SRGB;
+
+        OffscreenTarget(VkDevice device, VkPhysicalDevice physicalDevice, VkExtent2D extent,
+            uint32_t imageCount);
+        ~OffscreenTarget();
+
+        // Delete copy constructor and assignment operator
+        OffscreenTarget(const OffscreenTarget & ) = delete;
+        OffscreenTarget & operator = (const OffscreenTarget & ) = delete;
+
+        VkImageView getImageView(int index) const {
+            return imageViews[index];
+        }
+        VkImage getImage(int index) const {
+            return images[index];
+        }
+        size_t imageCount() const {
+            return images.size();
+        }
+        VkFormat getImageFormat() const {
+            return IMAGE_FORMAT;
+        }
+        VkExtent2D getExtent() const {
+            return extent;
+        }
+        VkFence getInFlightFence(uint32_t frameIndex) const {
+            return inFlightFences[frameIndex];
+        }
+
+        // Copies image `index` to host memory as tightly packed RGBA8. Blocks
+        // until the copy is done; the image must not be in use by the GPU.
+        void readPixels(VkCommandPool commandPool, VkQueue queue, uint32_t index,
+            std::vector < uint8_t > & pixels) const;
+
+        // Per-frame readback without stalling: recordReadback() appends a copy of
+        // image `index` to the frame's own command buffer, and the pixels can be
+        // read from getReadbackPixels() once that frame slot's fence signals
+        void enableReadback();
+        void recordReadback(VkCommandBuffer commandBuffer, uint32_t index) const;
+        const uint8_t * getReadbackPixels(uint32_t index) const {
+            return static_cast < const uint8_t * > (readbackMappings[index]);
+        }
+        VkDeviceSize pixelDataSize() const {
+            return static_cast < VkDeviceSize > (extent.width) * extent.height * 4;
+        }
+
+        // Writes RGBA8 pixels as a binary PPM, dropping alpha
+        static void writePpm(const std::string & path, VkExtent2D extent,
+            const std::vector < uint8_t > & pixels);
+
+        private: void createImages();
+        void createSyncObjects();
+        void createHostBuffer(VkBuffer & buffer, VkDeviceMemory & bufferMemory) const;
+        // Image writes -> transfer -> host reads of `buffer`
+        void recordCopyToBuffer(VkCommandBuffer commandBuffer, uint32_t index, VkBuffer buffer) const;
+        uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+
+        VkDevice device;
+        VkPhysicalDevice physicalDevice;
+        VkExtent2D extent;
+
+        std::vector < VkImage > images;
+        std::vector < VkDeviceMemory > imageMemorys;
+        std::vector < VkImageView > imageViews;
+        std::vector < VkFence > inFlightFences;
+
+        std::vector < VkBuffer > readbackBuffers;
+        std::vector < VkDeviceMemory > readbackMemorys;
+        std::vector < void * > readbackMappings;
+    };
+
+} // namespace impgine
\ No newline at end of file
@@ -54,10 +54,11 @@ namespace impgine {
             "Cannot create graphics pipeline: no renderPass provided in configInfo");
 
         auto vertCode = readFile(vertFilepath);
-        auto fragCode = readFile(fragFilepath);
-
         createShaderModule(vertCode, & vertShaderModule);
-        createShaderModule(fragCode, & fragShaderModule);
+        if (!fragFilepath.empty()) {
+            auto fragCode = readFile(fragFilepath);
+            createShaderModule(fragCode, & fragShaderModule);
+        }
 
         VkPipelineShaderStageCreateInfo shaderStages[2];
         shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -75,19 +76,20 @@ namespace impgine {
         shaderStages[1].pNext = nullptr;
         shaderStages[1].pSpecializationInfo = nullptr;
 
-        auto bindingDescription = Vertex::getBindingDescription();
-        auto attributeDescriptions = Vertex::getAttributeDescriptions();
-        
+        // Empty for passes that generate their vertices in the shader
+        const auto & bindingDescriptions = configInfo.bindingDescriptions;
+        const auto & attributeDescriptions = configInfo.attributeDescriptions;
+
         VkPipelineVertexInputStateCreateInfo vertexInputInfo {};
         vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-        vertexInputInfo.vertexBindingDescriptionCount = 1;
-        vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-        vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
-        vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+        vertexInputInfo.vertexBindingDescriptionCount = static_cast < uint32_t > (bindingDescriptions.size());
+        vertexInputInfo.vertexAttributeDescriptionCount = static_cast < uint32_t > (attributeDescriptions.size());
+        vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.empty() ? nullptr : bindingDescriptions.data();
+        vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.empty() ? nullptr : attributeDescriptions.data();
 
         VkGraphicsPipelineCreateInfo pipelineInfo {};
         pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-        pipelineInfo.stageCount = 2;
+        pipelineInfo.stageCount = fragShaderModule == VK_NULL_HANDLE ? 1 : 2;
         pipelineInfo.pStages = shaderStages;
         pipelineInfo.pVertexInputState = & vertexInputInfo;
         pipelineInfo.pInputAssemblyState = & configInfo.inputAssemblyInfo;
@@ -128,6 +130,12 @@ namespace impgine {
     }
 
     void Pipeline::defaultPipelineConfigInfo(PipelineConfigInfo & configInfo) {
+        configInfo.bindingDescriptions = {
+            Vertex::getBindingDescription()
+        };
+        auto attributeDescriptions = Vertex::getAttributeDescriptions();
+        configInfo.attributeDescriptions.assign(attributeDescriptions.begin(), attributeDescriptions.end());
+
         configInfo.inputAssemblyInfo.sType =
             VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
         configInfo.inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
@@ -13,9 +13,13 @@ namespace impgine {
         glm::vec3 pos;
         glm::vec3 color;
         glm::vec2 texCoord;
+        glm::vec3 normal;
+        // w is the bitangent sign: bitangent = w * cross(normal, tangent.xyz)
+        glm::vec4 tangent;
 
         bool operator==(const Vertex& other) const {
-            return pos == other.pos && color == other.color && texCoord == other.texCoord;
+            return pos == other.pos && color == other.color && texCoord == other.texCoord &&
+                normal == other.normal && tangent == other.tangent;
         }
 
         static VkVertexInputBindingDescription getBindingDescription() {
@@ -26,8 +30,8 @@ namespace impgine {
             return bindingDescription;
         }
 
-        static std::array<VkVertexInputAttributeDescription, 3> getAttributeDescriptions() {
-            std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions{};
+        static std::array<VkVertexInputAttributeDescription, 5> getAttributeDescriptions() {
+            std::array<VkVertexInputAttributeDescription, 5> attributeDescriptions{};
             
             attributeDescriptions[0].binding = 0;
             attributeDescriptions[0].location = 0;
@@ -44,8 +48,36 @@ namespace impgine {
             attributeDescriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
             attributeDescriptions[2].offset = offsetof(Vertex, texCoord);
 
+            attributeDescriptions[3].binding = 0;
+            attributeDescriptions[3].location = 3;
+            attributeDescriptions[3].format = VK_FORMAT_R32G32B32_SFLOAT;
+            attributeDescriptions[3].offset = offsetof(Vertex, normal);
+
+            attributeDescriptions[4].binding = 0;
+            attributeDescriptions[4].location = 4;
+            attributeDescriptions[4].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+            attributeDescriptions[4].offset = offsetof(Vertex, tangent);
+
             return attributeDescriptions;
         }
+
+        // Position-only stream for depth-only passes; a tightly packed glm::vec3 per vertex
+        static VkVertexInputBindingDescription getPositionBindingDescription() {
+            VkVertexInputBindingDescription bindingDescription{};
+            bindingDescription.binding = 0;
+            bindingDescription.stride = sizeof(glm::vec3);
+            bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+            return bindingDescription;
+        }
+
+        static VkVertexInputAttributeDescription getPositionAttributeDescription() {
+            VkVertexInputAttributeDescription attributeDescription{};
+            attributeDescription.binding = 0;
+            attributeDescription.location = 0;
+            attributeDescription.format = VK_FORMAT_R32G32B32_SFLOAT;
+            attributeDescription.offset = 0;
+            return attributeDescription;
+        }
     };
 
     // External declaration of vertex data
@@ -74,6 +106,7 @@ namespace impgine {
         uint32_t subpass = 0;
     };
 
+    // An empty fragFilepath creates a pipeline without a fragment stage, for depth-only passes
     class Pipeline {
         public: Pipeline(VkDevice device,
             const std::string & vertFilepath,
@@ -89,9 +122,9 @@ namespace impgine {
         static void defaultPipelineConfigInfo(PipelineConfigInfo & configInfo);
         static void enableAlphaBlending(PipelineConfigInfo & configInfo);
 
-        private: static std::vector < char > readFile(const std::string & filepath);
+        static std::vector < char > readFile(const std::string & filepath);
 
-        void createGraphicsPipeline(const std::string & vertFilepath,
+        private: void createGraphicsPipeline(const std::string & vertFilepath,
             const std::string & fragFilepath,
                 const PipelineConfigInfo & configInfo);
 
@@ -99,8 +132,8 @@ namespace impgine {
 
         VkDevice device;
         VkPipeline graphicsPipeline;
-        VkShaderModule vertShaderModule;
-        VkShaderModule fragShaderModule;
+        VkShaderModule vertShaderModule = VK_NULL_HANDLE;
+        VkShaderModule fragShaderModule = VK_NULL_HANDLE;
     };
 
 } // namespace impgine
@@ -121,11 +154,20 @@ namespace std {
         }
     };
 
+    template<> struct hash<glm::vec4> {
+        size_t operator()(glm::vec4 const& vertex) const {
+            return ((hash<glm::vec3>()(glm::vec3(vertex)) ^
+                   (hash<float>()(vertex.w) << 1)) >> 1);
+        }
+    };
+
     template<> struct hash<impgine::Vertex> {
         size_t operator()(impgine::Vertex const& vertex) const {
-            return ((hash<glm::vec3>()(vertex.pos) ^
+            size_t seed = ((hash<glm::vec3>()(vertex.pos) ^
                    (hash<glm::vec3>()(vertex.color) << 1)) >> 1) ^
                    (hash<glm::vec2>()(vertex.texCoord) << 1);
+            return ((seed ^ (hash<glm::vec3>()(vertex.normal) << 1)) >> 1) ^
+                   (hash<glm::vec4>()(vertex.tangent) << 1);
         }
     };
 }
\ No newline at end of file
@@ -0,0 +1,50 @@
+#include "pipeline_layout.hpp"
+
+#include <cassert>
+#include <stdexcept>
+
+namespace impgine {
+
+    PipelineLayoutBuilder::PipelineLayoutBuilder(VkDevice device): device {
+        device
+    } {}
+
+    PipelineLayoutBuilder & PipelineLayoutBuilder::addDescriptorSetLayout(VkDescriptorSetLayout setLayout) {
+        assert(setLayout != VK_NULL_HANDLE && "Cannot add a null descriptor set layout");
+        setLayouts.push_back(setLayout);
+        return * this;
+    }
+
+    PipelineLayoutBuilder & PipelineLayoutBuilder::addPushConstantRange(VkShaderStageFlags stageFlags,
+        uint32_t size, uint32_t offset) {
+        assert(size % 4 == 0 && offset % 4 == 0 && "Push constant ranges must be 4-byte aligned");
+
+        // Anything above the guaranteed minimum would silently break on some devices
+        if (offset + size > MIN_PUSH_CONSTANTS_SIZE) {
+            throw std::runtime_error("push constant range exceeds the guaranteed 128 bytes!");
+        }
+
+        VkPushConstantRange range {};
+        range.stageFlags = stageFlags;
+        range.offset = offset;
+        range.size = size;
+        pushConstantRanges.push_back(range);
+        return * this;
+    }
+
+    VkPipelineLayout PipelineLayoutBuilder::build() const {
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo {};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = static_cast < uint32_t > (setLayouts.size());
+        pipelineLayoutInfo.pSetLayouts = setLayouts.empty() ? nullptr : setLayouts.data();
+        pipelineLayoutInfo.pushConstantRangeCount = static_cast < uint32_t > (pushConstantRanges.size());
+        pipelineLayoutInfo.pPushConstantRanges = pushConstantRanges.empty() ? nullptr : pushConstantRanges.data();
+
+        VkPipelineLayout pipelineLayout;
+        if (vkCreatePipelineLayout(device, & pipelineLayoutInfo, nullptr, & pipelineLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create pipeline layout!");
+        }
+        return pipelineLayout;
+    }
+
+} // namespace impgine
\ No newline at end of file
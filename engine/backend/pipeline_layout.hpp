@@ -0,0 +1,27 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+
+namespace impgine {
+
+    // Collects descriptor set layouts and push-constant ranges and creates a
+    // VkPipelineLayout from them. The caller owns the returned layout.
+    class PipelineLayoutBuilder {
+        public: static constexpr uint32_t MIN_PUSH_CONSTANTS_SIZE = 128; // guaranteed by the spec
+
+        explicit PipelineLayoutBuilder(VkDevice device);
+
+        PipelineLayoutBuilder & addDescriptorSetLayout(VkDescriptorSetLayout setLayout);
+        PipelineLayoutBuilder & addPushConstantRange(VkShaderStageFlags stageFlags, uint32_t size,
+            uint32_t offset = 0);
+
+        VkPipelineLayout build() const;
+
+        private: VkDevice device;
+        std::vector < VkDescriptorSetLayout > setLayouts;
+        std::vector < VkPushConstantRange > pushConstantRanges;
+    };
+
+} // namespace impgine
\ No newline at end of file
@@ -0,0 +1,601 @@
+#include "shadow_maps.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "pipeline_layout.hpp"
+
+namespace impgine {
+
+    namespace {
+
+        // Cached bounds are this much larger than the slice, so the camera can
+        // move a little before a cascade has to be rendered again
+        constexpr float CACHE_MARGIN = 0.25f;
+        // Re-fit once the slice needs less than half the cached radius (a zoom)
+        constexpr float REFIT_RATIO = 0.5f;
+        // Any larger turn of the light invalidates the caches (about 0.25 degrees)
+        constexpr float LIGHT_ANGLE_THRESHOLD = 0.0044f;
+        // Casters this far towards the light from a cascade still shadow it
+        constexpr float CASTER_DISTANCE = 20.0f;
+        // Blend between uniform (0) and logarithmic (1) cascade splits
+        constexpr float SPLIT_LAMBDA = 0.75f;
+
+        constexpr float DEPTH_BIAS_CONSTANT = 1.25f;
+        constexpr float DEPTH_BIAS_SLOPE = 1.75f;
+
+        glm::vec3 lightUp(const glm::vec3 & lightDirection) {
+            return std::abs(lightDirection.z) > 0.99f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(0.0f, 0.0f, 1.0f);
+        }
+
+    } // namespace
+
+    ShadowMaps::ShadowMaps(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t size, uint32_t frameCount): device {
+        device
+    }, physicalDevice {
+        physicalDevice
+    }, size {
+        size
+    } {
+        findDepthFormat();
+        createImage(VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, cacheImage,
+            cacheImageMemory);
+        createImage(VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT |
+            VK_IMAGE_USAGE_SAMPLED_BIT, shadowImage, shadowImageMemory);
+        shadowArrayView = createImageView(shadowImage, VK_IMAGE_VIEW_TYPE_2D_ARRAY, 0, CASCADE_COUNT);
+
+        clearPass = createRenderPass(VK_ATTACHMENT_LOAD_OP_CLEAR);
+        loadPass = createRenderPass(VK_ATTACHMENT_LOAD_OP_LOAD);
+        for (VkImage image: {
+                cacheImage, shadowImage
+            }) {
+            for (uint32_t layer = 0; layer < CASCADE_COUNT; layer++) {
+                layerViews.push_back(createImageView(image, VK_IMAGE_VIEW_TYPE_2D, layer, 1));
+
+                VkFramebufferCreateInfo framebufferInfo {};
+                framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+                framebufferInfo.renderPass = clearPass;
+                framebufferInfo.attachmentCount = 1;
+                framebufferInfo.pAttachments = & layerViews.back();
+                framebufferInfo.width = size;
+                framebufferInfo.height = size;
+                framebufferInfo.layers = 1;
+
+                VkFramebuffer framebuffer;
+                if (vkCreateFramebuffer(device, & framebufferInfo, nullptr, & framebuffer) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to create shadow map framebuffer!");
+                }
+                (image == cacheImage ? cacheFramebuffers : shadowFramebuffers).push_back(framebuffer);
+            }
+        }
+
+        for (uint32_t i = 0; i < frameCount; i++) {
+            paramBuffers.push_back(std::make_unique < Buffer > (device, physicalDevice, sizeof(Params), 1,
+                VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
+            paramBuffers.back() -> map();
+        }
+        framePlans.resize(frameCount);
+
+        createDescriptors();
+        createPipeline();
+    }
+
+    ShadowMaps::~ShadowMaps() {
+        pipeline.reset();
+        vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+        vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+        vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+        vkDestroySampler(device, sampler, nullptr);
+        for (VkFramebuffer framebuffer: cacheFramebuffers) {
+            vkDestroyFramebuffer(device, framebuffer, nullptr);
+        }
+        for (VkFramebuffer framebuffer: shadowFramebuffers) {
+            vkDestroyFramebuffer(device, framebuffer, nullptr);
+        }
+        vkDestroyRenderPass(device, clearPass, nullptr);
+        vkDestroyRenderPass(device, loadPass, nullptr);
+        for (VkImageView view: layerViews) {
+            vkDestroyImageView(device, view, nullptr);
+        }
+        vkDestroyImageView(device, shadowArrayView, nullptr);
+        vkDestroyImage(device, shadowImage, nullptr);
+        vkFreeMemory(device, shadowImageMemory, nullptr);
+        vkDestroyImage(device, cacheImage, nullptr);
+        vkFreeMemory(device, cacheImageMemory, nullptr);
+    }
+
+    void ShadowMaps::findDepthFormat() {
+        VkFormatFeatureFlags required = VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+        for (VkFormat format: {
+                VK_FORMAT_D32_SFLOAT, VK_FORMAT_D16_UNORM
+            }) {
+            VkFormatProperties properties;
+            vkGetPhysicalDeviceFormatProperties(physicalDevice, format, & properties);
+            VkFormatFeatureFlags features = required | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+            if ((properties.optimalTilingFeatures & features) == features) {
+                depthFormat = format;
+                linearFiltering = true;
+                return;
+            }
+        }
+
+        // D16 is the only format guaranteed to be both attachable and sampled, but
+        // not filtered; without that the maps are sampled with NEAREST
+        depthFormat = VK_FORMAT_D16_UNORM;
+        VkFormatProperties properties;
+        vkGetPhysicalDeviceFormatProperties(physicalDevice, depthFormat, & properties);
+        linearFiltering = (properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT) != 0;
+    }
+
+    void ShadowMaps::createImage(VkImageUsageFlags usage, VkImage & image, VkDeviceMemory & imageMemory) {
+        VkImageCreateInfo imageInfo {};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent.width = size;
+        imageInfo.extent.height = size;
+        imageInfo.extent.depth = 1;
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = CASCADE_COUNT;
+        imageInfo.format = depthFormat;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.usage = usage;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        if (vkCreateImage(device, & imageInfo, nullptr, & image) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create shadow map image!");
+        }
+
+        VkMemoryRequirements memRequirements;
+        vkGetImageMemoryRequirements(device, image, & memRequirements);
+
+        VkMemoryAllocateInfo allocInfo {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = memRequirements.size;
+        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        if (vkAllocateMemory(device, & allocInfo, nullptr, & imageMemory) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate shadow map memory!");
+        }
+        vkBindImageMemory(device, image, imageMemory, 0);
+    }
+
+    VkImageView ShadowMaps::createImageView(VkImage image, VkImageViewType viewType, uint32_t baseLayer,
+        uint32_t layerCount) {
+        VkImageViewCreateInfo viewInfo {};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = image;
+        viewInfo.viewType = viewType;
+        viewInfo.format = depthFormat;
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+        viewInfo.subresourceRange.baseMipLevel = 0;
+        viewInfo.subresourceRange.levelCount = 1;
+        viewInfo.subresourceRange.baseArrayLayer = baseLayer;
+        viewInfo.subresourceRange.layerCount = layerCount;
+
+        VkImageView imageView;
+        if (vkCreateImageView(device, & viewInfo, nullptr, & imageView) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create shadow map image view!");
+        }
+        return imageView;
+    }
+
+    VkRenderPass ShadowMaps::createRenderPass(VkAttachmentLoadOp loadOp) {
+        // Layouts are transitioned with explicit barriers around the pass
+        VkAttachmentDescription depthAttachment {};
+        depthAttachment.format = depthFormat;
+        depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+        depthAttachment.loadOp = loadOp;
+        depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depthAttachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+        VkAttachmentReference depthAttachmentRef {};
+        depthAttachmentRef.attachment = 0;
+        depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+        VkSubpassDescription subpass {};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = 0;
+        subpass.pDepthStencilAttachment = & depthAttachmentRef;
+
+        VkRenderPassCreateInfo renderPassInfo {};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        renderPassInfo.attachmentCount = 1;
+        renderPassInfo.pAttachments = & depthAttachment;
+        renderPassInfo.subpassCount = 1;
+        renderPassInfo.pSubpasses = & subpass;
+
+        VkRenderPass renderPass;
+        if (vkCreateRenderPass(device, & renderPassInfo, nullptr, & renderPass) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create shadow map render pass!");
+        }
+        return renderPass;
+    }
+
+    void ShadowMaps::createDescriptors() {
+        // Hardware PCF: each lookup compares and filters a 2x2 footprint, or
+        // just compares where the format can't be filtered.
+        // Outside the maps everything is lit
+        VkFilter filter = linearFiltering ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+        VkSamplerCreateInfo samplerInfo {};
+        samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        samplerInfo.magFilter = filter;
+        samplerInfo.minFilter = filter;
+        samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+        samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+        samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+        samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+        samplerInfo.compareEnable = VK_TRUE;
+        samplerInfo.compareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+        samplerInfo.maxLod = 0.0f;
+
+        if (vkCreateSampler(device, & samplerInfo, nullptr, & sampler) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create shadow map sampler!");
+        }
+
+        std::array < VkDescriptorSetLayoutBinding, 2 > bindings {};
+        bindings[0].binding = 0;
+        bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        bindings[0].descriptorCount = 1;
+        bindings[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+        bindings[1].binding = 1;
+        bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        bindings[1].descriptorCount = 1;
+        bindings[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+        VkDescriptorSetLayoutCreateInfo layoutInfo {};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = static_cast < uint32_t > (bindings.size());
+        layoutInfo.pBindings = bindings.data();
+        if (vkCreateDescriptorSetLayout(device, & layoutInfo, nullptr, & descriptorSetLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create shadow map descriptor set layout!");
+        }
+
+        uint32_t frameCount = static_cast < uint32_t > (paramBuffers.size());
+        std::array < VkDescriptorPoolSize, 2 > poolSizes {};
+        poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        poolSizes[0].descriptorCount = frameCount;
+        poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        poolSizes[1].descriptorCount = frameCount;
+
+        VkDescriptorPoolCreateInfo poolInfo {};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.poolSizeCount = static_cast < uint32_t > (poolSizes.size());
+        poolInfo.pPoolSizes = poolSizes.data();
+        poolInfo.maxSets = frameCount;
+        if (vkCreateDescriptorPool(device, & poolInfo, nullptr, & descriptorPool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create shadow map descriptor pool!");
+        }
+
+        std::vector < VkDescriptorSetLayout > layouts(frameCount, descriptorSetLayout);
+        VkDescriptorSetAllocateInfo allocInfo {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = descriptorPool;
+        allocInfo.descriptorSetCount = frameCount;
+        allocInfo.pSetLayouts = layouts.data();
+        descriptorSets.resize(frameCount);
+        if (vkAllocateDescriptorSets(device, & allocInfo, descriptorSets.data()) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate shadow map descriptor sets!");
+        }
+
+        for (uint32_t i = 0; i < frameCount; i++) {
+            VkDescriptorBufferInfo bufferInfo = paramBuffers[i] -> descriptorInfo();
+
+            VkDescriptorImageInfo imageInfo {};
+            imageInfo.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+            imageInfo.imageView = shadowArrayView;
+            imageInfo.sampler = sampler;
+
+            std::array < VkWriteDescriptorSet, 2 > writes {};
+            writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[0].dstSet = descriptorSets[i];
+            writes[0].dstBinding = 0;
+            writes[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            writes[0].descriptorCount = 1;
+            writes[0].pBufferInfo = & bufferInfo;
+            writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[1].dstSet = descriptorSets[i];
+            writes[1].dstBinding = 1;
+            writes[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            writes[1].descriptorCount = 1;
+            writes[1].pImageInfo = & imageInfo;
+            vkUpdateDescriptorSets(device, static_cast < uint32_t > (writes.size()), writes.data(), 0, nullptr);
+        }
+    }
+
+    void ShadowMaps::createPipeline() {
+        // Each draw pushes its model matrix premultiplied by the cascade's
+        pipelineLayout = PipelineLayoutBuilder(device)
+            .addPushConstantRange(VK_SHADER_STAGE_VERTEX_BIT, sizeof(glm::mat4))
+            .build();
+
+        // Depth only, from the position stream. Culling is off because the
+        // scene's meshes aren't closed; the slope-scaled bias fights acne instead
+        PipelineConfigInfo pipelineConfig {};
+        Pipeline::defaultPipelineConfigInfo(pipelineConfig);
+        pipelineConfig.bindingDescriptions = {
+            Vertex::getPositionBindingDescription()
+        };
+        pipelineConfig.attributeDescriptions = {
+            Vertex::getPositionAttributeDescription()
+        };
+        pipelineConfig.rasterizationInfo.cullMode = VK_CULL_MODE_NONE;
+        pipelineConfig.rasterizationInfo.depthBiasEnable = VK_TRUE;
+        pipelineConfig.rasterizationInfo.depthBiasConstantFactor = DEPTH_BIAS_CONSTANT;
+        pipelineConfig.rasterizationInfo.depthBiasSlopeFactor = DEPTH_BIAS_SLOPE;
+        pipelineConfig.colorBlendInfo.attachmentCount = 0;
+        pipelineConfig.colorBlendInfo.pAttachments = nullptr;
+        pipelineConfig.renderPass = clearPass; // compatible with loadPass
+        pipelineConfig.pipelineLayout = pipelineLayout;
+        pipeline = std::make_unique < Pipeline > (device, "shaders/shadow_vert.spv", "", pipelineConfig);
+    }
+
+    uint32_t ShadowMaps::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const {
+        VkPhysicalDeviceMemoryProperties memProperties;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, & memProperties);
+
+        for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+            if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+                return i;
+            }
+        }
+
+        throw std::runtime_error("failed to find suitable memory type!");
+    }
+
+    void ShadowMaps::fitCascade(Cascade & cascade, const glm::vec3 & center, float radius,
+        const glm::vec3 & lightDirection) const {
+        cascade.radius = radius * (1.0f + CACHE_MARGIN);
+        cascade.lightDirection = lightDirection;
+
+        // Snap the center to whole texels across the light so re-fits don't make the edges crawl
+        glm::vec3 up = lightUp(lightDirection);
+        glm::mat4 lightRotation = glm::lookAt(glm::vec3(0.0f), lightDirection, up);
+        glm::vec3 lightSpaceCenter = glm::vec3(lightRotation * glm::vec4(center, 1.0f));
+        float texelSize = 2.0f * cascade.radius / static_cast < float > (size);
+        lightSpaceCenter.x = std::floor(lightSpaceCenter.x / texelSize) * texelSize;
+        lightSpaceCenter.y = std::floor(lightSpaceCenter.y / texelSize) * texelSize;
+        cascade.center = glm::vec3(glm::inverse(lightRotation) * glm::vec4(lightSpaceCenter, 1.0f));
+
+        float depthRange = 2.0f * cascade.radius + CASTER_DISTANCE;
+        glm::mat4 lightView = glm::lookAt(cascade.center - lightDirection * (cascade.radius + CASTER_DISTANCE),
+            cascade.center, up);
+        glm::mat4 lightProjection = glm::ortho(-cascade.radius, cascade.radius, -cascade.radius, cascade.radius,
+            0.0f, depthRange);
+        cascade.viewProjection = lightProjection * lightView;
+    }
+
+    void ShadowMaps::update(uint32_t frameIndex, const glm::mat4 & view, const glm::mat4 & proj,
+        const DirectionalLight & light, bool castShadows) {
+        glm::vec3 lightDirection = glm::normalize(light.direction);
+        FramePlan & plan = framePlans[frameIndex];
+        plan.castShadows = castShadows && light.intensity > 0.0f;
+        plan.staticMask = 0;
+
+        Params params {};
+        params.lightDirection = glm::vec4(lightDirection, plan.castShadows ? 1.0f : 0.0f);
+        params.lightColor = glm::vec4(light.color * light.intensity, 0.0f);
+
+        // Same plane recovery as the light culling; the frustum's half-extents
+        // per unit of view depth come from the scale terms
+        float near = proj[3][2] / proj[2][2];
+        float far = std::min(proj[3][2] / (proj[2][2] + 1.0f), MAX_SHADOW_DISTANCE);
+        float tanHalfX = 1.0f / std::abs(proj[0][0]);
+        float tanHalfY = 1.0f / std::abs(proj[1][1]);
+        float cornerSlope = tanHalfX * tanHalfX + tanHalfY * tanHalfY;
+        glm::mat4 inverseView = glm::inverse(view);
+
+        float sliceNear = near;
+        for (uint32_t i = 0; i < CASCADE_COUNT; i++) {
+            float fraction = static_cast < float > (i + 1) / CASCADE_COUNT;
+            float uniformSplit = near + (far - near) * fraction;
+            float logSplit = near * std::pow(far / near, fraction);
+            float sliceFar = uniformSplit + (logSplit - uniformSplit) * SPLIT_LAMBDA;
+            params.cascadeSplits[i] = sliceFar;
+
+            // Smallest sphere around the slice, centred on the view axis. It
+            // doesn't change as the camera turns, so neither does the cascade
+            float centerDepth = std::min(0.5f * (sliceNear + sliceFar) * (1.0f + cornerSlope), sliceFar);
+            float radius = std::sqrt((sliceFar - centerDepth) * (sliceFar - centerDepth) +
+                sliceFar * sliceFar * cornerSlope);
+            glm::vec3 center = glm::vec3(inverseView * glm::vec4(0.0f, 0.0f, -centerDepth, 1.0f));
+            sliceNear = sliceFar;
+
+            Cascade & cascade = cascades[i];
+            if (plan.castShadows) {
+                bool stillCovered = cascade.cached &&
+                    glm::dot(lightDirection, cascade.lightDirection) >= std::cos(LIGHT_ANGLE_THRESHOLD) &&
+                    glm::length(center - cascade.center) + radius <= cascade.radius &&
+                    radius >= cascade.radius * REFIT_RATIO;
+                if (!stillCovered) {
+                    fitCascade(cascade, center, radius, lightDirection);
+                    cascade.cached = true;
+                    plan.staticMask |= 1u << i;
+                }
+            }
+            plan.viewProjections[i] = cascade.viewProjection;
+            params.cascadeViewProjections[i] = cascade.viewProjection;
+        }
+
+        paramBuffers[frameIndex] -> writeToBuffer( & params, sizeof(params));
+    }
+
+    void ShadowMaps::layerBarrier(VkCommandBuffer commandBuffer, VkImage image, uint32_t layer,
+        VkImageLayout oldLayout, VkImageLayout newLayout, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess,
+        VkPipelineStageFlags dstStage, VkAccessFlags dstAccess) const {
+        VkImageMemoryBarrier barrier {};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = oldLayout;
+        barrier.newLayout = newLayout;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = 1;
+        barrier.subresourceRange.baseArrayLayer = layer;
+        barrier.subresourceRange.layerCount = 1;
+        barrier.srcAccessMask = srcAccess;
+        barrier.dstAccessMask = dstAccess;
+        vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, & barrier);
+    }
+
+    void ShadowMaps::drawCasters(VkCommandBuffer commandBuffer, VkRenderPass pass, VkFramebuffer framebuffer,
+        const glm::mat4 & viewProjection, const std::vector < DrawItem > & drawList, bool dynamic) const {
+        VkClearValue clearValue {};
+        clearValue.depthStencil = {
+            1.0f,
+            0
+        };
+
+        VkRenderPassBeginInfo renderPassInfo {};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassInfo.renderPass = pass;
+        renderPassInfo.framebuffer = framebuffer;
+        renderPassInfo.renderArea.offset = {
+            0,
+            0
+        };
+        renderPassInfo.renderArea.extent = {
+            size,
+            size
+        };
+        renderPassInfo.clearValueCount = 1;
+        renderPassInfo.pClearValues = & clearValue;
+        vkCmdBeginRenderPass(commandBuffer, & renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+        VkViewport viewport {};
+        viewport.width = static_cast < float > (size);
+        viewport.height = static_cast < float > (size);
+        viewport.maxDepth = 1.0f;
+        vkCmdSetViewport(commandBuffer, 0, 1, & viewport);
+        VkRect2D scissor {};
+        scissor.extent = {
+            size,
+            size
+        };
+        vkCmdSetScissor(commandBuffer, 0, 1, & scissor);
+
+        pipeline -> bind(commandBuffer);
+        for (const auto & item: drawList) {
+            if (item.dynamic != dynamic) {
+                continue;
+            }
+            glm::mat4 transform = viewProjection * item.model;
+            vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(transform),
+                & transform);
+            vkCmdDrawIndexed(commandBuffer, item.indexCount, 1, item.firstIndex, item.vertexOffset, 0);
+        }
+
+        vkCmdEndRenderPass(commandBuffer);
+    }
+
+    void ShadowMaps::record(VkCommandBuffer commandBuffer, uint32_t frameIndex, const std::vector < DrawItem > & drawList,
+        VkBuffer positionBuffer, VkBuffer indexBuffer, GpuProfiler * profiler) {
+        const FramePlan & plan = framePlans[frameIndex];
+
+        // The maps are sampled even while no shadows are cast, so they need a valid layout
+        if (!plan.castShadows) {
+            if (!shadowImageInitialized) {
+                for (uint32_t i = 0; i < CASCADE_COUNT; i++) {
+                    layerBarrier(commandBuffer, shadowImage, i, VK_IMAGE_LAYOUT_UNDEFINED,
+                        VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0,
+                        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+                }
+                shadowImageInitialized = true;
+            }
+            for (Cascade & cascade: cascades) {
+                cascade.dynamicDrawn = false;
+            }
+            return;
+        }
+
+        bool hasDynamic = std::any_of(drawList.begin(), drawList.end(), [](const DrawItem & item) {
+            return item.dynamic;
+        });
+
+        VkBuffer positionBuffers[] = {
+            positionBuffer
+        };
+        VkDeviceSize offsets[] = {
+            0
+        };
+        vkCmdBindVertexBuffers(commandBuffer, 0, 1, positionBuffers, offsets);
+        vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+
+        if (plan.staticMask != 0) {
+            GpuProfiler::Scope cacheScope(profiler, commandBuffer, "shadow cache");
+            for (uint32_t i = 0; i < CASCADE_COUNT; i++) {
+                if (!(plan.staticMask & (1u << i))) {
+                    continue;
+                }
+                // Cleared by the pass, so the old contents (and the last copy reading them) don't matter
+                layerBarrier(commandBuffer, cacheImage, i, VK_IMAGE_LAYOUT_UNDEFINED,
+                    VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                    VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT);
+                drawCasters(commandBuffer, clearPass, cacheFramebuffers[i], plan.viewProjections[i], drawList, false);
+                layerBarrier(commandBuffer, cacheImage, i, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+                    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                    VK_ACCESS_TRANSFER_READ_BIT);
+                cacheRenderCount++;
+            }
+        }
+
+        GpuProfiler::Scope dynamicScope(profiler, commandBuffer, "shadow dynamic");
+        for (uint32_t i = 0; i < CASCADE_COUNT; i++) {
+            // Untouched maps still hold exactly the cache
+            Cascade & cascade = cascades[i];
+            bool refreshed = (plan.staticMask & (1u << i)) || !shadowImageInitialized;
+            if (!refreshed && !hasDynamic && !cascade.dynamicDrawn) {
+                continue;
+            }
+
+            layerBarrier(commandBuffer, shadowImage, i, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+            VkImageCopy region {};
+            region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+            region.srcSubresource.baseArrayLayer = i;
+            region.srcSubresource.layerCount = 1;
+            region.dstSubresource = region.srcSubresource;
+            region.extent = {
+                size,
+                size,
+                1
+            };
+            vkCmdCopyImage(commandBuffer, cacheImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, shadowImage,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, & region);
+
+            if (hasDynamic) {
+                layerBarrier(commandBuffer, shadowImage, i, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                    VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                    VK_ACCESS_TRANSFER_WRITE_BIT,
+                    VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT);
+                drawCasters(commandBuffer, loadPass, shadowFramebuffers[i], plan.viewProjections[i], drawList, true);
+                layerBarrier(commandBuffer, shadowImage, i, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+                    VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                    VK_ACCESS_SHADER_READ_BIT);
+            } else {
+                layerBarrier(commandBuffer, shadowImage, i, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                    VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                    VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+            }
+            cascade.dynamicDrawn = hasDynamic;
+        }
+        shadowImageInitialized = true;
+    }
+
+} // namespace impgine
\ No newline at end of file
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#define GLM_FORCE_DEFAULT_ALIGNED_GENTYPES
+#include <glm/glm.hpp>
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "../directional_light.hpp"
+#include "../frame_snapshot.hpp"
+#include "../profiling/gpu_profiler.hpp"
+#include "buffers.hpp"
+#include "pipeline.hpp"
+
+namespace impgine {
+
+    // Cascaded shadow maps for the directional light. The camera frustum up to
+    // MAX_SHADOW_DISTANCE is split into CASCADE_COUNT slices, each covered by
+    // an orthographic depth map rendered from the position stream.
+    //
+    // Static draws are rendered into a cache per cascade, and only again once
+    // the light turns or the slice leaves the cached bounds, which are fitted
+    // with some margin. Every frame that has dynamic draws copies the cache
+    // into the sampled maps and renders those on top. Static draws are assumed
+    // never to change.
+    //
+    // The shading descriptor set (the light, cascade matrices and splits, and
+    // the sampled maps) is used as set 2 of the main pipeline layout.
+    class ShadowMaps {
+        public: static constexpr uint32_t CASCADE_COUNT = 4; // must match shader.frag
+        static constexpr float MAX_SHADOW_DISTANCE = 40.0f;
+
+        // `size` is the width and height of each cascade's map
+        ShadowMaps(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t size, uint32_t frameCount);
+        ~ShadowMaps();
+
+        // Delete copy constructor and assignment operator
+        ShadowMaps(const ShadowMaps & ) = delete;
+        ShadowMaps & operator = (const ShadowMaps & ) = delete;
+
+        VkDescriptorSetLayout getDescriptorSetLayout() const {
+            return descriptorSetLayout;
+        }
+        VkDescriptorSet getDescriptorSet(uint32_t frameIndex) const {
+            return descriptorSets[frameIndex];
+        }
+        // Static cache renders so far, across all cascades
+        uint64_t getCacheRenderCount() const {
+            return cacheRenderCount;
+        }
+
+        // Fits the cascades to the camera and decides which caches to
+        // re-render. Without `castShadows` the light is shaded unshadowed
+        void update(uint32_t frameIndex, const glm::mat4 & view, const glm::mat4 & proj,
+            const DirectionalLight & light, bool castShadows);
+
+        // Renders what update() decided for this frame, outside of any render pass
+        void record(VkCommandBuffer commandBuffer, uint32_t frameIndex, const std::vector < DrawItem > & drawList,
+            VkBuffer positionBuffer, VkBuffer indexBuffer, GpuProfiler * profiler);
+
+        private: struct Params {
+            glm::mat4 cascadeViewProjections[CASCADE_COUNT];
+            glm::vec4 cascadeSplits; // view depth at which each cascade ends
+            glm::vec4 lightDirection; // w = 1 when casting shadows
+            glm::vec4 lightColor; // premultiplied by the intensity
+        };
+
+        struct Cascade {
+            glm::mat4 viewProjection {
+                1.0f
+            };
+            glm::vec3 center {
+                0.0f
+            };
+            float radius = 0.0f;
+            glm::vec3 lightDirection {
+                0.0f
+            };
+            bool cached = false; // the cache holds the static depth for the above
+            bool dynamicDrawn = false; // the sampled map has dynamic depth on top of the cache
+        };
+
+        struct FramePlan {
+            bool castShadows = false;
+            uint32_t staticMask = 0; // cascades whose cache is re-rendered
+            std::array < glm::mat4, CASCADE_COUNT > viewProjections;
+        };
+
+        // Picks depthFormat and whether it can be filtered, which the sampler needs
+        void findDepthFormat();
+        void createImage(VkImageUsageFlags usage, VkImage & image, VkDeviceMemory & imageMemory);
+        VkImageView createImageView(VkImage image, VkImageViewType viewType, uint32_t baseLayer, uint32_t layerCount);
+        VkRenderPass createRenderPass(VkAttachmentLoadOp loadOp);
+        void createDescriptors();
+        void createPipeline();
+        uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+
+        void fitCascade(Cascade & cascade, const glm::vec3 & center, float radius, const glm::vec3 & lightDirection) const;
+        void layerBarrier(VkCommandBuffer commandBuffer, VkImage image, uint32_t layer, VkImageLayout oldLayout,
+            VkImageLayout newLayout, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess,
+            VkPipelineStageFlags dstStage, VkAccessFlags dstAccess) const;
+        void drawCasters(VkCommandBuffer commandBuffer, VkRenderPass pass, VkFramebuffer framebuffer,
+            const glm::mat4 & viewProjection, const std::vector < DrawItem > & drawList, bool dynamic) const;
+
+        VkDevice device;
+        VkPhysicalDevice physicalDevice;
+        uint32_t size;
+        VkFormat depthFormat;
+        bool linearFiltering = false;
+
+        // Static depth per cascade, and the maps that are sampled
+        VkImage cacheImage = VK_NULL_HANDLE;
+        VkDeviceMemory cacheImageMemory = VK_NULL_HANDLE;
+        VkImage shadowImage = VK_NULL_HANDLE;
+        VkDeviceMemory shadowImageMemory = VK_NULL_HANDLE;
+        VkImageView shadowArrayView = VK_NULL_HANDLE;
+        std::vector < VkImageView > layerViews; // cache layers, then shadow layers
+        std::vector < VkFramebuffer > cacheFramebuffers;
+        std::vector < VkFramebuffer > shadowFramebuffers;
+        VkSampler sampler = VK_NULL_HANDLE;
+        bool shadowImageInitialized = false;
+
+        VkRenderPass clearPass = VK_NULL_HANDLE;
+        VkRenderPass loadPass = VK_NULL_HANDLE;
+        VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+        std::unique_ptr < Pipeline > pipeline;
+
+        std::vector < std::unique_ptr < Buffer >> paramBuffers;
+        VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+        VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+        std::vector < VkDescriptorSet > descriptorSets;
+
+        std::array < Cascade, CASCADE_COUNT > cascades;
+        std::vector < FramePlan > framePlans;
+        uint64_t cacheRenderCount = 0;
+    };
+
+} // namespace impgine
\ No newline at end of file
@@ -1,17 +1,24 @@
 #include "swap_chain.hpp"
 
 #include <algorithm>
+#include <array>
 #include <iostream>
 #include <limits>
 #include <stdexcept>
+#include <utility>
 
 #include "window.hpp"
 
 namespace impgine {
 
     SwapChain::SwapChain(VkDevice device, VkPhysicalDevice physicalDevice, VkSurfaceKHR surface,
-        Window & window): device(device), physicalDevice(physicalDevice), surface(surface), windowRef(window) {
+        Window & window, VkPresentModeKHR preferredPresentMode, SwapChain * previous): device(device),
+        physicalDevice(physicalDevice), surface(surface), windowRef(window), oldSwapChain(previous),
+        preferredPresentMode(preferredPresentMode) {
         init();
+
+        // Only needed while creating; the owner decides when the old one dies
+        oldSwapChain = nullptr;
     }
 
     SwapChain::~SwapChain() {
@@ -19,9 +26,12 @@ namespace impgine {
 
         vkDestroyRenderPass(device, renderPass, nullptr);
 
-        // cleanup synchronization objects
-        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        // cleanup synchronization objects (empty if a successor adopted them)
+        for (size_t i = 0; i < imageAvailableSemaphores.size(); i++) {
             vkDestroySemaphore(device, imageAvailableSemaphores[i], nullptr);
+        }
+
+        for (size_t i = 0; i < inFlightFences.size(); i++) {
             vkDestroyFence(device, inFlightFences[i], nullptr);
         }
         
@@ -34,6 +44,9 @@ namespace impgine {
         VkResult result = vkAcquireNextImageKHR(device, swapChain, std::numeric_limits < uint64_t > ::max(),
             imageAvailableSemaphore,
             VK_NULL_HANDLE, imageIndex);
+        if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+            return result; // imageIndex is undefined
+        }
 
         // Check if this image is already being used by another frame
         if (imagesInFlight[ * imageIndex] != VK_NULL_HANDLE) {
@@ -84,7 +97,7 @@ namespace impgine {
         SwapChainSupportDetails swapChainSupport = querySwapChainSupport(physicalDevice, surface);
 
         VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
-        VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
+        presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
         VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities);
 
         uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
@@ -102,7 +115,10 @@ namespace impgine {
         createInfo.imageColorSpace = surfaceFormat.colorSpace;
         createInfo.imageExtent = extent;
         createInfo.imageArrayLayers = 1;
-        createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        // Transfer writes are optional for swapchain images; only request them where supported
+        imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+            (swapChainSupport.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+        createInfo.imageUsage = imageUsage;
 
         // For now, assume single queue family (graphics == present)
         createInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
@@ -115,7 +131,8 @@ namespace impgine {
         createInfo.presentMode = presentMode;
         createInfo.clipped = VK_TRUE;
 
-        createInfo.oldSwapchain = VK_NULL_HANDLE;
+        // Lets the driver reuse resources and keep presenting the old images meanwhile
+        createInfo.oldSwapchain = oldSwapChain == nullptr ? VK_NULL_HANDLE : oldSwapChain->swapChain;
 
         if (vkCreateSwapchainKHR(device, & createInfo, nullptr, & swapChain) != VK_SUCCESS) {
             throw std::runtime_error("failed to create swap chain!");
@@ -300,14 +317,34 @@ namespace impgine {
     }
 
     void SwapChain::createSyncObjects() {
-        imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
         renderFinishedSemaphores.resize(imageCount());
-        inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
         imagesInFlight.resize(imageCount(), VK_NULL_HANDLE);
 
         VkSemaphoreCreateInfo semaphoreInfo = {};
         semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
+        // Create renderFinished semaphores per swapchain image. The old swapchain
+        // keeps its own since pending presents may still wait on them
+        for (size_t i = 0; i < imageCount(); i++) {
+            if (vkCreateSemaphore(device, & semaphoreInfo, nullptr, & renderFinishedSemaphores[i]) !=
+                VK_SUCCESS) {
+                throw std::runtime_error("failed to create render finished semaphore!");
+            }
+        }
+
+        // Per-frame objects belong to the frame loop, not to the images, so carry
+        // them over; the fences of frames in flight must survive recreation
+        if (oldSwapChain != nullptr) {
+            imageAvailableSemaphores = std::move(oldSwapChain->imageAvailableSemaphores);
+            inFlightFences = std::move(oldSwapChain->inFlightFences);
+            oldSwapChain->imageAvailableSemaphores.clear();
+            oldSwapChain->inFlightFences.clear();
+            return;
+        }
+
+        imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
+        inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
+
         VkFenceCreateInfo fenceInfo = {};
         fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
         fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
@@ -320,14 +357,6 @@ namespace impgine {
             }
         }
 
-        // Create renderFinished semaphores per swapchain image
-        for (size_t i = 0; i < imageCount(); i++) {
-            if (vkCreateSemaphore(device, & semaphoreInfo, nullptr, & renderFinishedSemaphores[i]) !=
-                VK_SUCCESS) {
-                throw std::runtime_error("failed to create render finished semaphore!");
-            }
-        }
-
         // Create fences per frame in flight
         for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
             if (vkCreateFence(device, & fenceInfo, nullptr, & inFlightFences[i]) != VK_SUCCESS) {
@@ -350,17 +379,58 @@ namespace impgine {
 
     VkPresentModeKHR SwapChain::chooseSwapPresentMode(
         const std::vector < VkPresentModeKHR > & availablePresentModes) {
-        for (const auto & availablePresentMode: availablePresentModes) {
-            if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
-                std::cout << "Present mode: Mailbox" << std::endl;
-                return availablePresentMode;
+        // Each preference degrades towards the closest available behaviour;
+        // FIFO is the only mode the spec guarantees, so every chain ends there
+        std::vector < VkPresentModeKHR > candidates;
+        switch (preferredPresentMode) {
+        case VK_PRESENT_MODE_IMMEDIATE_KHR:
+            candidates = {
+                VK_PRESENT_MODE_IMMEDIATE_KHR,
+                VK_PRESENT_MODE_MAILBOX_KHR,
+                VK_PRESENT_MODE_FIFO_RELAXED_KHR
+            };
+            break;
+        case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+            candidates = {
+                VK_PRESENT_MODE_FIFO_RELAXED_KHR
+            };
+            break;
+        case VK_PRESENT_MODE_FIFO_KHR:
+            break;
+        default:
+            candidates = {
+                VK_PRESENT_MODE_MAILBOX_KHR
+            };
+            break;
+        }
+
+        for (VkPresentModeKHR candidate: candidates) {
+            if (std::find(availablePresentModes.begin(), availablePresentModes.end(), candidate) !=
+                availablePresentModes.end()) {
+                std::cout << "Present mode: " << presentModeName(candidate) << std::endl;
+                return candidate;
             }
         }
 
-        std::cout << "Present mode: V-Sync" << std::endl;
+        std::cout << "Present mode: " << presentModeName(VK_PRESENT_MODE_FIFO_KHR) << std::endl;
         return VK_PRESENT_MODE_FIFO_KHR;
     }
 
+    const char * SwapChain::presentModeName(VkPresentModeKHR mode) {
+        switch (mode) {
+        case VK_PRESENT_MODE_IMMEDIATE_KHR:
+            return "Immediate";
+        case VK_PRESENT_MODE_MAILBOX_KHR:
+            return "Mailbox";
+        case VK_PRESENT_MODE_FIFO_KHR:
+            return "V-Sync";
+        case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+            return "V-Sync (relaxed)";
+        default:
+            return "Unknown";
+        }
+    }
+
     VkExtent2D SwapChain::chooseSwapExtent(const VkSurfaceCapabilitiesKHR & capabilities) {
         if (capabilities.currentExtent.width != std::numeric_limits < uint32_t > ::max()) {
             return capabilities.currentExtent;
@@ -399,24 +469,6 @@ namespace impgine {
         vkDestroySwapchainKHR(device, swapChain, nullptr);
     }
 
-    void SwapChain::recreateSwapChain() {
-        int width = 0, height = 0;
-        windowRef.getFramebufferSize( & width, & height);
-        while (width == 0 || height == 0) {
-            windowRef.getFramebufferSize( & width, & height);
-            windowRef.waitEvents();
-        }
-
-        vkDeviceWaitIdle(device);
-
-        cleanupSwapChain();
-
-        createSwapChain();
-        createImageViews();
-        createDepthResources();
-        createFramebuffers();
-    }
-
     SwapChainSupportDetails SwapChain::querySwapChainSupport(VkPhysicalDevice device,
         VkSurfaceKHR surface) {
         SwapChainSupportDetails details;
@@ -18,8 +18,13 @@ namespace impgine {
     class SwapChain {
         public: static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
 
+        // When `previous` is given its swapchain is handed to the driver as
+        // oldSwapchain and its per-frame sync objects are adopted, so frames
+        // still in flight on it stay valid. The caller keeps `previous` alive
+        // until those frames have completed.
         SwapChain(VkDevice device, VkPhysicalDevice physicalDevice, VkSurfaceKHR surface,
-            Window & window);
+            Window & window, VkPresentModeKHR preferredPresentMode = VK_PRESENT_MODE_MAILBOX_KHR,
+            SwapChain * previous = nullptr);
         ~SwapChain();
 
         // Delete copy constructor and assignment operator
@@ -35,6 +40,13 @@ namespace impgine {
         VkImageView getImageView(int index) const {
             return swapChainImageViews[index];
         }
+        VkImage getImage(int index) const {
+            return swapChainImages[index];
+        }
+        // Whether passes may write the images with transfers (blits) as well as render to them
+        bool supportsTransferDst() const {
+            return (imageUsage & VK_IMAGE_USAGE_TRANSFER_DST_BIT) != 0;
+        }
         size_t imageCount() const {
             return swapChainImages.size();
         }
@@ -51,6 +63,10 @@ namespace impgine {
             return swapChainExtent.height;
         }
 
+        VkPresentModeKHR getPresentMode() const {
+            return presentMode;
+        }
+
         float extentAspectRatio() const {
             return static_cast < float > (swapChainExtent.width) /
                 static_cast < float > (swapChainExtent.height);
@@ -75,11 +91,11 @@ namespace impgine {
                 swapChain.swapChainImageFormat == swapChainImageFormat;
         }
 
-        void recreateSwapChain();
         void cleanupSwapChain();
 
         static SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device,
             VkSurfaceKHR surface);
+        static const char * presentModeName(VkPresentModeKHR mode);
 
         private: void init();
         void createSwapChain();
@@ -100,10 +116,14 @@ namespace impgine {
         VkPhysicalDevice physicalDevice;
         VkSurfaceKHR surface;
         Window & windowRef;
+        SwapChain * oldSwapChain;
+        VkPresentModeKHR preferredPresentMode;
+        VkPresentModeKHR presentMode;
 
         VkSwapchainKHR swapChain;
         std::vector < VkImage > swapChainImages;
         VkFormat swapChainImageFormat;
+        VkImageUsageFlags imageUsage = 0;
         VkFormat swapChainDepthFormat;
         VkExtent2D swapChainExtent;
 
@@ -0,0 +1,294 @@
+#include "upscaler.hpp"
+
+#include <stdexcept>
+
+#include "pipeline_layout.hpp"
+
+namespace impgine {
+
+    Upscaler::Upscaler(VkDevice device, VkPhysicalDevice physicalDevice, VkFormat format,
+        VkExtent2D sourceExtent, VkExtent2D outputExtent,
+        const std::vector < VkImageView > & outputViews, VkImageLayout outputFinalLayout): device {
+        device
+    }, physicalDevice {
+        physicalDevice
+    }, format {
+        format
+    }, sourceExtent {
+        sourceExtent
+    }, outputExtent {
+        outputExtent
+    } {
+        createSourceImage();
+        createDescriptors();
+        createRenderPass(outputFinalLayout);
+        createFramebuffers(outputViews);
+        createPipeline();
+    }
+
+    Upscaler::~Upscaler() {
+        pipeline.reset();
+        for (auto framebuffer: framebuffers) {
+            vkDestroyFramebuffer(device, framebuffer, nullptr);
+        }
+        vkDestroyRenderPass(device, renderPass, nullptr);
+        vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+        vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+        vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+        vkDestroySampler(device, sampler, nullptr);
+        vkDestroyImageView(device, sourceImageView, nullptr);
+        vkDestroyImage(device, sourceImage, nullptr);
+        vkFreeMemory(device, sourceImageMemory, nullptr);
+    }
+
+    void Upscaler::createSourceImage() {
+        VkImageCreateInfo imageInfo {};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent.width = sourceExtent.width;
+        imageInfo.extent.height = sourceExtent.height;
+        imageInfo.extent.depth = 1;
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.format = format;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        if (vkCreateImage(device, & imageInfo, nullptr, & sourceImage) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create upscaler source image!");
+        }
+
+        VkMemoryRequirements memRequirements;
+        vkGetImageMemoryRequirements(device, sourceImage, & memRequirements);
+
+        VkMemoryAllocateInfo allocInfo {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = memRequirements.size;
+        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        if (vkAllocateMemory(device, & allocInfo, nullptr, & sourceImageMemory) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate upscaler source image memory!");
+        }
+        vkBindImageMemory(device, sourceImage, sourceImageMemory, 0);
+
+        VkImageViewCreateInfo viewInfo {};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = sourceImage;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = format;
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        viewInfo.subresourceRange.baseMipLevel = 0;
+        viewInfo.subresourceRange.levelCount = 1;
+        viewInfo.subresourceRange.baseArrayLayer = 0;
+        viewInfo.subresourceRange.layerCount = 1;
+
+        if (vkCreateImageView(device, & viewInfo, nullptr, & sourceImageView) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create upscaler source image view!");
+        }
+
+        // The shader fetches exact texels, so the filter settings never apply
+        VkSamplerCreateInfo samplerInfo {};
+        samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        samplerInfo.magFilter = VK_FILTER_NEAREST;
+        samplerInfo.minFilter = VK_FILTER_NEAREST;
+        samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.maxLod = 0.0f;
+
+        if (vkCreateSampler(device, & samplerInfo, nullptr, & sampler) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create upscaler sampler!");
+        }
+    }
+
+    void Upscaler::createDescriptors() {
+        VkDescriptorSetLayoutBinding binding {};
+        binding.binding = 0;
+        binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        binding.descriptorCount = 1;
+        binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+        VkDescriptorSetLayoutCreateInfo layoutInfo {};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = 1;
+        layoutInfo.pBindings = & binding;
+
+        if (vkCreateDescriptorSetLayout(device, & layoutInfo, nullptr, & descriptorSetLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create upscaler descriptor set layout!");
+        }
+
+        VkDescriptorPoolSize poolSize {};
+        poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        poolSize.descriptorCount = 1;
+
+        VkDescriptorPoolCreateInfo poolInfo {};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.poolSizeCount = 1;
+        poolInfo.pPoolSizes = & poolSize;
+        poolInfo.maxSets = 1;
+
+        if (vkCreateDescriptorPool(device, & poolInfo, nullptr, & descriptorPool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create upscaler descriptor pool!");
+        }
+
+        VkDescriptorSetAllocateInfo allocInfo {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = descriptorPool;
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = & descriptorSetLayout;
+
+        if (vkAllocateDescriptorSets(device, & allocInfo, & descriptorSet) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate upscaler descriptor set!");
+        }
+
+        VkDescriptorImageInfo imageInfo {};
+        imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        imageInfo.imageView = sourceImageView;
+        imageInfo.sampler = sampler;
+
+        VkWriteDescriptorSet write {};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = descriptorSet;
+        write.dstBinding = 0;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        write.descriptorCount = 1;
+        write.pImageInfo = & imageInfo;
+        vkUpdateDescriptorSets(device, 1, & write, 0, nullptr);
+
+        pipelineLayout = PipelineLayoutBuilder(device)
+            .addDescriptorSetLayout(descriptorSetLayout)
+            .addPushConstantRange(VK_SHADER_STAGE_FRAGMENT_BIT, sizeof(PushConstants))
+            .build();
+    }
+
+    void Upscaler::createRenderPass(VkImageLayout outputFinalLayout) {
+        // Every output pixel is written, so the old contents are never loaded
+        VkAttachmentDescription outputAttachment {};
+        outputAttachment.format = format;
+        outputAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+        outputAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        outputAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        outputAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        outputAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        outputAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        outputAttachment.finalLayout = outputFinalLayout;
+
+        VkAttachmentReference outputAttachmentRef {};
+        outputAttachmentRef.attachment = 0;
+        outputAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+        VkSubpassDescription subpass {};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = 1;
+        subpass.pColorAttachments = & outputAttachmentRef;
+
+        // Waits for the acquire (color output stage) and for the main pass's resolve
+        VkSubpassDependency dependency {};
+        dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+        dependency.dstSubpass = 0;
+        dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+        VkRenderPassCreateInfo renderPassInfo {};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        renderPassInfo.attachmentCount = 1;
+        renderPassInfo.pAttachments = & outputAttachment;
+        renderPassInfo.subpassCount = 1;
+        renderPassInfo.pSubpasses = & subpass;
+        renderPassInfo.dependencyCount = 1;
+        renderPassInfo.pDependencies = & dependency;
+
+        if (vkCreateRenderPass(device, & renderPassInfo, nullptr, & renderPass) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create upscaler render pass!");
+        }
+    }
+
+    void Upscaler::createFramebuffers(const std::vector < VkImageView > & outputViews) {
+        framebuffers.resize(outputViews.size(), VK_NULL_HANDLE);
+        for (size_t i = 0; i < outputViews.size(); i++) {
+            VkFramebufferCreateInfo framebufferInfo {};
+            framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+            framebufferInfo.renderPass = renderPass;
+            framebufferInfo.attachmentCount = 1;
+            framebufferInfo.pAttachments = & outputViews[i];
+            framebufferInfo.width = outputExtent.width;
+            framebufferInfo.height = outputExtent.height;
+            framebufferInfo.layers = 1;
+
+            if (vkCreateFramebuffer(device, & framebufferInfo, nullptr, & framebuffers[i]) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create upscaler framebuffer!");
+            }
+        }
+    }
+
+    void Upscaler::createPipeline() {
+        PipelineConfigInfo pipelineConfig {};
+        Pipeline::defaultPipelineConfigInfo(pipelineConfig);
+        // One full-screen triangle generated from gl_VertexIndex
+        pipelineConfig.bindingDescriptions.clear();
+        pipelineConfig.attributeDescriptions.clear();
+        pipelineConfig.rasterizationInfo.cullMode = VK_CULL_MODE_NONE;
+        pipelineConfig.depthStencilInfo.depthTestEnable = VK_FALSE;
+        pipelineConfig.depthStencilInfo.depthWriteEnable = VK_FALSE;
+        pipelineConfig.renderPass = renderPass;
+        pipelineConfig.pipelineLayout = pipelineLayout;
+
+        pipeline = std::make_unique < Pipeline > (device, "shaders/upscale_vert.spv", "shaders/upscale_frag.spv", pipelineConfig);
+    }
+
+    uint32_t Upscaler::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const {
+        VkPhysicalDeviceMemoryProperties memProperties;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, & memProperties);
+
+        for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+            if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+                return i;
+            }
+        }
+
+        throw std::runtime_error("failed to find suitable memory type!");
+    }
+
+    void Upscaler::record(VkCommandBuffer commandBuffer, uint32_t imageIndex, VkExtent2D renderExtent) const {
+        VkRenderPassBeginInfo renderPassInfo {};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassInfo.renderPass = renderPass;
+        renderPassInfo.framebuffer = framebuffers[imageIndex];
+        renderPassInfo.renderArea.offset = {
+            0,
+            0
+        };
+        renderPassInfo.renderArea.extent = outputExtent;
+        vkCmdBeginRenderPass(commandBuffer, & renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+        VkViewport viewport {};
+        viewport.width = static_cast < float > (outputExtent.width);
+        viewport.height = static_cast < float > (outputExtent.height);
+        viewport.minDepth = 0.0f;
+        viewport.maxDepth = 1.0f;
+        vkCmdSetViewport(commandBuffer, 0, 1, & viewport);
+
+        VkRect2D scissor {};
+        scissor.extent = outputExtent;
+        vkCmdSetScissor(commandBuffer, 0, 1, & scissor);
+
+        pipeline -> bind(commandBuffer);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, & descriptorSet, 0, nullptr);
+
+        PushConstants push {};
+        push.renderWidth = static_cast < float > (renderExtent.width);
+        push.renderHeight = static_cast < float > (renderExtent.height);
+        vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PushConstants), & push);
+
+        vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+        vkCmdEndRenderPass(commandBuffer);
+    }
+
+} // namespace impgine
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <memory>
+#include <vector>
+
+#include "pipeline.hpp"
+
+namespace impgine {
+
+    // Owns the internal scene image the main pass resolves into and the pass
+    // that upscales it onto the output images with a Lanczos-2 filter. The scene
+    // image is allocated once at the largest render size; smaller frames only
+    // use its top-left corner, so changing the scale never reallocates.
+    class Upscaler {
+        public: Upscaler(VkDevice device, VkPhysicalDevice physicalDevice, VkFormat format,
+            VkExtent2D sourceExtent, VkExtent2D outputExtent,
+            const std::vector < VkImageView > & outputViews, VkImageLayout outputFinalLayout);
+        ~Upscaler();
+
+        // Delete copy constructor and assignment operator
+        Upscaler(const Upscaler & ) = delete;
+        Upscaler & operator = (const Upscaler & ) = delete;
+
+        // Resolve target for the main pass; must end in SHADER_READ_ONLY_OPTIMAL
+        VkImageView getSourceImageView() const {
+            return sourceImageView;
+        }
+        VkExtent2D getSourceExtent() const {
+            return sourceExtent;
+        }
+
+        // Records the upscale pass from the renderExtent corner of the source onto output `imageIndex`
+        void record(VkCommandBuffer commandBuffer, uint32_t imageIndex, VkExtent2D renderExtent) const;
+
+        private: struct PushConstants {
+            float renderWidth;
+            float renderHeight;
+        };
+
+        void createSourceImage();
+        void createDescriptors();
+        void createRenderPass(VkImageLayout outputFinalLayout);
+        void createFramebuffers(const std::vector < VkImageView > & outputViews);
+        void createPipeline();
+        uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+
+        VkDevice device;
+        VkPhysicalDevice physicalDevice;
+        VkFormat format;
+        VkExtent2D sourceExtent;
+        VkExtent2D outputExtent;
+
+        VkImage sourceImage = VK_NULL_HANDLE;
+        VkDeviceMemory sourceImageMemory = VK_NULL_HANDLE;
+        VkImageView sourceImageView = VK_NULL_HANDLE;
+        VkSampler sampler = VK_NULL_HANDLE;
+
+        VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+        VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+        VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+        VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+        VkRenderPass renderPass = VK_NULL_HANDLE;
+        std::vector < VkFramebuffer > framebuffers;
+        std::unique_ptr < Pipeline > pipeline;
+    };
+
+} // namespace impgine
\ No newline at end of file
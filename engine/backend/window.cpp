@@ -39,6 +39,20 @@ namespace impgine {
         glfwWaitEvents();
     }
 
+    void Window::waitEventsTimeout(double seconds) const {
+        glfwWaitEventsTimeout(seconds);
+    }
+
+    void Window::wake() {
+        glfwPostEmptyEvent();
+    }
+
+    bool Window::isMinimized() const {
+        int framebufferWidth = 0, framebufferHeight = 0;
+        glfwGetFramebufferSize(window, & framebufferWidth, & framebufferHeight);
+        return framebufferWidth == 0 || framebufferHeight == 0;
+    }
+
     VkExtent2D Window::getExtent() const {
         return {
             static_cast < uint32_t > (width),
@@ -64,6 +78,10 @@ namespace impgine {
         glfwSetFramebufferSizeCallback(window, callback);
     }
 
+    void Window::setRefreshCallback(GLFWwindowrefreshfun callback) {
+        glfwSetWindowRefreshCallback(window, callback);
+    }
+
     bool Window::isKeyPressed(int key) const {
         return glfwGetKey(window, key) == GLFW_PRESS;
     }
@@ -20,6 +20,11 @@ namespace impgine {
         bool shouldClose() const;
         void pollEvents() const;
         void waitEvents() const;
+        // Returns after at most `seconds` even without events
+        void waitEventsTimeout(double seconds) const;
+        // Makes a pending waitEvents() on the main thread return; callable from any thread
+        static void wake();
+        bool isMinimized() const;
 
         VkExtent2D getExtent() const;
         void getFramebufferSize(int * width, int * height) const;
@@ -32,6 +37,8 @@ namespace impgine {
 
         void setUserPointer(void * pointer);
         void setFramebufferSizeCallback(GLFWframebuffersizefun callback);
+        // Called when the contents were damaged, e.g. after being uncovered
+        void setRefreshCallback(GLFWwindowrefreshfun callback);
         
         // Input handling
         bool isKeyPressed(int key) const;
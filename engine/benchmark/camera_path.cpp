@@ -0,0 +1,84 @@
+#include "camera_path.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace impgine {
+
+    CameraPath CameraPath::loadFromFile(const std::string & filepath) {
+        std::ifstream file(filepath);
+        if (!file) {
+            throw std::runtime_error("failed to open camera path: " + filepath);
+        }
+
+        CameraPath path;
+        std::string line;
+        int lineNumber = 0;
+        while (std::getline(file, line)) {
+            lineNumber++;
+
+            size_t comment = line.find('#');
+            if (comment != std::string::npos) {
+                line.erase(comment);
+            }
+            if (line.find_first_not_of(" \t\r") == std::string::npos) {
+                continue;
+            }
+
+            Keyframe keyframe {};
+            std::istringstream fields(line);
+            std::string extra;
+            if (!(fields >> keyframe.time >>
+                    keyframe.position.x >> keyframe.position.y >> keyframe.position.z >>
+                    keyframe.rotation.x >> keyframe.rotation.y >> keyframe.rotation.z) ||
+                (fields >> extra)) {
+                throw std::runtime_error(filepath + ":" + std::to_string(lineNumber) +
+                    ": expected 'time x y z pitch yaw roll'");
+            }
+            if (!path.keyframes.empty() && keyframe.time <= path.keyframes.back().time) {
+                throw std::runtime_error(filepath + ":" + std::to_string(lineNumber) +
+                    ": keyframe times must be strictly increasing");
+            }
+            path.keyframes.push_back(keyframe);
+        }
+
+        if (path.keyframes.empty()) {
+            throw std::runtime_error("camera path has no keyframes: " + filepath);
+        }
+        return path;
+    }
+
+    void CameraPath::sample(float time, glm::vec3 & position, glm::vec3 & rotation) const {
+        const Keyframe & first = keyframes.front();
+        if (keyframes.size() == 1 || time <= first.time) {
+            position = first.position;
+            rotation = first.rotation;
+            return;
+        }
+
+        // Loop over [first.time, last.time]
+        float span = duration() - first.time;
+        float local = first.time + std::fmod(time - first.time, span);
+
+        auto next = std::upper_bound(keyframes.begin(), keyframes.end(), local,
+            [](float value,
+                const Keyframe & keyframe) {
+                return value < keyframe.time;
+            });
+        if (next == keyframes.end()) {
+            position = keyframes.back().position;
+            rotation = keyframes.back().rotation;
+            return;
+        }
+
+        const Keyframe & to = * next;
+        const Keyframe & from = * (next - 1);
+        float t = (local - from.time) / (to.time - from.time);
+        position = glm::mix(from.position, to.position, t);
+        rotation = glm::mix(from.rotation, to.rotation, t);
+    }
+
+} // namespace impgine
\ No newline at end of file
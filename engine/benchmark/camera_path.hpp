@@ -0,0 +1,39 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+namespace impgine {
+
+    // Keyframed camera motion for reproducible runs. Positions and rotations
+    // are in the convention of Camera::setViewYXZ (pitch, yaw, roll in radians)
+    // and are linearly interpolated between keyframes.
+    //
+    // File format, one keyframe per line, times strictly increasing:
+    //     # time  pos.x pos.y pos.z  pitch yaw roll
+    //     0.0     3.0   0.0   1.5    0.46  -1.57 0.0
+    class CameraPath {
+        public: struct Keyframe {
+            float time;
+            glm::vec3 position;
+            glm::vec3 rotation;
+        };
+
+        static CameraPath loadFromFile(const std::string & filepath);
+
+        // Wraps around past the last keyframe so runs longer than the path loop it
+        void sample(float time, glm::vec3 & position, glm::vec3 & rotation) const;
+
+        float duration() const {
+            return keyframes.back().time;
+        }
+
+        private: std::vector < Keyframe > keyframes;
+    };
+
+} // namespace impgine
\ No newline at end of file
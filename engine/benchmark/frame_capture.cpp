@@ -0,0 +1,239 @@
+#include "frame_capture.hpp"
+
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+namespace impgine {
+
+    namespace {
+
+        void writeMatrix(std::ostream & out,
+            const glm::mat4 & matrix) {
+            for (int column = 0; column < 4; column++) {
+                for (int row = 0; row < 4; row++) {
+                    out << ' ' << matrix[column][row];
+                }
+            }
+        }
+
+        bool readMatrix(std::istream & in, glm::mat4 & matrix) {
+            for (int column = 0; column < 4; column++) {
+                for (int row = 0; row < 4; row++) {
+                    if (!(in >> matrix[column][row])) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        void writeVector(std::ostream & out, const glm::vec3 & vector) {
+            out << ' ' << vector.x << ' ' << vector.y << ' ' << vector.z;
+        }
+
+        bool readVector(std::istream & in, glm::vec3 & vector) {
+            return static_cast < bool > (in >> vector.x >> vector.y >> vector.z);
+        }
+
+    } // namespace
+
+    FrameCapture::Writer::Writer(const std::string & filepath,
+        const std::vector < std::string > & assetPaths): filepath {
+        filepath
+    }, file {
+        filepath
+    } {
+        if (!file) {
+            throw std::runtime_error("failed to open " + filepath + " for writing!");
+        }
+
+        file << std::setprecision(std::numeric_limits < float > ::max_digits10);
+        file << "impgine-capture " << VERSION << '\n';
+        for (const auto & path: assetPaths) {
+            file << "asset " << std::quoted(path) << ' ' << std::hex << hashFile(path) << std::dec << '\n';
+        }
+    }
+
+    void FrameCapture::Writer::writeFrame(const FrameSnapshot & snapshot) {
+        file << "frame " << snapshot.framebufferExtent.width << ' ' << snapshot.framebufferExtent.height << '\n';
+        file << "view";
+        writeMatrix(file, snapshot.view);
+        file << "\nproj";
+        writeMatrix(file, snapshot.proj);
+        file << "\nsun";
+        writeVector(file, snapshot.sun.direction);
+        writeVector(file, snapshot.sun.color);
+        file << ' ' << snapshot.sun.intensity << '\n';
+        if (!lightsWritten || snapshot.lights != writtenLights) {
+            size_t count = snapshot.lights ? snapshot.lights -> size() : 0;
+            file << "lights " << count << '\n';
+            for (size_t i = 0; i < count; i++) {
+                const PointLight & light = ( * snapshot.lights)[i];
+                file << "light";
+                writeVector(file, light.position);
+                file << ' ' << light.radius;
+                writeVector(file, light.color);
+                file << ' ' << light.intensity << '\n';
+            }
+            writtenLights = snapshot.lights;
+            lightsWritten = true;
+        }
+        for (const auto & item: snapshot.drawList) {
+            file << (item.dynamic ? "draw-dynamic " : "draw ") << item.firstIndex << ' ' << item.indexCount << ' ' << item.vertexOffset << ' ' <<
+                item.objectIndex << ' ' << item.materialIndex;
+            writeMatrix(file, item.model);
+            file << '\n';
+        }
+
+        if (!file) {
+            throw std::runtime_error("failed to write " + filepath + "!");
+        }
+    }
+
+    FrameCapture FrameCapture::loadFromFile(const std::string & filepath) {
+        std::ifstream file(filepath);
+        if (!file) {
+            throw std::runtime_error("failed to open capture: " + filepath);
+        }
+
+        FrameCapture capture;
+        std::string line;
+        int lineNumber = 0;
+        auto fail = [ & ](const std::string & message) {
+            return std::runtime_error(filepath + ":" + std::to_string(lineNumber) + ": " + message);
+        };
+        // The list being read and how many lights it announced
+        std::shared_ptr < std::vector < PointLight >> readingLights;
+        size_t announcedLights = 0;
+        auto finishLights = [ & ]() {
+            if (readingLights && readingLights -> size() != announcedLights) {
+                throw fail("expected " + std::to_string(announcedLights) + " 'light' records");
+            }
+        };
+
+        while (std::getline(file, line)) {
+            lineNumber++;
+            std::istringstream fields(line);
+            std::string tag;
+            if (!(fields >> tag)) {
+                continue;
+            }
+
+            std::string extra;
+            if (lineNumber == 1) {
+                int version = 0;
+                if (tag != "impgine-capture" || !(fields >> version) || (fields >> extra)) {
+                    throw fail("not an impgine capture");
+                }
+                if (version != VERSION) {
+                    throw fail("unsupported capture version " + std::to_string(version));
+                }
+                continue;
+            }
+
+            if (tag == "asset") {
+                Asset asset {};
+                if (!(fields >> std::quoted(asset.path) >> std::hex >> asset.hash) || (fields >> extra)) {
+                    throw fail("expected 'asset path hash'");
+                }
+                capture.assets.push_back(asset);
+            } else if (tag == "frame") {
+                FrameSnapshot frame;
+                if (!(fields >> frame.framebufferExtent.width >> frame.framebufferExtent.height) || (fields >> extra) ||
+                    frame.framebufferExtent.width == 0 || frame.framebufferExtent.height == 0) {
+                    throw fail("expected 'frame width height'");
+                }
+                finishLights();
+                // Until a frame says otherwise it has the previous frame's lights
+                if (!capture.frames.empty()) {
+                    frame.lights = capture.frames.back().lights;
+                }
+                capture.frames.push_back(std::move(frame));
+            } else if (capture.frames.empty()) {
+                throw fail("'" + tag + "' outside of a frame");
+            } else if (tag == "view" || tag == "proj") {
+                glm::mat4 & matrix = tag == "view" ? capture.frames.back().view : capture.frames.back().proj;
+                if (!readMatrix(fields, matrix) || (fields >> extra)) {
+                    throw fail("expected 16 matrix elements");
+                }
+            } else if (tag == "sun") {
+                DirectionalLight & sun = capture.frames.back().sun;
+                if (!readVector(fields, sun.direction) || !readVector(fields, sun.color) || !(fields >> sun.intensity) ||
+                    (fields >> extra)) {
+                    throw fail("expected 'sun' with a direction, a color and an intensity");
+                }
+            } else if (tag == "lights") {
+                finishLights();
+                if (!(fields >> announcedLights) || (fields >> extra)) {
+                    throw fail("expected 'lights count'");
+                }
+                readingLights = std::make_shared < std::vector < PointLight >> ();
+                capture.frames.back().lights = readingLights;
+            } else if (tag == "light") {
+                PointLight light;
+                if (!readingLights || readingLights -> size() >= announcedLights || capture.frames.back().lights != readingLights) {
+                    throw fail("'light' beyond the count of the frame's 'lights'");
+                }
+                if (!readVector(fields, light.position) || !(fields >> light.radius) || !readVector(fields, light.color) ||
+                    !(fields >> light.intensity) || (fields >> extra)) {
+                    throw fail("expected 'light' with a position, a radius, a color and an intensity");
+                }
+                readingLights -> push_back(light);
+            } else if (tag == "draw" || tag == "draw-dynamic") {
+                DrawItem item;
+                item.dynamic = tag == "draw-dynamic";
+                if (!(fields >> item.firstIndex >> item.indexCount >> item.vertexOffset >>
+                        item.objectIndex >> item.materialIndex) || !readMatrix(fields, item.model) || (fields >> extra)) {
+                    throw fail("expected 'draw firstIndex indexCount vertexOffset objectIndex materialIndex' and a matrix");
+                }
+                capture.frames.back().drawList.push_back(item);
+            } else {
+                throw fail("unknown record '" + tag + "'");
+            }
+        }
+
+        finishLights();
+        if (lineNumber == 0) {
+            throw std::runtime_error("capture is empty: " + filepath);
+        }
+        if (capture.frames.empty()) {
+            throw std::runtime_error("capture has no frames: " + filepath);
+        }
+        return capture;
+    }
+
+    void FrameCapture::verifyAssets() const {
+        for (const auto & asset: assets) {
+            if (hashFile(asset.path) != asset.hash) {
+                throw std::runtime_error("asset " + asset.path + " differs from the one captured");
+            }
+        }
+    }
+
+    uint64_t FrameCapture::hashBytes(const void * data, size_t size, uint64_t seed) {
+        const uint8_t * bytes = static_cast < const uint8_t * > (data);
+        uint64_t hash = seed;
+        for (size_t i = 0; i < size; i++) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    uint64_t FrameCapture::hashFile(const std::string & filepath) {
+        std::ifstream file(filepath, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("failed to open " + filepath + "!");
+        }
+
+        uint64_t hash = FNV_OFFSET_BASIS;
+        char buffer[64 * 1024];
+        while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0) {
+            hash = hashBytes(buffer, static_cast < size_t > (file.gcount()), hash);
+        }
+        return hash;
+    }
+
+} // namespace impgine
\ No newline at end of file
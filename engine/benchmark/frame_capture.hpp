@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "../frame_snapshot.hpp"
+
+namespace impgine {
+
+    // A recorded session: the assets it was rendered with and, per frame, the
+    // snapshot the renderer consumed (camera matrices, framebuffer size, draw
+    // list and lighting). Replaying the snapshots reproduces the frames without
+    // live input or wall-clock deltas.
+    //
+    // Text format, floats written with enough digits to round-trip exactly:
+    //     impgine-capture 2
+    //     asset "<path>" <fnv1a-64 of the file, hex>   (quotes and backslashes escaped)
+    //     frame <width> <height>
+    //     view <16 floats, column-major>
+    //     proj <16 floats>
+    //     sun <direction xyz> <color rgb> <intensity>
+    //     lights <count>   (only when the list changed; later frames reuse it)
+    //     light <position xyz> <radius> <color rgb> <intensity>   (count of them)
+    //     draw <firstIndex> <indexCount> <vertexOffset> <objectIndex> <materialIndex> <16 floats>
+    //     draw-dynamic <same fields>   (a draw with DrawItem::dynamic set)
+    class FrameCapture {
+        public: static constexpr int VERSION = 2;
+
+        struct Asset {
+            std::string path;
+            uint64_t hash;
+        };
+
+        // Streams frames to disk as they are rendered, so a long session never
+        // has to fit in memory
+        class Writer {
+            public: Writer(const std::string & filepath,
+                const std::vector < std::string > & assetPaths);
+
+            // Delete copy constructor and assignment operator
+            Writer(const Writer & ) = delete;
+            Writer & operator = (const Writer & ) = delete;
+
+            void writeFrame(const FrameSnapshot & snapshot);
+
+            private: std::string filepath;
+            std::ofstream file;
+            // The point light list of the previous frame, written only when replaced
+            std::shared_ptr < const std::vector < PointLight >> writtenLights;
+            bool lightsWritten = false;
+        };
+
+        static FrameCapture loadFromFile(const std::string & filepath);
+
+        // Throws if an asset is missing or differs from the one captured
+        void verifyAssets() const;
+
+        size_t frameCount() const {
+            return frames.size();
+        }
+        // Sequence, present mode and input time are left for the caller to fill in
+        const FrameSnapshot & getFrame(size_t index) const {
+            return frames[index];
+        }
+
+        // 64-bit FNV-1a; chain calls by passing the previous result as the seed
+        static constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+        static uint64_t hashBytes(const void * data, size_t size, uint64_t seed = FNV_OFFSET_BASIS);
+        static uint64_t hashFile(const std::string & filepath);
+
+        private: std::vector < Asset > assets;
+        std::vector < FrameSnapshot > frames;
+    };
+
+} // namespace impgine
\ No newline at end of file
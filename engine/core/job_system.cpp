@@ -0,0 +1,230 @@
+#include "job_system.hpp"
+
+#include <chrono>
+#include <utility>
+
+#include "../profiling/trace.hpp"
+
+namespace impgine {
+
+    namespace {
+
+        // Which pool and worker the calling thread belongs to (-1: not a worker)
+        thread_local const JobSystem * currentSystem = nullptr;
+        thread_local int currentWorker = -1;
+
+    } // namespace
+
+    JobSystem::JobSystem(unsigned workerCount): mainThreadId(std::this_thread::get_id()) {
+        if (workerCount == 0) {
+            unsigned hardwareThreads = std::thread::hardware_concurrency();
+            workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+        }
+
+        for (unsigned i = 0; i < workerCount; i++) {
+            queues.push_back(std::make_unique < WorkerQueue > ());
+        }
+        for (unsigned i = 0; i < workerCount; i++) {
+            workers.emplace_back(& JobSystem::workerLoop, this, i);
+        }
+    }
+
+    JobSystem::~JobSystem() {
+        {
+            std::lock_guard < std::mutex > lock(sleepMutex);
+            stopping = true;
+        }
+        wakeCondition.notify_all();
+
+        for (auto & worker: workers) {
+            worker.join();
+        }
+    }
+
+    void JobSystem::submit(Job job, JobCounter * counter) {
+        if (counter != nullptr) {
+            counter -> pending.fetch_add(1, std::memory_order_relaxed);
+        }
+        enqueue({
+            std::move(job), counter
+        });
+    }
+
+    void JobSystem::submitAfter(JobCounter & dependency, Job job, JobCounter * counter) {
+        if (counter != nullptr) {
+            counter -> pending.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        {
+            // finish() drops the count under the same lock, so the continuation
+            // is either picked up there or the zero is seen here
+            std::lock_guard < std::mutex > lock(dependency.continuationMutex);
+            if (!dependency.isDone()) {
+                dependency.continuations.push_back({
+                    std::move(job), counter
+                });
+                return;
+            }
+        }
+
+        enqueue({
+            std::move(job), counter
+        });
+    }
+
+    void JobSystem::enqueue(Task task) {
+        // Workers push to their own deque; everyone else goes through the injection queue
+        WorkerQueue & queue = currentSystem == this && currentWorker >= 0 ?
+            * queues[currentWorker] : injectionQueue;
+        {
+            std::lock_guard < std::mutex > lock(queue.mutex);
+            queue.tasks.push_back(std::move(task));
+        }
+
+        queuedTasks.fetch_add(1, std::memory_order_release);
+        {
+            // Pairs with the predicate check in workerLoop so the wakeup can't be lost
+            std::lock_guard < std::mutex > lock(sleepMutex);
+        }
+        wakeCondition.notify_one();
+    }
+
+    void JobSystem::wait(JobCounter & counter) {
+        int selfIndex = currentSystem == this ? currentWorker : -1;
+
+        while (!counter.isDone()) {
+            if (isMainThread()) {
+                // A job we wait on may be blocked on a main-thread job
+                pumpMainThread();
+            }
+            if (!tryRunOne(selfIndex)) {
+                std::this_thread::yield();
+            }
+        }
+
+        // Wait for the finishing thread to release the counter
+        std::lock_guard < std::mutex > lock(counter.continuationMutex);
+    }
+
+    void JobSystem::runOnMainThread(Job job, JobCounter * counter) {
+        if (counter != nullptr) {
+            counter -> pending.fetch_add(1, std::memory_order_relaxed);
+        }
+        std::lock_guard < std::mutex > lock(mainThreadQueue.mutex);
+        mainThreadQueue.tasks.push_back({
+            std::move(job), counter
+        });
+    }
+
+    void JobSystem::pumpMainThread() {
+        std::deque < Task > tasks;
+        {
+            std::lock_guard < std::mutex > lock(mainThreadQueue.mutex);
+            tasks.swap(mainThreadQueue.tasks);
+        }
+
+        for (auto & task: tasks) {
+            execute(task);
+        }
+    }
+
+    void JobSystem::workerLoop(unsigned index) {
+        currentSystem = this;
+        currentWorker = static_cast < int > (index);
+        IMPGINE_TRACE_THREAD("worker");
+
+        while (true) {
+            if (tryRunOne(currentWorker)) {
+                continue;
+            }
+
+            std::unique_lock < std::mutex > lock(sleepMutex);
+            wakeCondition.wait(lock, [this]() {
+                return stopping.load() || queuedTasks.load(std::memory_order_acquire) > 0;
+            });
+            if (stopping) {
+                return;
+            }
+        }
+    }
+
+    bool JobSystem::tryRunOne(int selfIndex) {
+        Task task;
+        if (!popTask(selfIndex, task)) {
+            return false;
+        }
+        execute(task);
+        return true;
+    }
+
+    bool JobSystem::popTask(int selfIndex, Task & task) {
+        // Own deque first, newest task (LIFO)
+        if (selfIndex >= 0) {
+            WorkerQueue & own = * queues[selfIndex];
+            std::lock_guard < std::mutex > lock(own.mutex);
+            if (!own.tasks.empty()) {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                queuedTasks.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+
+        {
+            std::lock_guard < std::mutex > lock(injectionQueue.mutex);
+            if (!injectionQueue.tasks.empty()) {
+                task = std::move(injectionQueue.tasks.front());
+                injectionQueue.tasks.pop_front();
+                queuedTasks.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+
+        // Steal the oldest task from someone else, starting next to us so
+        // thieves spread out instead of all hitting worker 0
+        size_t queueCount = queues.size();
+        size_t start = selfIndex >= 0 ? static_cast < size_t > (selfIndex) + 1 : 0;
+        for (size_t i = 0; i < queueCount; i++) {
+            WorkerQueue & victim = * queues[(start + i) % queueCount];
+            std::lock_guard < std::mutex > lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                queuedTasks.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void JobSystem::execute(Task & task) {
+        IMPGINE_TRACE_SCOPE("job");
+        task.job();
+        finish(task.counter);
+    }
+
+    void JobSystem::finish(JobCounter * counter) {
+        if (counter == nullptr) {
+            return;
+        }
+
+        std::vector < JobCounter::Continuation > continuations;
+        {
+            // The decrement happens under the lock so wait() can't return and
+            // let the counter go out of scope while we still touch it
+            std::lock_guard < std::mutex > lock(counter -> continuationMutex);
+            if (counter -> pending.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+                return;
+            }
+            continuations.swap(counter -> continuations);
+        }
+
+        for (auto & continuation: continuations) {
+            enqueue({
+                std::move(continuation.job), continuation.counter
+            });
+        }
+    }
+
+} // namespace impgine
\ No newline at end of file
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace impgine {
+
+    class JobSystem;
+
+    // Tracks a group of jobs. Jobs submitted with a counter bump it and drop it
+    // when they finish; other jobs can be chained to run once it reaches zero.
+    class JobCounter {
+        public: JobCounter() = default;
+
+        // Delete copy constructor and assignment operator
+        JobCounter(const JobCounter & ) = delete;
+        JobCounter & operator = (const JobCounter & ) = delete;
+
+        bool isDone() const {
+            return pending.load(std::memory_order_acquire) == 0;
+        }
+
+        private: friend class JobSystem;
+
+        struct Continuation {
+            std::function < void() > job;
+            JobCounter * counter;
+        };
+
+        std::atomic < uint32_t > pending {
+            0
+        };
+        std::mutex continuationMutex;
+        std::vector < Continuation > continuations;
+    };
+
+    // Work-stealing scheduler. Each worker owns a deque it pushes to and pops
+    // from at the back (LIFO, cache-warm); idle workers steal from the front of
+    // the others. Jobs submitted from outside the pool go through a shared
+    // injection queue. Threads that wait on a counter run jobs meanwhile, so
+    // waiting from inside a job cannot deadlock the pool.
+    //
+    // GLFW and a few other APIs must only be called from the main thread;
+    // runOnMainThread() queues work that the main loop runs in pumpMainThread().
+    class JobSystem {
+        public: using Job = std::function < void() > ;
+
+        // 0 picks hardware_concurrency() - 1, leaving a core to the main thread
+        explicit JobSystem(unsigned workerCount = 0);
+        ~JobSystem();
+
+        // Delete copy constructor and assignment operator
+        JobSystem(const JobSystem & ) = delete;
+        JobSystem & operator = (const JobSystem & ) = delete;
+
+        void submit(Job job, JobCounter * counter = nullptr);
+        // Runs `job` once `dependency` reaches zero (immediately if it already has)
+        void submitAfter(JobCounter & dependency, Job job, JobCounter * counter = nullptr);
+        // Helps executing jobs until the counter reaches zero
+        void wait(JobCounter & counter);
+
+        // Splits [begin, end) into chunks of at most `grainSize` and runs
+        // body(chunkBegin, chunkEnd) on each, returning once all are done
+        template < typename Body >
+            void parallelFor(size_t begin, size_t end, size_t grainSize, Body body);
+
+        void runOnMainThread(Job job, JobCounter * counter = nullptr);
+        // Runs queued main-thread jobs; call regularly from the main thread
+        void pumpMainThread();
+        bool isMainThread() const {
+            return std::this_thread::get_id() == mainThreadId;
+        }
+
+        unsigned workerCount() const {
+            return static_cast < unsigned > (workers.size());
+        }
+
+        private: struct Task {
+            Job job;
+            JobCounter * counter = nullptr;
+        };
+
+        struct WorkerQueue {
+            std::mutex mutex;
+            std::deque < Task > tasks;
+        };
+
+        void workerLoop(unsigned index);
+        void enqueue(Task task);
+        bool tryRunOne(int selfIndex);
+        bool popTask(int selfIndex, Task & task);
+        void execute(Task & task);
+        void finish(JobCounter * counter);
+
+        std::thread::id mainThreadId;
+        std::vector < std::thread > workers;
+        std::vector < std::unique_ptr < WorkerQueue >> queues;
+        WorkerQueue injectionQueue;
+        WorkerQueue mainThreadQueue;
+
+        // Sleeping workers wake when queuedTasks goes up or on shutdown
+        std::atomic < size_t > queuedTasks {
+            0
+        };
+        std::mutex sleepMutex;
+        std::condition_variable wakeCondition;
+        std::atomic < bool > stopping {
+            false
+        };
+    };
+
+    template < typename Body >
+        void JobSystem::parallelFor(size_t begin, size_t end, size_t grainSize, Body body) {
+            if (begin >= end) {
+                return;
+            }
+            grainSize = std::max < size_t > (grainSize, 1);
+
+            // A single chunk is not worth a round trip through the queues
+            if (end - begin <= grainSize) {
+                body(begin, end);
+                return;
+            }
+
+            JobCounter counter;
+            for (size_t chunkBegin = begin; chunkBegin < end; chunkBegin += grainSize) {
+                size_t chunkEnd = std::min(end, chunkBegin + grainSize);
+                submit([ & body, chunkBegin, chunkEnd]() {
+                    body(chunkBegin, chunkEnd);
+                }, & counter);
+            }
+            wait(counter);
+        }
+
+} // namespace impgine
\ No newline at end of file
@@ -0,0 +1,23 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#define GLM_FORCE_DEFAULT_ALIGNED_GENTYPES
+#include <glm/glm.hpp>
+
+namespace impgine {
+
+    // Infinitely distant light such as the sun; the only light that casts shadows.
+    // An intensity of 0 turns it off
+    struct DirectionalLight {
+        // Direction the light travels in, towards the scene; need not be normalized
+        glm::vec3 direction {
+            0.0f, 0.0f, -1.0f
+        };
+        glm::vec3 color {
+            1.0f
+        };
+        float intensity = 1.0f;
+    };
+
+} // namespace impgine
\ No newline at end of file
@@ -0,0 +1,63 @@
+#include "dynamic_resolution.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace impgine {
+
+    namespace {
+
+        constexpr double SMOOTHING = 0.25; // weight of the newest sample
+        constexpr double DEADBAND = 0.05; // within 5% of the budget the scale holds
+        constexpr float MAX_STEP_DOWN = 0.10f;
+        constexpr float MAX_STEP_UP = 0.02f;
+
+    } // namespace
+
+    DynamicResolution::DynamicResolution(double targetGpuMs, float minScale, float maxScale): targetGpuMs {
+        targetGpuMs
+    }, minScale {
+        minScale
+    }, maxScale {
+        maxScale
+    }, scale {
+        maxScale
+    } {
+        if (!(targetGpuMs > 0.0) || !(minScale > 0.0f) || minScale > maxScale) {
+            throw std::runtime_error("invalid dynamic resolution settings!");
+        }
+    }
+
+    void DynamicResolution::update(double gpuMs) {
+        if (!(gpuMs > 0.0)) {
+            return;
+        }
+
+        smoothedGpuMs = smoothedGpuMs > 0.0 ? smoothedGpuMs + SMOOTHING * (gpuMs - smoothedGpuMs) : gpuMs;
+        double ratio = targetGpuMs / smoothedGpuMs;
+        if (std::abs(ratio - 1.0) < DEADBAND) {
+            return;
+        }
+
+        float desired = scale * static_cast < float > (std::sqrt(ratio));
+        desired = std::clamp(desired, scale * (1.0f - MAX_STEP_DOWN), scale * (1.0f + MAX_STEP_UP));
+        scale = std::clamp(desired, minScale, maxScale);
+    }
+
+    VkExtent2D DynamicResolution::getRenderExtent(VkExtent2D outputExtent) const {
+        return scaleExtent(outputExtent, scale);
+    }
+
+    VkExtent2D DynamicResolution::getMaxRenderExtent(VkExtent2D outputExtent) const {
+        return scaleExtent(outputExtent, maxScale);
+    }
+
+    VkExtent2D DynamicResolution::scaleExtent(VkExtent2D extent, float scale) {
+        return {
+            std::max(1u, static_cast < uint32_t > (std::lround(extent.width * scale))),
+            std::max(1u, static_cast < uint32_t > (std::lround(extent.height * scale)))
+        };
+    }
+
+} // namespace impgine
\ No newline at end of file
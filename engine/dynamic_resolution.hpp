@@ -0,0 +1,37 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+namespace impgine {
+
+    // Picks the internal render scale from measured GPU frame times. GPU cost is
+    // roughly proportional to pixel count, so the scale moves by the square root
+    // of budget / time. Times are smoothed, and the scale drops quickly but
+    // recovers slowly, so one spike doesn't make the resolution oscillate.
+    class DynamicResolution {
+        public: DynamicResolution(double targetGpuMs, float minScale, float maxScale);
+
+        // Feed one frame's GPU time; the new scale applies to frames recorded afterwards
+        void update(double gpuMs);
+
+        float getScale() const {
+            return scale;
+        }
+        double getTargetGpuMs() const {
+            return targetGpuMs;
+        }
+
+        // What this frame renders at, and what the render targets are allocated for
+        VkExtent2D getRenderExtent(VkExtent2D outputExtent) const;
+        VkExtent2D getMaxRenderExtent(VkExtent2D outputExtent) const;
+
+        private: static VkExtent2D scaleExtent(VkExtent2D extent, float scale);
+
+        double targetGpuMs;
+        float minScale;
+        float maxScale;
+        float scale;
+        double smoothedGpuMs = 0.0;
+    };
+
+} // namespace impgine
\ No newline at end of file
@@ -1,15 +1,19 @@
-#define STB_IMAGE_IMPLEMENTATION
-#define TINYOBJLOADER_IMPLEMENTATION
 #include "engine.hpp"
 
+#include <algorithm>
 #include <array>
+#include <cmath>
 #include <cstdlib>
-#include <tiny_obj_loader.h>
+
+#include "assets/texture_cache.hpp"
+#include "assets/texture_decode.hpp"
 
 namespace impgine {
 
 const std::string Engine::MODEL_PATH = "models/viking_room.obj";
 const std::string Engine::TEXTURE_PATH = "textures/viking_room.png";
+const std::string Engine::FALLBACK_TEXTURE_PATH = "textures/texture.jpg";
+const std::string Engine::BINDLESS_FRAGMENT_SHADER = "shaders/frag_bindless.spv";
 
 VkResult CreateDebugUtilsMessengerEXT(VkInstance instance,
                                       const VkDebugUtilsMessengerCreateInfoEXT* pCreateInfo,
@@ -33,88 +37,490 @@ void DestroyDebugUtilsMessengerEXT(VkInstance instance, VkDebugUtilsMessengerEXT
     }
 }
 
-Engine::Engine() {
-    window = std::make_unique<Window>(WIDTH, HEIGHT, "Impgine");
-    window->setUserPointer(this);
-    window->setFramebufferSizeCallback(framebufferResizeCallback);
+Engine::Engine(const EngineConfig& config) : config(config), jobs(config.workerThreads) {
+    IMPGINE_TRACE_THREAD("main");
+    frameLimiter.setTargetFrameRate(config.frameRateLimit);
+    if (config.stallReport || config.stallWatchdogMs > 0.0) {
+        stallTracker = std::make_unique<StallTracker>(config.stallWatchdogMs);
+    }
+    if (config.dynamicResolution) {
+        double budgetMs = config.dynamicResolutionBudgetMs > 0.0 ? config.dynamicResolutionBudgetMs : defaultGpuBudgetMs();
+        dynamicResolution = std::make_unique<DynamicResolution>(budgetMs, config.minRenderScale, config.maxRenderScale);
+    }
+    if (config.depthPrepass != DepthPrepassMode::Off) {
+        overdrawMonitor = std::make_unique<OverdrawMonitor>(config.overdrawThreshold);
+    }
+    if (config.lights > 0) {
+        // Roughly the model's bounds
+        setLights(scatterPointLights(config.lights, glm::vec3(-1.2f, -1.2f, 0.0f), glm::vec3(1.2f, 1.2f, 1.0f), 0.35f));
+    }
+    if (config.shadows) {
+        // A low afternoon sun, so the model throws visible shadows
+        DirectionalLight light;
+        light.direction = glm::vec3(0.6f, 0.4f, -0.7f);
+        setDirectionalLight(light);
+    }
+
+    // Load the camera path before creating anything so a bad file fails fast
+    if (!config.benchmarkPath.empty()) {
+        cameraPath = std::make_unique<CameraPath>(CameraPath::loadFromFile(config.benchmarkPath));
+    }
+    if (!config.replayPath.empty()) {
+        replayCapture = std::make_unique<FrameCapture>(FrameCapture::loadFromFile(config.replayPath));
+        // Draw lists index into the captured model, so it has to be the same one
+        replayCapture->verifyAssets();
+        this->config.headlessExtent = replayCapture->getFrame(0).framebufferExtent;
+    }
+    if (!config.captureOutput.empty()) {
+        captureWriter = std::make_unique<FrameCapture::Writer>(config.captureOutput, sceneAssetPaths());
+    }
+    if (!config.frameHashesOutput.empty()) {
+        frameHashFile.open(config.frameHashesOutput);
+        if (!frameHashFile) {
+            throw std::runtime_error("failed to open " + config.frameHashesOutput + " for writing!");
+        }
+    }
+
+    // Headless runs never touch GLFW, so they work without a display server
+    if (!config.headless) {
+        window = std::make_unique<Window>(WIDTH, HEIGHT, "Impgine");
+        window->setUserPointer(this);
+        window->setFramebufferSizeCallback(framebufferResizeCallback);
+        window->setRefreshCallback(windowRefreshCallback);
+    }
     initVulkan();
 }
 
-Engine::~Engine() { cleanup(); }
+Engine::~Engine() {
+    if (config.reportLatency) {
+        latencyTracker.report(std::cout);
+        if (config.renderThread) {
+            snapshotQueue.report(std::cout);
+        }
+        std::cout << "Deletion queue peak depth: " << deletionQueue.peakSize() << std::endl;
+    }
+    // The profiler also runs for automatic quality settings; only report when asked
+    if (gpuProfiler && (config.gpuProfile || !config.traceOutput.empty()) && !isBenchmarking()) {
+        gpuProfiler->report(std::cout);
+    }
+    if (overdrawMonitor && pipelineStatisticsSupported) {
+        overdrawMonitor->report(std::cout);
+    }
+    if (config.gpuProfile && config.shadows) {
+        std::cout << "Shadow cascade cache renders: " << shadowMaps->getCacheRenderCount() << std::endl;
+    }
+    cleanup();
+    if (config.stallReport) {
+        stallTracker->report(std::cout);
+    }
+}
 
 void Engine::run() {
     std::cout << "Welcome to Impgine!\n";
     mainLoop();
+
+    if (!config.traceOutput.empty()) {
+        Trace::writeChromeTrace(config.traceOutput);
+        std::cout << "Wrote " << config.traceOutput << std::endl;
+    }
+}
+
+void Engine::requestRedraw() {
+    redrawRequested = true;
+    // The main thread may be blocked waiting for events
+    if (window && !jobs.isMainThread()) {
+        Window::wake();
+    }
+}
+
+void Engine::setAnimating(bool animating) {
+    this->animating = animating;
+}
+
+void Engine::setPresentMode(VkPresentModeKHR mode) {
+    // Travels to the renderer with the next snapshot
+    config.presentMode = mode;
+    requestRedraw();
+}
+
+void Engine::setFrameRateLimit(double framesPerSecond) {
+    config.frameRateLimit = framesPerSecond;
+    frameLimiter.setTargetFrameRate(framesPerSecond);
+}
+
+void Engine::setMsaaSamples(uint32_t samples) {
+    // Travels to the renderer with the next snapshot, like the present mode
+    config.msaaSamples = samples;
+    requestRedraw();
+}
+
+void Engine::setLights(std::vector<PointLight> lights) {
+    if (lights.size() > LightCulling::MAX_LIGHTS) {
+        throw std::runtime_error("too many lights: " + std::to_string(lights.size()) + " (at most " + std::to_string(LightCulling::MAX_LIGHTS) + ")");
+    }
+    // Snapshots already holding the old list keep it alive
+    this->lights = std::make_shared<const std::vector<PointLight>>(std::move(lights));
+    requestRedraw();
+}
+
+void Engine::setDirectionalLight(const DirectionalLight& light) {
+    sun = light;
+    requestRedraw();
+}
+
+double Engine::defaultGpuBudgetMs() const {
+    // Leave the CPU side and present some slack within the frame
+    double frameRate = config.frameRateLimit > 0.0 ? config.frameRateLimit : 60.0;
+    return 0.9 * 1000.0 / frameRate;
 }
 
 void Engine::initVulkan() {
+    IMPGINE_TRACE_FUNCTION();
+
     createInstance();
     setupDebugMessenger();
-    createSurface();
+    if (!config.headless) {
+        createSurface();
+    }
     pickPhysicalDevice();
     createLogicalDevice();
-    
-    // Initialize mouse capture
-    window->setCursorInputMode(GLFW_CURSOR_DISABLED);
-    window->setCursorPos(WIDTH / 2.0, HEIGHT / 2.0);
+    msaaSamples = selectSampleCount(config.msaaSamples);
 
-    swapChain = std::make_unique<SwapChain>(device, physicalDevice, surface, *window);
+    if (config.headless) {
+        offscreenTarget = std::make_unique<OffscreenTarget>(device, physicalDevice, config.headlessExtent, SwapChain::MAX_FRAMES_IN_FLIGHT);
+        if (frameHashFile.is_open()) {
+            offscreenTarget->enableReadback();
+        }
+    } else {
+        // Initialize mouse capture
+        window->setCursorInputMode(GLFW_CURSOR_DISABLED);
+        window->setCursorPos(WIDTH / 2.0, HEIGHT / 2.0);
+
+        swapChainPresentMode = config.presentMode;
+        swapChain = std::make_unique<SwapChain>(device, physicalDevice, surface, *window, swapChainPresentMode);
+        if (config.fxaa && !swapChain->supportsTransferDst()) {
+            std::cerr << "Swap chain images can't be blitted to; FXAA is disabled" << std::endl;
+        }
+    }
 
     createCommandPool();
-    createTextureImage();
-    createTextureImageView();
-    createTextureSampler();
-    createColorResources();
-    createDepthResources();
-    createRenderPass();
-    createFramebuffers();
-    loadModel();
+
+    // Parsing the OBJ only touches CPU-side data, so it overlaps with creating
+    // the render targets here. The MTL files are read on their own up front,
+    // which is cheap, so the textures they name decode during the parse too
+    JobCounter modelLoaded;
+    std::exception_ptr modelError;
+    jobs.submit([this, &modelError]() {
+        try {
+            loadModel();
+        } catch (...) {
+            modelError = std::current_exception();
+        }
+    }, &modelLoaded);
+
+    try {
+        createTextureSampler();
+        // Textures take their bindless slot as they are created
+        if (bindlessCapacity > 0) {
+            bindlessTextures = std::make_unique<BindlessTextures>(device, bindlessCapacity, textureSampler);
+        }
+        startMaterialTextures();
+        createColorResources();
+        createDepthResources();
+        createRenderPass();
+        createUpscaler();
+        createFxaaPass();
+        createFramebuffers();
+    } catch (...) {
+        // The job still references this frame's locals
+        jobs.wait(modelLoaded);
+        throw;
+    }
+
+    jobs.wait(modelLoaded);
+    if (modelError) {
+        std::rethrow_exception(modelError);
+    }
+    createMaterialTextures();
     createVertexBuffer();
+    createPositionBuffer();
     createIndexBuffer();
     createUniformBuffers();
     createDescriptorSetLayout();
     createDescriptorPool();
     createDescriptorSets();
+    createMaterialDescriptorSets();
+    lightCulling = std::make_unique<LightCulling>(device, physicalDevice, SwapChain::MAX_FRAMES_IN_FLIGHT);
+    // The shading pass always samples the maps; without shadows they are a single texel
+    shadowMaps = std::make_unique<ShadowMaps>(device, physicalDevice, config.shadows ? config.shadowMapSize : 1, SwapChain::MAX_FRAMES_IN_FLIGHT);
+    createPipelineLayout();
+    createGraphicsPipeline();
+    buildDrawList();
+    createCommandBuffers();
+    // Scripted and headless frames have to be reproducible, so nothing draws with placeholders
+    if (config.headless || isBenchmarking() || captureWriter) {
+        uploadDecodedTextures(true);
+    }
+    // Dynamic resolution and automatic MSAA steer by measured GPU time, the depth prepass by overdraw
+    if (config.gpuProfile || isBenchmarking() || !config.traceOutput.empty() || dynamicResolution || adaptiveMsaa || overdrawMonitor) {
+        createGpuProfiler();
+    }
+}
 
-    // Create pipeline layout
-    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutInfo.setLayoutCount = 1;
-    pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
-    pipelineLayoutInfo.pushConstantRangeCount = 0;
+void Engine::createPipelineLayout() {
+    IMPGINE_TRACE_FUNCTION();
+
+    // view/proj live in the per-frame UBO, everything per-draw goes through push constants;
+    // set 1 holds the lights and their clusters, set 2 the sun and its shadow maps,
+    // set 3 every texture when bindless, otherwise the current material's texture
+    pipelineLayout = PipelineLayoutBuilder(device)
+        .addDescriptorSetLayout(descriptorSetLayout)
+        .addDescriptorSetLayout(lightCulling->getDescriptorSetLayout())
+        .addDescriptorSetLayout(shadowMaps->getDescriptorSetLayout())
+        .addDescriptorSetLayout(bindlessTextures ? bindlessTextures->getDescriptorSetLayout() : materialSetLayout)
+        .addPushConstantRange(VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, sizeof(PushConstantData))
+        .build();
+}
 
-    if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &pipelineLayout) !=
-        VK_SUCCESS) {
-        throw std::runtime_error("failed to create pipeline layout!");
-    }
+void Engine::createGraphicsPipeline() {
+    IMPGINE_TRACE_FUNCTION();
 
-    // Create pipeline
     PipelineConfigInfo pipelineConfig{};
     Pipeline::defaultPipelineConfigInfo(pipelineConfig);
     pipelineConfig.renderPass = renderPass;
     pipelineConfig.pipelineLayout = pipelineLayout;
     pipelineConfig.multisampleInfo.rasterizationSamples = msaaSamples;
 
+    // shader.frag built with -DBINDLESS
+    std::string fragmentShader = bindlessTextures ? BINDLESS_FRAGMENT_SHADER : "shaders/frag.spv";
     pipeline =
-        std::make_unique<Pipeline>(device, "shaders/vert.spv", "shaders/frag.spv", pipelineConfig);
-        
-    createCommandBuffers();
+        std::make_unique<Pipeline>(device, "shaders/vert.spv", fragmentShader, pipelineConfig);
+
+    if (config.depthPrepass == DepthPrepassMode::Off) {
+        return;
+    }
+
+    // Prepass: depth only, from the position stream, with no fragment stage at all
+    PipelineConfigInfo prepassConfig{};
+    Pipeline::defaultPipelineConfigInfo(prepassConfig);
+    prepassConfig.bindingDescriptions = {Vertex::getPositionBindingDescription()};
+    prepassConfig.attributeDescriptions = {Vertex::getPositionAttributeDescription()};
+    prepassConfig.colorBlendAttachment.colorWriteMask = 0;
+    prepassConfig.renderPass = renderPass;
+    prepassConfig.pipelineLayout = pipelineLayout;
+    prepassConfig.multisampleInfo.rasterizationSamples = msaaSamples;
+    depthPrepassPipeline = std::make_unique<Pipeline>(device, "shaders/depth_vert.spv", "", prepassConfig);
+
+    // Main pass after a prepass: depth is final, so only the visible surface passes
+    pipelineConfig.depthStencilInfo.depthCompareOp = VK_COMPARE_OP_EQUAL;
+    pipelineConfig.depthStencilInfo.depthWriteEnable = VK_FALSE;
+    equalDepthPipeline = std::make_unique<Pipeline>(device, "shaders/vert.spv", fragmentShader, pipelineConfig);
+}
+
+void Engine::retirePipelines(uint64_t retireFrame) {
+    std::shared_ptr<Pipeline> oldPipeline = std::move(pipeline);
+    std::shared_ptr<Pipeline> oldPrepassPipeline = std::move(depthPrepassPipeline);
+    std::shared_ptr<Pipeline> oldEqualPipeline = std::move(equalDepthPipeline);
+    deletionQueue.push(retireFrame, [oldPipeline, oldPrepassPipeline, oldEqualPipeline]() mutable {
+        oldPipeline.reset();
+        oldPrepassPipeline.reset();
+        oldEqualPipeline.reset();
+    });
 }
 
 void Engine::mainLoop() {
+    if (config.headless) {
+        headlessLoop();
+        return;
+    }
+
+    // With a render thread this thread only owns GLFW, input and simulation and
+    // never blocks on fences or image acquisition
+    uint64_t frameLimit = totalFrameCount();
+    std::thread renderThread;
+    if (config.renderThread) {
+        // Frame counts, camera path samples and captured frames must each be
+        // one rendered frame
+        snapshotQueue.setLossless(frameLimit != 0 || cameraPath || captureWriter);
+        renderThread = std::thread(&Engine::renderLoop, this);
+    }
+
     auto lastTime = std::chrono::high_resolution_clock::now();
+    uint64_t framesRun = 0;
     
-    while (!window->shouldClose()) {
+    while (!window->shouldClose() && (frameLimit == 0 || framesRun < frameLimit)) {
+        // Nothing can be presented while minimized; block instead of spinning
+        if (window->isMinimized()) {
+            StallTracker::Scope stall(stallTracker.get(), StallCategory::Resize, "waitEvents");
+            window->waitEvents();
+            lastTime = std::chrono::high_resolution_clock::now();
+            continue;
+        }
+
+        IMPGINE_TRACE_SCOPE("frame");
+
+        // Limit before sampling input so the wait doesn't add to input latency
+        {
+            IMPGINE_TRACE_SCOPE("frameLimiter");
+            frameLimiter.wait();
+        }
+
         auto currentTime = std::chrono::high_resolution_clock::now();
         float deltaTime = std::chrono::duration<float>(currentTime - lastTime).count();
         lastTime = currentTime;
         
-        window->pollEvents();
-        processInput(deltaTime);
-        handleMouseMovement();
-        drawFrame();
+        {
+            IMPGINE_TRACE_SCOPE("pollEvents");
+            window->pollEvents();
+        }
+        jobs.pumpMainThread();
+        bool cameraMoved = true;
+        if (cameraPath) {
+            // Scripted runs ignore live input and the wall clock
+            applyCameraPath(framesRun);
+        } else {
+            // Both always run, so neither is left with a stale delta
+            bool moved = processInput(deltaTime);
+            bool turned = handleMouseMovement();
+            cameraMoved = moved || turned;
+        }
+
+        // On demand, an unchanged scene isn't drawn again: block until an event
+        // arrives or the idle redraw is due. The wait doesn't count as frame time
+        if (config.onDemand && !cameraMoved && !redrawRequested && !animating) {
+            double idleSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - lastRenderTime).count();
+            if (config.idleRedrawSeconds <= 0.0 || idleSeconds < config.idleRedrawSeconds) {
+                IMPGINE_TRACE_SCOPE("idle");
+                if (config.idleRedrawSeconds > 0.0) {
+                    window->waitEventsTimeout(config.idleRedrawSeconds - idleSeconds);
+                } else {
+                    window->waitEvents();
+                }
+                lastTime = std::chrono::high_resolution_clock::now();
+                continue;
+            }
+        }
+        redrawRequested = false;
+        lastRenderTime = std::chrono::steady_clock::now();
+
+        FrameSnapshot snapshot = captureSnapshot();
+        framesRun++;
+        if (!renderThread.joinable()) {
+            drawFrame(snapshot);
+        } else if (!snapshotQueue.push(std::move(snapshot))) {
+            break; // the render thread failed and closed the queue
+        }
+    }
+
+    if (renderThread.joinable()) {
+        snapshotQueue.close();
+        renderThread.join();
+    }
+    {
+        StallTracker::Scope stall(stallTracker.get(), StallCategory::Shutdown, "vkDeviceWaitIdle");
+        vkDeviceWaitIdle(device);
+    }
+
+    if (renderThreadError) {
+        std::rethrow_exception(renderThreadError);
+    }
+    finishBenchmark();
+}
+
+uint64_t Engine::totalFrameCount() const {
+    uint64_t measuredFrames = config.frameCount;
+    if (measuredFrames == 0 && cameraPath) {
+        measuredFrames = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(cameraPath->duration() / config.benchmarkTimeStep)));
+    }
+    if (measuredFrames == 0 && replayCapture) {
+        measuredFrames = replayCapture->frameCount();
     }
-    vkDeviceWaitIdle(device);
+    if (measuredFrames == 0 && config.headless) {
+        measuredFrames = 1;
+    }
+    return measuredFrames == 0 ? 0 : config.warmupFrames + measuredFrames;
+}
+
+void Engine::headlessLoop() {
+    // No input to sample: the camera follows the benchmark path or stays where
+    // it starts, and every frame is rendered inline, back to back
+    uint64_t frames = totalFrameCount();
+    for (uint64_t i = 0; i < frames; i++) {
+        if (replayCapture) {
+            FrameSnapshot snapshot = replaySnapshot(i);
+            VkExtent2D extent = offscreenTarget->getExtent();
+            if (snapshot.framebufferExtent.width != extent.width || snapshot.framebufferExtent.height != extent.height) {
+                resizeOffscreenTarget(snapshot.framebufferExtent);
+            }
+            drawFrame(snapshot);
+            continue;
+        }
+
+        if (cameraPath) {
+            applyCameraPath(i);
+        }
+        drawFrame(captureSnapshot());
+    }
+    {
+        StallTracker::Scope stall(stallTracker.get(), StallCategory::Shutdown, "vkDeviceWaitIdle");
+        vkDeviceWaitIdle(device);
+    }
+    finishBenchmark();
+
+    if (!config.outputImage.empty()) {
+        // currentFrame has already moved past the slot of the last frame
+        uint32_t lastImage = (currentFrame + SwapChain::MAX_FRAMES_IN_FLIGHT - 1) % SwapChain::MAX_FRAMES_IN_FLIGHT;
+        std::vector<uint8_t> pixels;
+        {
+            StallTracker::Scope stall(stallTracker.get(), StallCategory::Upload, "readPixels");
+            offscreenTarget->readPixels(commandPool, graphicsQueue, lastImage, pixels);
+        }
+        OffscreenTarget::writePpm(config.outputImage, offscreenTarget->getExtent(), pixels);
+        std::cout << "Wrote " << config.outputImage << std::endl;
+    }
+}
+
+void Engine::renderLoop() {
+    IMPGINE_TRACE_THREAD("render");
+
+    try {
+        FrameSnapshot snapshot;
+        while (snapshotQueue.pop(snapshot)) {
+            drawFrame(snapshot);
+        }
+    } catch (...) {
+        // Hand the error to the main thread, which rethrows it after joining
+        renderThreadError = std::current_exception();
+        snapshotQueue.close();
+    }
+}
+
+FrameSnapshot Engine::captureSnapshot() {
+    IMPGINE_TRACE_FUNCTION();
+
+    int width = 0, height = 0;
+    if (window) {
+        window->getFramebufferSize(&width, &height);
+    } else {
+        width = static_cast<int>(config.headlessExtent.width);
+        height = static_cast<int>(config.headlessExtent.height);
+    }
+
+    camera.setPerspectiveProjection(glm::radians(45.0f), width / (float) height, 0.1f, 100.0f);
+    camera.updateViewMatrix();
+
+    FrameSnapshot snapshot;
+    snapshot.sequence = ++snapshotSequence;
+    snapshot.view = camera.getView();
+    snapshot.proj = camera.getProjection();
+    snapshot.drawList = drawList;
+    snapshot.lights = lights;
+    snapshot.sun = sun;
+    snapshot.framebufferExtent = {static_cast<uint32_t>(width), static_cast<uint32_t>(height)};
+    snapshot.presentMode = config.presentMode;
+    snapshot.msaaSamples = config.msaaSamples;
+    snapshot.inputSampleTime = FrameLatencyTracker::Clock::now();
+    return snapshot;
 }
 
 void Engine::cleanupSwapChain() {
@@ -133,30 +539,95 @@ void Engine::cleanupSwapChain() {
     if (pipeline) {
         pipeline.reset();
     }
+    depthPrepassPipeline.reset();
+    equalDepthPipeline.reset();
 
     vkDestroyRenderPass(device, renderPass, nullptr);
 
+    upscaler.reset();
+    fxaaPass.reset();
     if (swapChain) {
         swapChain.reset();
     }
+    offscreenTarget.reset();
+}
+
+void Engine::retireSwapChainResources(uint64_t retireFrame) {
+    // Single-sample rendering has no separate color image
+    if (colorImage != VK_NULL_HANDLE) {
+        deletionQueue.retireImageView(retireFrame, colorImageView);
+        deletionQueue.retireImage(retireFrame, colorImage);
+        deletionQueue.retireMemory(retireFrame, colorImageMemory);
+    }
+
+    deletionQueue.retireImageView(retireFrame, depthImageView);
+    deletionQueue.retireImage(retireFrame, depthImage);
+    deletionQueue.retireMemory(retireFrame, depthImageMemory);
+
+    for (auto framebuffer : swapChainFramebuffers) {
+        deletionQueue.retireFramebuffer(retireFrame, framebuffer);
+    }
+    swapChainFramebuffers.clear();
+
+    if (upscaler) {
+        std::shared_ptr<Upscaler> oldUpscaler = std::move(upscaler);
+        deletionQueue.push(retireFrame, [oldUpscaler]() mutable {
+            oldUpscaler.reset();
+        });
+    }
+    if (fxaaPass) {
+        std::shared_ptr<FxaaPass> oldFxaaPass = std::move(fxaaPass);
+        deletionQueue.push(retireFrame, [oldFxaaPass]() mutable {
+            oldFxaaPass.reset();
+        });
     }
+}
 
 void Engine::cleanup() {
+    // Uploads may still be pending if no frame was ever rendered
+    {
+        StallTracker::Scope stall(stallTracker.get(), StallCategory::Shutdown, "vkDeviceWaitIdle");
+        vkDeviceWaitIdle(device);
+    }
+    deletionQueue.flush();
     cleanupSwapChain();
 
-    vkDestroySampler(device, textureSampler, nullptr);
-    vkDestroyImageView(device, textureImageView, nullptr);
+    // Workers may still be decoding into staging memory
+    for (const auto& pending : pendingTextures) {
+        jobs.wait(pending->decoded);
+        vkUnmapMemory(device, pending->stagingMemory);
+        vkDestroyBuffer(device, pending->stagingBuffer, nullptr);
+        vkFreeMemory(device, pending->stagingMemory, nullptr);
+    }
+    pendingTextures.clear();
+    jobs.wait(textureRedraws);
 
-    vkDestroyImage(device, textureImage, nullptr);
-    vkFreeMemory(device, textureImageMemory, nullptr);
+    // The bindless layout holds the sampler as an immutable sampler
+    bindlessTextures.reset();
+    vkDestroySampler(device, textureSampler, nullptr);
+    // Textures that never finished decoding have null handles, which destroying ignores
+    for (const auto& texture : materialTextures) {
+        vkDestroyImageView(device, texture.view, nullptr);
+        vkDestroyImage(device, texture.image, nullptr);
+        vkFreeMemory(device, texture.memory, nullptr);
+    }
+    vkDestroyImageView(device, placeholderTexture.view, nullptr);
+    vkDestroyImage(device, placeholderTexture.image, nullptr);
+    vkFreeMemory(device, placeholderTexture.memory, nullptr);
 
     for (size_t i = 0; i < uniformBuffers.size(); i++) {
         vkDestroyBuffer(device, uniformBuffers[i], nullptr);
         vkFreeMemory(device, uniformBuffersMemory[i], nullptr);
     }
 
+    gpuProfiler.reset();
+    lightCulling.reset();
+    shadowMaps.reset();
+
     vkDestroyDescriptorPool(device, descriptorPool, nullptr);
     vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+    vkDestroyDescriptorPool(device, materialDescriptorPool, nullptr);
+    vkDestroyDescriptorSetLayout(device, materialSetLayout, nullptr);
 
     vkDestroyBuffer(device, indexBuffer, nullptr);
     vkFreeMemory(device, indexBufferMemory, nullptr);
@@ -164,6 +635,9 @@ void Engine::cleanup() {
     vkDestroyBuffer(device, vertexBuffer, nullptr);
     vkFreeMemory(device, vertexBufferMemory, nullptr);
 
+    vkDestroyBuffer(device, positionBuffer, nullptr);
+    vkFreeMemory(device, positionBufferMemory, nullptr);
+
     if (pipelineLayout != VK_NULL_HANDLE) {
         vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
     }
@@ -190,6 +664,8 @@ void Engine::cleanup() {
 }
 
 void Engine::createInstance() {
+    IMPGINE_TRACE_FUNCTION();
+
     if (enableValidationLayers && !checkValidationLayerSupport()) {
         throw std::runtime_error("validation layers requested, but not available!");
     }
@@ -209,6 +685,20 @@ void Engine::createInstance() {
     auto extensions = getRequiredExtensions();
     extensions.push_back(VK_KHR_PORTABILITY_ENUMERATION_EXTENSION_NAME);
 
+    // A 1.0 instance can only query descriptor indexing support through this extension
+    if (config.bindless) {
+        uint32_t extensionCount = 0;
+        vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+        std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+        vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, availableExtensions.data());
+        for (const auto& extension : availableExtensions) {
+            if (strcmp(extension.extensionName, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME) == 0) {
+                extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+                physicalDeviceProperties2 = true;
+            }
+        }
+    }
+
     createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
     createInfo.ppEnabledExtensionNames = extensions.data();
     createInfo.flags |= VK_INSTANCE_CREATE_ENUMERATE_PORTABILITY_BIT_KHR;
@@ -268,6 +758,8 @@ void Engine::populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT
 }
 
 void Engine::setupDebugMessenger() {
+    IMPGINE_TRACE_FUNCTION();
+
     if (!enableValidationLayers) return;
 
     VkDebugUtilsMessengerCreateInfoEXT createInfo;
@@ -286,8 +778,9 @@ bool Engine::isDeviceSuitable(VkPhysicalDevice device) {
 
     bool extensionsSupported = checkDeviceExtensionSupport(device);
 
-    bool swapChainAdequate = false;
-    if (extensionsSupported) {
+    // Headless rendering has no surface to present to
+    bool swapChainAdequate = config.headless;
+    if (extensionsSupported && !config.headless) {
         auto swapChainSupport = SwapChain::querySwapChainSupport(device, surface);
         swapChainAdequate =
             !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
@@ -307,7 +800,8 @@ bool Engine::checkDeviceExtensionSupport(VkPhysicalDevice device) {
     vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount,
                                          availableExtensions.data());
 
-    std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
+    std::vector<const char*> wantedExtensions = getRequiredDeviceExtensions();
+    std::set<std::string> requiredExtensions(wantedExtensions.begin(), wantedExtensions.end());
 
     // Check if portability subset is available and add it if needed
     bool portabilitySubsetAvailable = false;
@@ -325,6 +819,8 @@ bool Engine::checkDeviceExtensionSupport(VkPhysicalDevice device) {
 }
 
 void Engine::pickPhysicalDevice() {
+    IMPGINE_TRACE_FUNCTION();
+
     uint32_t deviceCount = 0;
     vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
     if (deviceCount == 0) {
@@ -337,7 +833,7 @@ void Engine::pickPhysicalDevice() {
     for (const auto& device : devices) {
         if (isDeviceSuitable(device)) {
             physicalDevice = device;
-            msaaSamples = getMaxUsableSampleCount();
+            usableSampleCounts = getUsableSampleCounts();
             break;
         }
     }
@@ -363,7 +859,12 @@ QueueFamilyIndices Engine::findQueueFamilies(VkPhysicalDevice device) {
         }
 
         VkBool32 presentSupport = false;
-        vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
+        if (surface != VK_NULL_HANDLE) {
+            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
+        } else {
+            // Nothing is presented; reuse the graphics queue so device setup stays the same
+            presentSupport = indices.graphicsFamily.has_value();
+        }
 
         if (presentSupport) {
             indices.presentFamily = i;
@@ -379,6 +880,8 @@ QueueFamilyIndices Engine::findQueueFamilies(VkPhysicalDevice device) {
 }
 
 void Engine::createLogicalDevice() {
+    IMPGINE_TRACE_FUNCTION();
+
     QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
 
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
@@ -395,8 +898,55 @@ void Engine::createLogicalDevice() {
         queueCreateInfos.push_back(queueCreateInfo);
     }
 
+    VkPhysicalDeviceFeatures supportedFeatures;
+    vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
     VkPhysicalDeviceFeatures deviceFeatures{};
     deviceFeatures.samplerAnisotropy = VK_TRUE;
+    // Overdraw for the depth prepass comes from the fragment invocation counter
+    if (config.pipelineStatistics || config.depthPrepass != DepthPrepassMode::Off) {
+        pipelineStatisticsSupported = supportedFeatures.pipelineStatisticsQuery == VK_TRUE;
+        deviceFeatures.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
+        if (!pipelineStatisticsSupported && config.pipelineStatistics) {
+            std::cerr << "pipeline statistics queries unsupported; only timestamps will be reported" << std::endl;
+        }
+        if (!pipelineStatisticsSupported && config.depthPrepass == DepthPrepassMode::Auto) {
+            std::cerr << "pipeline statistics queries unsupported; overdraw can't be measured and the depth prepass stays off" << std::endl;
+        }
+    }
+
+    // Bindless textures index a sampled-image array with a push constant
+    VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexingFeatures = BindlessTextures::requiredFeatures();
+    if (config.bindless && !std::ifstream(BINDLESS_FRAGMENT_SHADER)) {
+        std::cerr << BINDLESS_FRAGMENT_SHADER << " not found (shaders/shader.frag compiled with -DBINDLESS); every texture gets its own descriptor set" << std::endl;
+    } else if (config.bindless) {
+        bindlessCapacity = physicalDeviceProperties2 ? BindlessTextures::queryCapacity(instance, physicalDevice) : 0;
+        if (bindlessCapacity > 0) {
+            deviceFeatures.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
+        } else {
+            std::cerr << "descriptor indexing unsupported; every texture gets its own descriptor set" << std::endl;
+        }
+    }
+
+    // BC formats are optional; the sRGB variant also has to filter linearly
+    // for the trilinear sampler
+    if (config.textureCompression) {
+        VkFormat compressedFormat = VK_FORMAT_BC7_SRGB_BLOCK;
+        if (config.textureFormat == BlockFormat::BC1) {
+            compressedFormat = VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+        } else if (config.textureFormat == BlockFormat::BC3) {
+            compressedFormat = VK_FORMAT_BC3_SRGB_BLOCK;
+        }
+        VkFormatProperties formatProperties;
+        vkGetPhysicalDeviceFormatProperties(physicalDevice, compressedFormat, &formatProperties);
+        VkFormatFeatureFlags sampled = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+        if (supportedFeatures.textureCompressionBC && (formatProperties.optimalTilingFeatures & sampled) == sampled) {
+            deviceFeatures.textureCompressionBC = VK_TRUE;
+            textureFormat = compressedFormat;
+        } else {
+            std::cerr << "BC texture compression unsupported; textures are uploaded as RGBA8" << std::endl;
+        }
+    }
 
     VkDeviceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -407,10 +957,15 @@ void Engine::createLogicalDevice() {
     createInfo.pEnabledFeatures = &deviceFeatures;
 
     // Add portability subset extension if needed
-    std::vector<const char*> extensions = deviceExtensions;
+    std::vector<const char*> extensions = getRequiredDeviceExtensions();
     if (needsPortabilitySubset) {
         extensions.push_back("VK_KHR_portability_subset");
     }
+    if (bindlessCapacity > 0) {
+        const auto& bindlessExtensions = BindlessTextures::requiredDeviceExtensions();
+        extensions.insert(extensions.end(), bindlessExtensions.begin(), bindlessExtensions.end());
+        createInfo.pNext = &indexingFeatures;
+    }
 
     createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
     createInfo.ppEnabledExtensionNames = extensions.data();
@@ -426,16 +981,29 @@ void Engine::createLogicalDevice() {
         throw std::runtime_error("failed to create logical device!");
     }
 
+    deletionQueue.setDevice(device);
+
     vkGetDeviceQueue(device, indices.graphicsFamily.value(), 0, &graphicsQueue);
     vkGetDeviceQueue(device, indices.presentFamily.value(), 0, &presentQueue);
 }
 
+std::vector<const char*> Engine::getRequiredDeviceExtensions() {
+    if (config.headless) {
+        return {};
+    }
+    return deviceExtensions;
+}
+
 std::vector<const char*> Engine::getRequiredExtensions() {
-    uint32_t glfwExtensionCount = 0;
-    const char** glfwExtensions;
-    glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+    std::vector<const char*> extensions;
 
-    std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    // Surface extensions are only needed to present to a window
+    if (!config.headless) {
+        uint32_t glfwExtensionCount = 0;
+        const char** glfwExtensions;
+        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+        extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    }
 
     if (enableValidationLayers) {
         extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -445,6 +1013,8 @@ std::vector<const char*> Engine::getRequiredExtensions() {
 }
 
 void Engine::createCommandPool() {
+    IMPGINE_TRACE_FUNCTION();
+
     QueueFamilyIndices queueFamilyIndices = findQueueFamilies(physicalDevice);
 
     VkCommandPoolCreateInfo poolInfo{};
@@ -579,9 +1149,10 @@ void Engine::endSingleTimeCommands(VkCommandBuffer commandBuffer) {
     submitInfo.pCommandBuffers = &commandBuffer;
 
     vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-    vkQueueWaitIdle(graphicsQueue);
 
-    vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
+    // No wait: the queue executes in submission order, so the next frame's fence
+    // covers this work and frees the command buffer (and any staging) with it
+    deletionQueue.retireCommandBuffer(nextFrameNumber(), commandPool, commandBuffer);
 }
 
 void Engine::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
@@ -690,49 +1261,67 @@ void Engine::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, u
 }
 
 void Engine::loadModel() {
-    tinyobj::attrib_t attrib;
-    std::vector<tinyobj::shape_t> shapes;
-    std::vector<tinyobj::material_t> materials;
-    std::string warn, err;
-
-    if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, MODEL_PATH.c_str())) {
-        throw std::runtime_error(err);
+    IMPGINE_TRACE_FUNCTION();
+
+    MeshLoadOptions options;
+    options.generateNormals = config.generateNormals;
+    options.normalWeighting = config.normalWeighting;
+    options.creaseAngle = glm::radians(config.creaseAngle);
+    options.bakeOcclusion = config.occlusionSamples > 0;
+    options.occlusion.samples = config.occlusionSamples;
+
+    // Runs as a job itself; the chunks of each stage are helped along by the waiting thread
+    MeshData mesh = config.meshCache ? loadCachedMesh(MODEL_PATH, options, &jobs) : loadObjMesh(MODEL_PATH, options, &jobs);
+    if (config.loadReport) {
+        mesh.stats.report(std::cout);
+    }
+    vertices = std::move(mesh.vertices);
+    materials = std::move(mesh.materials);
+    meshRanges = std::move(mesh.ranges);
+    // Faces without a material keep the texture the engine always used
+    for (auto& material : materials) {
+        if (material.name.empty() && material.diffuseTexture.empty()) {
+            material.diffuseTexture = TEXTURE_PATH;
+        }
     }
+    indices = std::move(mesh.indices);
+}
 
-    std::unordered_map<Vertex, uint32_t> uniqueVertices{};
-
-    for (const auto& shape : shapes) {
-        for (const auto& index : shape.mesh.indices) {
-            Vertex vertex{};
-
-            vertex.pos = {
-                attrib.vertices[3 * index.vertex_index + 0],
-                attrib.vertices[3 * index.vertex_index + 1],
-                attrib.vertices[3 * index.vertex_index + 2]
-            };
-
-            if (index.texcoord_index >= 0 && index.texcoord_index < attrib.texcoords.size() / 2) {
-                vertex.texCoord = {
-                    attrib.texcoords[2 * index.texcoord_index + 0],
-                    1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
-                };
-            } else {
-                vertex.texCoord = {0.0f, 0.0f};
-            }
-
-            vertex.color = {1.0f, 1.0f, 1.0f};
-
-            if (uniqueVertices.count(vertex) == 0) {
-                uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-                vertices.push_back(vertex);
+void Engine::buildDrawList() {
+    IMPGINE_TRACE_FUNCTION();
+
+    drawList.clear();
+
+    // One draw per material range, grouped by texture so the recorder only
+    // rebinds the material set when the texture actually changes
+    for (const auto& range : meshRanges) {
+        DrawItem item{};
+        item.model = glm::rotate(glm::mat4(1.0f), glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+        item.firstIndex = range.firstIndex;
+        item.indexCount = range.indexCount;
+        item.objectIndex = 0;
+        item.materialIndex = range.materialIndex;
+        drawList.push_back(item);
+    }
+    std::stable_sort(drawList.begin(), drawList.end(), [this](const DrawItem& a, const DrawItem& b) {
+        return materialTextureIndices[a.materialIndex] < materialTextureIndices[b.materialIndex];
+    });
+
+    // Captured draw lists index the materials; an older capture may predate a split
+    if (replayCapture) {
+        for (size_t frame = 0; frame < replayCapture->frameCount(); frame++) {
+            for (const auto& item : replayCapture->getFrame(frame).drawList) {
+                if (item.materialIndex >= materials.size() || item.firstIndex > indices.size() || item.indexCount > indices.size() - item.firstIndex) {
+                    throw std::runtime_error("capture draws outside the loaded model!");
+                }
             }
-
-            indices.push_back(uniqueVertices[vertex]);
         }
     }
 }
 
 void Engine::createVertexBuffer() {
+    IMPGINE_TRACE_FUNCTION();
+
     VkDeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
 
     VkBuffer stagingBuffer;
@@ -748,11 +1337,44 @@ void Engine::createVertexBuffer() {
 
     copyBuffer(stagingBuffer, vertexBuffer, bufferSize);
 
-    vkDestroyBuffer(device, stagingBuffer, nullptr);
-    vkFreeMemory(device, stagingBufferMemory, nullptr);
+    deletionQueue.retireBuffer(nextFrameNumber(), stagingBuffer);
+    deletionQueue.retireMemory(nextFrameNumber(), stagingBufferMemory);
+}
+
+void Engine::createPositionBuffer() {
+    IMPGINE_TRACE_FUNCTION();
+
+    if (config.depthPrepass == DepthPrepassMode::Off && !config.shadows) {
+        return;
+    }
+
+    // Depth-only passes only read positions, so they stream a third of the interleaved data
+    std::vector<glm::vec3> positions(vertices.size());
+    for (size_t i = 0; i < vertices.size(); i++) {
+        positions[i] = vertices[i].pos;
+    }
+    VkDeviceSize bufferSize = sizeof(positions[0]) * positions.size();
+
+    VkBuffer stagingBuffer;
+    VkDeviceMemory stagingBufferMemory;
+    createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+
+    void* data;
+    vkMapMemory(device, stagingBufferMemory, 0, bufferSize, 0, &data);
+        memcpy(data, positions.data(), (size_t) bufferSize);
+    vkUnmapMemory(device, stagingBufferMemory);
+
+    createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, positionBuffer, positionBufferMemory);
+
+    copyBuffer(stagingBuffer, positionBuffer, bufferSize);
+
+    deletionQueue.retireBuffer(nextFrameNumber(), stagingBuffer);
+    deletionQueue.retireMemory(nextFrameNumber(), stagingBufferMemory);
 }
 
 void Engine::createIndexBuffer() {
+    IMPGINE_TRACE_FUNCTION();
+
     VkDeviceSize bufferSize = sizeof(indices[0]) * indices.size();
 
     VkBuffer stagingBuffer;
@@ -768,22 +1390,28 @@ void Engine::createIndexBuffer() {
 
     copyBuffer(stagingBuffer, indexBuffer, bufferSize);
 
-    vkDestroyBuffer(device, stagingBuffer, nullptr);
-    vkFreeMemory(device, stagingBufferMemory, nullptr);
+    deletionQueue.retireBuffer(nextFrameNumber(), stagingBuffer);
+    deletionQueue.retireMemory(nextFrameNumber(), stagingBufferMemory);
 }
 
 void Engine::createUniformBuffers() {
+    IMPGINE_TRACE_FUNCTION();
+
     VkDeviceSize bufferSize = sizeof(UniformBufferObject);
 
-    uniformBuffers.resize(swapChain->imageCount());
-    uniformBuffersMemory.resize(swapChain->imageCount());
+    // One per frame in flight: a frame only writes its own after waiting on its fence,
+    // so these don't depend on the swap chain and survive recreation
+    uniformBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+    uniformBuffersMemory.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
 
-    for (size_t i = 0; i < swapChain->imageCount(); i++) {
+    for (size_t i = 0; i < SwapChain::MAX_FRAMES_IN_FLIGHT; i++) {
         createBuffer(bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, uniformBuffers[i], uniformBuffersMemory[i]);
     }
 }
 
 void Engine::createDescriptorSetLayout() {
+    IMPGINE_TRACE_FUNCTION();
+
     VkDescriptorSetLayoutBinding uboLayoutBinding{};
     uboLayoutBinding.binding = 0;
     uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
@@ -791,14 +1419,7 @@ void Engine::createDescriptorSetLayout() {
     uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
     uboLayoutBinding.pImmutableSamplers = nullptr; // Optional
 
-    VkDescriptorSetLayoutBinding samplerLayoutBinding{};
-    samplerLayoutBinding.binding = 1;
-    samplerLayoutBinding.descriptorCount = 1;
-    samplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    samplerLayoutBinding.pImmutableSamplers = nullptr;
-    samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-
-    std::array<VkDescriptorSetLayoutBinding, 2> bindings = {uboLayoutBinding, samplerLayoutBinding};
+    std::array<VkDescriptorSetLayoutBinding, 1> bindings = {uboLayoutBinding};
     VkDescriptorSetLayoutCreateInfo layoutInfo{};
     layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
     layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
@@ -807,51 +1428,89 @@ void Engine::createDescriptorSetLayout() {
     if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
         throw std::runtime_error("failed to create descriptor set layout!");
     }
+
+    // Set 3: the diffuse texture, one set per distinct texture; bindless
+    // textures bring their own layout
+    if (bindlessTextures) {
+        return;
+    }
+
+    VkDescriptorSetLayoutBinding samplerLayoutBinding{};
+    samplerLayoutBinding.binding = 0;
+    samplerLayoutBinding.descriptorCount = 1;
+    samplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    samplerLayoutBinding.pImmutableSamplers = nullptr;
+    samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    VkDescriptorSetLayoutCreateInfo materialLayoutInfo{};
+    materialLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    materialLayoutInfo.bindingCount = 1;
+    materialLayoutInfo.pBindings = &samplerLayoutBinding;
+
+    if (vkCreateDescriptorSetLayout(device, &materialLayoutInfo, nullptr, &materialSetLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create material descriptor set layout!");
+    }
 }
 
 void Engine::createDescriptorPool() {
-    std::array<VkDescriptorPoolSize, 2> poolSizes{};
+    IMPGINE_TRACE_FUNCTION();
+
+    std::array<VkDescriptorPoolSize, 1> poolSizes{};
     poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    poolSizes[0].descriptorCount = static_cast<uint32_t>(swapChain->imageCount());
-    poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    poolSizes[1].descriptorCount = static_cast<uint32_t>(swapChain->imageCount());
+    poolSizes[0].descriptorCount = static_cast<uint32_t>(SwapChain::MAX_FRAMES_IN_FLIGHT);
 
     VkDescriptorPoolCreateInfo poolInfo{};
     poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
     poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
     poolInfo.pPoolSizes = poolSizes.data();
-    poolInfo.maxSets = static_cast<uint32_t>(swapChain->imageCount());
+    poolInfo.maxSets = static_cast<uint32_t>(SwapChain::MAX_FRAMES_IN_FLIGHT);
 
     if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
         throw std::runtime_error("failed to create descriptor pool!");
     }
+
+    if (bindlessTextures) {
+        return;
+    }
+
+    // One set per texture plus the placeholder's
+    VkDescriptorPoolSize materialPoolSize{};
+    materialPoolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    materialPoolSize.descriptorCount = static_cast<uint32_t>(materialTextures.size() + 1);
+
+    VkDescriptorPoolCreateInfo materialPoolInfo{};
+    materialPoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    materialPoolInfo.poolSizeCount = 1;
+    materialPoolInfo.pPoolSizes = &materialPoolSize;
+    materialPoolInfo.maxSets = static_cast<uint32_t>(materialTextures.size() + 1);
+
+    if (vkCreateDescriptorPool(device, &materialPoolInfo, nullptr, &materialDescriptorPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create material descriptor pool!");
+    }
 }
 
 void Engine::createDescriptorSets() {
-    std::vector<VkDescriptorSetLayout> layouts(swapChain->imageCount(), descriptorSetLayout);
+    IMPGINE_TRACE_FUNCTION();
+
+    std::vector<VkDescriptorSetLayout> layouts(SwapChain::MAX_FRAMES_IN_FLIGHT, descriptorSetLayout);
     VkDescriptorSetAllocateInfo allocInfo{};
     allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
     allocInfo.descriptorPool = descriptorPool;
-    allocInfo.descriptorSetCount = static_cast<uint32_t>(swapChain->imageCount());
+    allocInfo.descriptorSetCount = static_cast<uint32_t>(SwapChain::MAX_FRAMES_IN_FLIGHT);
     allocInfo.pSetLayouts = layouts.data();
 
-    descriptorSets.resize(swapChain->imageCount());
+    descriptorSets.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
     if (vkAllocateDescriptorSets(device, &allocInfo, descriptorSets.data()) != VK_SUCCESS) {
         throw std::runtime_error("failed to allocate descriptor sets!");
     }
 
-    for (size_t i = 0; i < swapChain->imageCount(); i++) {
+    for (size_t i = 0; i < SwapChain::MAX_FRAMES_IN_FLIGHT; i++) {
         VkDescriptorBufferInfo bufferInfo{};
         bufferInfo.buffer = uniformBuffers[i];
         bufferInfo.offset = 0;
         bufferInfo.range = sizeof(UniformBufferObject);
 
-        VkDescriptorImageInfo imageInfo{};
-        imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        imageInfo.imageView = textureImageView;
-        imageInfo.sampler = textureSampler;
-
-        std::array<VkWriteDescriptorSet, 2> descriptorWrites{};
+        std::array<VkWriteDescriptorSet, 1> descriptorWrites{};
 
         descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
         descriptorWrites[0].dstSet = descriptorSets[i];
@@ -861,65 +1520,330 @@ void Engine::createDescriptorSets() {
         descriptorWrites[0].descriptorCount = 1;
         descriptorWrites[0].pBufferInfo = &bufferInfo;
 
-        descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[1].dstSet = descriptorSets[i];
-        descriptorWrites[1].dstBinding = 1;
-        descriptorWrites[1].dstArrayElement = 0;
-        descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        descriptorWrites[1].descriptorCount = 1;
-        descriptorWrites[1].pImageInfo = &imageInfo;
-
         vkUpdateDescriptorSets(device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
     }
 }
 
-void Engine::createTextureImage() {
-    int texWidth, texHeight, texChannels;
-    stbi_uc* pixels = stbi_load(TEXTURE_PATH.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+void Engine::createMaterialDescriptorSets() {
+    IMPGINE_TRACE_FUNCTION();
 
-    if (!pixels) {
-        std::cout << "Texture not found in textures folder, trying the base texture.jpg" << std::endl;
-        // callback to the texture.jpg base image 
-        pixels = stbi_load("textures/texture.jpg", &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-
-        if (!pixels) {
-            throw std::runtime_error("échec du chargement d'une image!");
-        }
+    if (bindlessTextures) {
+        return;
     }
 
-    // Calculate mipLevels and imageSize AFTER we have valid texture dimensions
-    mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(texWidth, texHeight)))) + 1;
-    VkDeviceSize imageSize = texWidth * texHeight * 4;
+    // Textures never change after loading, so unlike set 0 these aren't per frame.
+    // The placeholder gets the last one
+    std::vector<VkDescriptorSetLayout> layouts(materialTextures.size() + 1, materialSetLayout);
+    std::vector<VkDescriptorSet> sets(layouts.size());
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = materialDescriptorPool;
+    allocInfo.descriptorSetCount = static_cast<uint32_t>(sets.size());
+    allocInfo.pSetLayouts = layouts.data();
 
-    VkBuffer stagingBuffer;
-    VkDeviceMemory stagingBufferMemory;
-    createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+    if (vkAllocateDescriptorSets(device, &allocInfo, sets.data()) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate material descriptor sets!");
+    }
 
-    void* data;
-    vkMapMemory(device, stagingBufferMemory, 0, imageSize, 0, &data);
-        memcpy(data, pixels, static_cast<size_t>(imageSize));
-    vkUnmapMemory(device, stagingBufferMemory);
+    placeholderTexture.descriptorSet = sets.back();
+    writeMaterialDescriptorSet(placeholderTexture);
+
+    // Textures still decoding are written once they are uploaded, before any draw binds them
+    for (size_t i = 0; i < materialTextures.size(); i++) {
+        materialTextures[i].descriptorSet = sets[i];
+        if (materialTextures[i].ready) {
+            writeMaterialDescriptorSet(materialTextures[i]);
+        }
+    }
+}
 
-    stbi_image_free(pixels);
+void Engine::writeMaterialDescriptorSet(const MaterialTexture& texture) {
+    VkDescriptorImageInfo imageInfo{};
+    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    imageInfo.imageView = texture.view;
+    imageInfo.sampler = textureSampler;
+
+    VkWriteDescriptorSet descriptorWrite{};
+    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrite.dstSet = texture.descriptorSet;
+    descriptorWrite.dstBinding = 0;
+    descriptorWrite.dstArrayElement = 0;
+    descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descriptorWrite.descriptorCount = 1;
+    descriptorWrite.pImageInfo = &imageInfo;
+
+    vkUpdateDescriptorSets(device, 1, &descriptorWrite, 0, nullptr);
+}
 
-    createImage(texWidth, texHeight, mipLevels, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageMemory);
+void Engine::startMaterialTextures() {
+    IMPGINE_TRACE_FUNCTION();
 
-    transitionImageLayout(textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevels);
-    copyBufferToImage(stagingBuffer, textureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
-    //transitionné vers VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL lors de la generation des mipmaps
-    
-    generateMipmaps(textureImage, VK_FORMAT_R8G8B8A8_SRGB, texWidth, texHeight, mipLevels);
+    // Untextured materials sample white, leaving just their diffuse color; so
+    // do textured ones until their file is decoded and uploaded
+    const stbi_uc white[4] = {255, 255, 255, 255};
+    placeholderTexture = createMaterialTexture(white, 1, 1);
 
-    vkDestroyBuffer(device, stagingBuffer, nullptr);
-    vkFreeMemory(device, stagingBufferMemory, nullptr);
+    for (const Material& material : loadObjMaterials(MODEL_PATH)) {
+        if (!material.diffuseTexture.empty()) {
+            materialTexture(material.diffuseTexture);
+        }
+    }
 }
 
-void Engine::createTextureImageView() {
-    textureImageView = createImageView(textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT, mipLevels);
+void Engine::createMaterialTextures() {
+    IMPGINE_TRACE_FUNCTION();
+
+    materialTextureIndices.resize(materials.size());
+    for (size_t i = 0; i < materials.size(); i++) {
+        materialTextureIndices[i] = materialTexture(materials[i].diffuseTexture);
+    }
 }
 
-void Engine::createTextureSampler() {
-    VkSamplerCreateInfo samplerInfo{};
+uint32_t Engine::materialTexture(const std::string& path) {
+    // Materials naming the same file, or files with the same contents, share an image
+    auto known = texturesByPath.find(path);
+    if (known != texturesByPath.end()) {
+        return known->second;
+    }
+
+    uint32_t textureIndex;
+    if (path.empty()) {
+        const stbi_uc white[4] = {255, 255, 255, 255};
+        textureIndex = static_cast<uint32_t>(materialTextures.size());
+        materialTextures.push_back(createMaterialTexture(white, 1, 1));
+    } else {
+        std::string source = resolveTexturePath(path);
+        if (source != path) {
+            std::cout << "Texture " << path << " not found, using " << FALLBACK_TEXTURE_PATH << std::endl;
+        }
+
+        uint64_t contentHash = FrameCapture::hashFile(source);
+        auto same = texturesByContent.find(contentHash);
+        if (same != texturesByContent.end()) {
+            textureIndex = same->second;
+        } else {
+            uint32_t width, height;
+            if (!readTextureSize(source, width, height)) {
+                throw std::runtime_error("échec du chargement d'une image!");
+            }
+            textureIndex = static_cast<uint32_t>(materialTextures.size());
+            materialTextures.push_back(MaterialTexture{});
+            startTextureDecode(textureIndex, source, width, height);
+            texturesByContent[contentHash] = textureIndex;
+        }
+    }
+
+    texturesByPath[path] = textureIndex;
+    return textureIndex;
+}
+
+std::string Engine::resolveTexturePath(const std::string& path) {
+    return std::ifstream(path) ? path : FALLBACK_TEXTURE_PATH;
+}
+
+std::vector<std::string> Engine::sceneAssetPaths() {
+    std::vector<std::string> paths = {MODEL_PATH, TEXTURE_PATH};
+    for (const std::string& library : objMaterialLibraries(MODEL_PATH)) {
+        paths.push_back(library);
+    }
+    for (const Material& material : loadObjMaterials(MODEL_PATH)) {
+        if (!material.diffuseTexture.empty()) {
+            std::string source = resolveTexturePath(material.diffuseTexture);
+            if (std::find(paths.begin(), paths.end(), source) == paths.end()) {
+                paths.push_back(source);
+            }
+        }
+    }
+    return paths;
+}
+
+void Engine::startTextureDecode(uint32_t textureIndex, const std::string& source, uint32_t width, uint32_t height) {
+    auto pending = std::make_unique<PendingTexture>();
+    pending->textureIndex = textureIndex;
+    pending->source = source;
+    pending->width = width;
+    pending->height = height;
+    pending->format = textureFormat;
+    pending->fromCache = false;
+
+    // Sized for the decoder's output allocation, which it is handed directly,
+    // or for the compressed mip chain
+    bool compressed = textureFormat != VK_FORMAT_R8G8B8A8_SRGB;
+    VkDeviceSize bufferSize = compressed ? compressedMipChainSize(config.textureFormat, width, height) : decodeBufferSize(width, height);
+    createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, pending->stagingBuffer, pending->stagingMemory);
+    vkMapMemory(device, pending->stagingMemory, 0, bufferSize, 0, &pending->mapped);
+
+    PendingTexture* decode = pending.get();
+    pendingTextures.push_back(std::move(pending));
+    jobs.submit([this, decode, compressed]() {
+        IMPGINE_TRACE_SCOPE("decodeTexture");
+        try {
+            if (compressed) {
+                // A cache miss encodes on the pool; this job helps while it waits
+                decode->fromCache = loadCompressedTexture(decode->source, config.textureFormat, decode->width, decode->height, static_cast<uint8_t*>(decode->mapped), &jobs);
+            } else {
+                decodeTextureInto(decode->source, decode->mapped, decode->width, decode->height);
+            }
+        } catch (...) {
+            decode->error = std::current_exception();
+        }
+    }, &decode->decoded);
+
+    // An idle on-demand window has to draw again to show the texture. Asked
+    // only once the counter is released, or the frame it triggers could still
+    // see the decode as running and leave the placeholder up
+    if (window) {
+        jobs.submitAfter(decode->decoded, [this]() { requestRedraw(); }, &textureRedraws);
+    }
+}
+
+void Engine::uploadDecodedTextures(bool waitForAll) {
+    if (pendingTextures.empty()) {
+        return;
+    }
+    IMPGINE_TRACE_FUNCTION();
+
+    if (waitForAll) {
+        for (const auto& pending : pendingTextures) {
+            jobs.wait(pending->decoded);
+        }
+    }
+
+    auto firstRunning = std::stable_partition(pendingTextures.begin(), pendingTextures.end(), [](const std::unique_ptr<PendingTexture>& pending) {
+        return pending->decoded.isDone();
+    });
+    if (firstRunning == pendingTextures.begin()) {
+        return;
+    }
+    // Failed decodes stay pending, so cleanup still frees their staging buffers
+    for (auto it = pendingTextures.begin(); it != firstRunning; ++it) {
+        if ((*it)->error) {
+            std::rethrow_exception((*it)->error);
+        }
+    }
+
+    // Everything decoded since the last frame goes up in one submission, queued
+    // ahead of the frame that first samples it
+    VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+    for (auto it = pendingTextures.begin(); it != firstRunning; ++it) {
+        PendingTexture& pending = **it;
+        vkUnmapMemory(device, pending.stagingMemory);
+        recordTextureUpload(commandBuffer, pending.stagingBuffer, pending.width, pending.height, pending.format, materialTextures[pending.textureIndex]);
+        if (config.loadReport) {
+            VkDeviceSize uncompressed = static_cast<VkDeviceSize>(pending.width) * pending.height * 4 * 4 / 3;
+            VkDeviceSize uploaded = pending.format == VK_FORMAT_R8G8B8A8_SRGB ? uncompressed : compressedMipChainSize(config.textureFormat, pending.width, pending.height);
+            std::cout << "Texture " << pending.source << ": " << (pending.format == VK_FORMAT_R8G8B8A8_SRGB ? "rgba8" : blockFormatName(config.textureFormat))
+                      << (pending.fromCache ? " (cached)" : "") << ", " << uploaded / 1024 << " KiB in VRAM vs " << uncompressed / 1024 << " KiB as RGBA8" << std::endl;
+        }
+        deletionQueue.retireBuffer(nextFrameNumber(), pending.stagingBuffer);
+        deletionQueue.retireMemory(nextFrameNumber(), pending.stagingMemory);
+    }
+    endSingleTimeCommands(commandBuffer);
+
+    for (auto it = pendingTextures.begin(); it != firstRunning; ++it) {
+        activateTexture(materialTextures[(*it)->textureIndex]);
+    }
+    pendingTextures.erase(pendingTextures.begin(), firstRunning);
+}
+
+Engine::MaterialTexture Engine::createMaterialTexture(const stbi_uc* pixels, uint32_t width, uint32_t height) {
+    IMPGINE_TRACE_FUNCTION();
+
+    VkDeviceSize imageSize = static_cast<VkDeviceSize>(width) * height * 4;
+
+    VkBuffer stagingBuffer;
+    VkDeviceMemory stagingBufferMemory;
+    createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+
+    void* data;
+    vkMapMemory(device, stagingBufferMemory, 0, imageSize, 0, &data);
+        memcpy(data, pixels, static_cast<size_t>(imageSize));
+    vkUnmapMemory(device, stagingBufferMemory);
+
+    MaterialTexture texture{};
+    VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+    recordTextureUpload(commandBuffer, stagingBuffer, width, height, VK_FORMAT_R8G8B8A8_SRGB, texture);
+    endSingleTimeCommands(commandBuffer);
+
+    deletionQueue.retireBuffer(nextFrameNumber(), stagingBuffer);
+    deletionQueue.retireMemory(nextFrameNumber(), stagingBufferMemory);
+
+    activateTexture(texture);
+    return texture;
+}
+
+void Engine::recordTextureUpload(VkCommandBuffer commandBuffer, VkBuffer stagingBuffer, uint32_t width, uint32_t height, VkFormat format, MaterialTexture& texture) {
+    uint32_t mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
+    bool compressed = format != VK_FORMAT_R8G8B8A8_SRGB;
+    // Compressed images can't be blit destinations; their mips come precomputed
+    VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    if (!compressed) {
+        usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    }
+    createImage(width, height, mipLevels, VK_SAMPLE_COUNT_1_BIT, format, VK_IMAGE_TILING_OPTIMAL, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, texture.image, texture.memory);
+
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = texture.image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.levelCount = mipLevels;
+    barrier.subresourceRange.layerCount = 1;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    if (compressed) {
+        std::vector<VkBufferImageCopy> regions(mipLevels);
+        VkDeviceSize offset = 0;
+        for (uint32_t level = 0; level < mipLevels; level++) {
+            uint32_t levelWidth = std::max(1u, width >> level);
+            uint32_t levelHeight = std::max(1u, height >> level);
+            regions[level].bufferOffset = offset;
+            regions[level].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            regions[level].imageSubresource.mipLevel = level;
+            regions[level].imageSubresource.layerCount = 1;
+            regions[level].imageExtent = {levelWidth, levelHeight, 1};
+            offset += compressedLevelSize(config.textureFormat, levelWidth, levelHeight);
+        }
+        vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, texture.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevels, regions.data());
+
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    } else {
+        VkBufferImageCopy region{};
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.layerCount = 1;
+        region.imageExtent = {width, height, 1};
+        vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, texture.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+        // Leaves every level in SHADER_READ_ONLY_OPTIMAL
+        recordMipmaps(commandBuffer, texture.image, format, static_cast<int32_t>(width), static_cast<int32_t>(height), mipLevels);
+    }
+
+    texture.view = createImageView(texture.image, format, VK_IMAGE_ASPECT_COLOR_BIT, mipLevels);
+}
+
+void Engine::activateTexture(MaterialTexture& texture) {
+    // Draws still sampling the placeholder don't read the new slot or set, so
+    // writing them can't disturb frames in flight
+    if (bindlessTextures) {
+        texture.bindlessSlot = bindlessTextures->registerTexture(texture.view);
+    } else if (texture.descriptorSet != VK_NULL_HANDLE) {
+        writeMaterialDescriptorSet(texture);
+    }
+    texture.ready = true;
+}
+
+void Engine::createTextureSampler() {
+    IMPGINE_TRACE_FUNCTION();
+
+    VkSamplerCreateInfo samplerInfo{};
     samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
     samplerInfo.magFilter = VK_FILTER_LINEAR;
     samplerInfo.minFilter = VK_FILTER_LINEAR;
@@ -934,7 +1858,8 @@ void Engine::createTextureSampler() {
     samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
     samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
     samplerInfo.minLod = 0.0f;
-    samplerInfo.maxLod = static_cast<float>(mipLevels);
+    // Shared by every texture, whatever its mip count
+    samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
     samplerInfo.mipLodBias = 0.0f;
 
     if (vkCreateSampler(device, &samplerInfo, nullptr, &textureSampler) != VK_SUCCESS) {
@@ -969,38 +1894,91 @@ bool Engine::hasStencilComponent(VkFormat format) {
     return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
 }
 
-VkSampleCountFlagBits Engine::getMaxUsableSampleCount() {
+VkSampleCountFlags Engine::getUsableSampleCounts() {
     VkPhysicalDeviceProperties physicalDeviceProperties;
     vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
 
-    VkSampleCountFlags counts = physicalDeviceProperties.limits.framebufferColorSampleCounts & physicalDeviceProperties.limits.framebufferDepthSampleCounts;
-    if (counts & VK_SAMPLE_COUNT_64_BIT) { return VK_SAMPLE_COUNT_64_BIT; }
-    if (counts & VK_SAMPLE_COUNT_32_BIT) { return VK_SAMPLE_COUNT_32_BIT; }
-    if (counts & VK_SAMPLE_COUNT_16_BIT) { return VK_SAMPLE_COUNT_16_BIT; }
-    if (counts & VK_SAMPLE_COUNT_8_BIT) { return VK_SAMPLE_COUNT_8_BIT; }
-    if (counts & VK_SAMPLE_COUNT_4_BIT) { return VK_SAMPLE_COUNT_4_BIT; }
-    if (counts & VK_SAMPLE_COUNT_2_BIT) { return VK_SAMPLE_COUNT_2_BIT; }
+    return physicalDeviceProperties.limits.framebufferColorSampleCounts & physicalDeviceProperties.limits.framebufferDepthSampleCounts;
+}
 
+VkSampleCountFlagBits Engine::supportedSampleCount(uint32_t requested) const {
+    // Highest usable count not above the request; one sample is always supported
+    for (uint32_t samples = VK_SAMPLE_COUNT_64_BIT; samples > VK_SAMPLE_COUNT_1_BIT; samples >>= 1) {
+        if (samples <= requested && (usableSampleCounts & samples)) {
+            return static_cast<VkSampleCountFlagBits>(samples);
+        }
+    }
     return VK_SAMPLE_COUNT_1_BIT;
 }
 
+VkSampleCountFlagBits Engine::selectSampleCount(uint32_t requested) {
+    if (requested != 0) {
+        adaptiveMsaa.reset();
+        return supportedSampleCount(requested);
+    }
+    if (!adaptiveMsaa) {
+        adaptiveMsaa = std::make_unique<AdaptiveMsaa>(defaultGpuBudgetMs(), supportedSampleCount(VK_SAMPLE_COUNT_64_BIT));
+    }
+    return supportedSampleCount(adaptiveMsaa->getSamples());
+}
+
+bool Engine::useFxaa() const {
+    // The filtered image reaches the output through a blit
+    return config.fxaa && msaaSamples == VK_SAMPLE_COUNT_1_BIT && (offscreenTarget || swapChain->supportsTransferDst());
+}
+
+void Engine::changeSampleCount(VkSampleCountFlagBits samples) {
+    IMPGINE_TRACE_FUNCTION();
+
+    // Frames in flight still use the old objects, so they retire like on a swap chain recreation
+    uint64_t retireFrame = nextFrameNumber();
+    retireSwapChainResources(retireFrame);
+    retirePipelines(retireFrame);
+    deletionQueue.retireRenderPass(retireFrame, renderPass);
+
+    msaaSamples = samples;
+    createRenderPass();
+    createGraphicsPipeline();
+    createColorResources();
+    createDepthResources();
+    createUpscaler();
+    createFxaaPass();
+    createFramebuffers();
+}
+
 void Engine::createColorResources() {
-    VkFormat colorFormat = swapChain->getSwapChainImageFormat();
+    IMPGINE_TRACE_FUNCTION();
+
+    // Without MSAA the pass renders straight into its output
+    if (msaaSamples == VK_SAMPLE_COUNT_1_BIT) {
+        colorImage = VK_NULL_HANDLE;
+        colorImageMemory = VK_NULL_HANDLE;
+        colorImageView = VK_NULL_HANDLE;
+        return;
+    }
+
+    VkFormat colorFormat = getTargetImageFormat();
 
-    createImage(swapChain->getSwapChainExtent().width, swapChain->getSwapChainExtent().height, 1, msaaSamples, colorFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, colorImage, colorImageMemory);
+    VkExtent2D extent = getRenderTargetExtent();
+    createImage(extent.width, extent.height, 1, msaaSamples, colorFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, colorImage, colorImageMemory);
     colorImageView = createImageView(colorImage, colorFormat, VK_IMAGE_ASPECT_COLOR_BIT, 1);
 }
 
 void Engine::createDepthResources() {
+    IMPGINE_TRACE_FUNCTION();
+
     VkFormat depthFormat = findDepthFormat();
     
-    createImage(swapChain->getSwapChainExtent().width, swapChain->getSwapChainExtent().height, 1, msaaSamples, depthFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, depthImage, depthImageMemory);
+    VkExtent2D extent = getRenderTargetExtent();
+    createImage(extent.width, extent.height, 1, msaaSamples, depthFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, depthImage, depthImageMemory);
     depthImageView = createImageView(depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, 1);
 }
 
 void Engine::createRenderPass() {
+    IMPGINE_TRACE_FUNCTION();
+
     VkAttachmentDescription colorAttachment{};
-    colorAttachment.format = swapChain->getSwapChainImageFormat();
+    colorAttachment.format = getTargetImageFormat();
     colorAttachment.samples = msaaSamples;
     colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
     colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
@@ -1009,6 +1987,20 @@ void Engine::createRenderPass() {
     colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
     colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
+    // The upscale and FXAA passes sample the pass's output instead of presenting it
+    bool resolve = msaaSamples != VK_SAMPLE_COUNT_1_BIT;
+    bool sampled = dynamicResolution || useFxaa();
+    VkImageLayout outputLayout;
+    if (sampled) {
+        outputLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    } else {
+        // Offscreen images are read back with a transfer instead of presented
+        outputLayout = offscreenTarget ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    }
+    if (!resolve) {
+        colorAttachment.finalLayout = outputLayout;
+    }
+
     VkAttachmentDescription depthAttachment{};
     depthAttachment.format = findDepthFormat();
     depthAttachment.samples = msaaSamples;
@@ -1020,14 +2012,14 @@ void Engine::createRenderPass() {
     depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
     VkAttachmentDescription colorAttachmentResolve{};
-    colorAttachmentResolve.format = swapChain->getSwapChainImageFormat();
+    colorAttachmentResolve.format = getTargetImageFormat();
     colorAttachmentResolve.samples = VK_SAMPLE_COUNT_1_BIT;
     colorAttachmentResolve.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     colorAttachmentResolve.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
     colorAttachmentResolve.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     colorAttachmentResolve.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     colorAttachmentResolve.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachmentResolve.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    colorAttachmentResolve.finalLayout = outputLayout;
 
     VkAttachmentReference colorAttachmentRef{};
     colorAttachmentRef.attachment = 0;
@@ -1046,7 +2038,7 @@ void Engine::createRenderPass() {
     subpass.colorAttachmentCount = 1;
     subpass.pColorAttachments = &colorAttachmentRef;
     subpass.pDepthStencilAttachment = &depthAttachmentRef;
-    subpass.pResolveAttachments = &colorAttachmentResolveRef;
+    subpass.pResolveAttachments = resolve ? &colorAttachmentResolveRef : nullptr;
 
     VkSubpassDependency dependency{};
     dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
@@ -1056,39 +2048,112 @@ void Engine::createRenderPass() {
     dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
     dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 
+    VkSubpassDependency sampledDependency{};
+    sampledDependency.srcSubpass = 0;
+    sampledDependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+    sampledDependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    sampledDependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    sampledDependency.dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    sampledDependency.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
     std::array<VkAttachmentDescription, 3> attachments = {colorAttachment, depthAttachment, colorAttachmentResolve};
+    std::array<VkSubpassDependency, 2> dependencies = {dependency, sampledDependency};
 
     VkRenderPassCreateInfo renderPassInfo{};
     renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-    renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+    renderPassInfo.attachmentCount = resolve ? 3 : 2;
     renderPassInfo.pAttachments = attachments.data();
     renderPassInfo.subpassCount = 1;
     renderPassInfo.pSubpasses = &subpass;
-    renderPassInfo.dependencyCount = 1;
-    renderPassInfo.pDependencies = &dependency;
+    renderPassInfo.dependencyCount = sampled ? 2 : 1;
+    renderPassInfo.pDependencies = dependencies.data();
 
     if (vkCreateRenderPass(device, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
         throw std::runtime_error("failed to create render pass!");
     }
 }
 
+VkFormat Engine::getTargetImageFormat() const {
+    return offscreenTarget ? offscreenTarget->getImageFormat() : swapChain->getSwapChainImageFormat();
+}
+
+VkExtent2D Engine::getTargetExtent() const {
+    return offscreenTarget ? offscreenTarget->getExtent() : swapChain->getSwapChainExtent();
+}
+
+size_t Engine::getTargetImageCount() const {
+    return offscreenTarget ? offscreenTarget->imageCount() : swapChain->imageCount();
+}
+
+VkImageView Engine::getTargetImageView(size_t index) const {
+    return offscreenTarget ? offscreenTarget->getImageView(index) : swapChain->getImageView(index);
+}
+
+VkImage Engine::getTargetImage(size_t index) const {
+    return offscreenTarget ? offscreenTarget->getImage(index) : swapChain->getImage(index);
+}
+
+VkExtent2D Engine::getRenderTargetExtent() const {
+    return dynamicResolution ? dynamicResolution->getMaxRenderExtent(getTargetExtent()) : getTargetExtent();
+}
+
+VkExtent2D Engine::getRenderExtent() const {
+    return dynamicResolution ? dynamicResolution->getRenderExtent(getTargetExtent()) : getTargetExtent();
+}
+
+void Engine::createUpscaler() {
+    if (!dynamicResolution) {
+        return;
+    }
+
+    std::vector<VkImageView> outputViews(getTargetImageCount());
+    for (size_t i = 0; i < outputViews.size(); i++) {
+        outputViews[i] = getTargetImageView(i);
+    }
+    VkImageLayout outputLayout = offscreenTarget ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    upscaler = std::make_unique<Upscaler>(device, physicalDevice, getTargetImageFormat(), getRenderTargetExtent(), getTargetExtent(), outputViews, outputLayout);
+}
+
+void Engine::createFxaaPass() {
+    if (!useFxaa()) {
+        return;
+    }
+
+    std::vector<VkImage> outputImages(getTargetImageCount());
+    for (size_t i = 0; i < outputImages.size(); i++) {
+        outputImages[i] = getTargetImage(i);
+    }
+    VkImageLayout outputLayout = offscreenTarget ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    fxaaPass = std::make_unique<FxaaPass>(device, physicalDevice, getTargetImageFormat(), getTargetExtent(), outputImages, outputLayout);
+}
+
 void Engine::createFramebuffers() {
-    swapChainFramebuffers.resize(swapChain->imageCount());
+    IMPGINE_TRACE_FUNCTION();
+
+    swapChainFramebuffers.resize(getTargetImageCount());
 
-    for (size_t i = 0; i < swapChain->imageCount(); i++) {
-        std::array<VkImageView, 3> attachments = {
-            colorImageView,
-            depthImageView,
-            swapChain->getImageView(i)
-        };
+    for (size_t i = 0; i < getTargetImageCount(); i++) {
+        // With dynamic resolution or FXAA every frame writes the same intermediate image
+        VkImageView output = getTargetImageView(i);
+        if (upscaler) {
+            output = upscaler->getSourceImageView();
+        } else if (fxaaPass) {
+            output = fxaaPass->getSourceImageView();
+        }
+
+        // Single-sample passes have no resolve attachment and render to the output directly
+        std::array<VkImageView, 3> attachments = {colorImageView, depthImageView, output};
+        if (msaaSamples == VK_SAMPLE_COUNT_1_BIT) {
+            attachments = {output, depthImageView, VK_NULL_HANDLE};
+        }
 
         VkFramebufferCreateInfo framebufferInfo{};
         framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
         framebufferInfo.renderPass = renderPass;
-        framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+        framebufferInfo.attachmentCount = msaaSamples == VK_SAMPLE_COUNT_1_BIT ? 2 : 3;
         framebufferInfo.pAttachments = attachments.data();
-        framebufferInfo.width = swapChain->getSwapChainExtent().width;
-        framebufferInfo.height = swapChain->getSwapChainExtent().height;
+        framebufferInfo.width = getRenderTargetExtent().width;
+        framebufferInfo.height = getRenderTargetExtent().height;
         framebufferInfo.layers = 1;
 
         if (vkCreateFramebuffer(device, &framebufferInfo, nullptr, &swapChainFramebuffers[i]) != VK_SUCCESS) {
@@ -1098,6 +2163,14 @@ void Engine::createFramebuffers() {
 }
 
 void Engine::generateMipmaps(VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels) {
+    IMPGINE_TRACE_FUNCTION();
+
+    VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+    recordMipmaps(commandBuffer, image, imageFormat, texWidth, texHeight, mipLevels);
+    endSingleTimeCommands(commandBuffer);
+}
+
+void Engine::recordMipmaps(VkCommandBuffer commandBuffer, VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels) {
     // Vérifions si l'image supporte le filtrage linéaire
     VkFormatProperties formatProperties;
     vkGetPhysicalDeviceFormatProperties(physicalDevice, imageFormat, &formatProperties);
@@ -1106,8 +2179,6 @@ void Engine::generateMipmaps(VkImage image, VkFormat imageFormat, int32_t texWid
         throw std::runtime_error("le format de l'image texture ne supporte pas le filtrage lineaire!");
     }
 
-    VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
     VkImageMemoryBarrier barrier{};
     barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
     barrier.image = image;
@@ -1180,34 +2251,27 @@ void Engine::generateMipmaps(VkImage image, VkFormat imageFormat, int32_t texWid
         0, nullptr,
         0, nullptr,
         1, &barrier);
-
-    endSingleTimeCommands(commandBuffer);
 }
 
-void Engine::updateUniformBuffer(uint32_t currentImage) {
-    static auto startTime = std::chrono::high_resolution_clock::now();
-
-    auto currentTime = std::chrono::high_resolution_clock::now();
-    float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
-
-    // Set up projection matrix (only needs to be set once unless aspect ratio changes)
-    camera.setPerspectiveProjection(glm::radians(45.0f), swapChain->getSwapChainExtent().width / (float) swapChain->getSwapChainExtent().height, 0.1f, 100.0f);
-    
-    // Update view matrix based on current camera state
-    camera.updateViewMatrix();
+void Engine::updateUniformBuffer(uint32_t frameIndex, const FrameSnapshot& snapshot) {
+    IMPGINE_TRACE_FUNCTION();
 
     UniformBufferObject ubo{};
-    ubo.model = glm::rotate(glm::mat4(1.0f), 1 * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-    ubo.view = camera.getView();
-    ubo.proj = camera.getProjection();
+    ubo.view = snapshot.view;
+    ubo.proj = snapshot.proj;
 
     void* data;
-    vkMapMemory(device, uniformBuffersMemory[currentImage], 0, sizeof(ubo), 0, &data);
+    vkMapMemory(device, uniformBuffersMemory[frameIndex], 0, sizeof(ubo), 0, &data);
         memcpy(data, &ubo, sizeof(ubo));
-    vkUnmapMemory(device, uniformBuffersMemory[currentImage]);
+    vkUnmapMemory(device, uniformBuffersMemory[frameIndex]);
+
+    lightCulling->update(frameIndex, snapshot.view, snapshot.proj, getRenderExtent(), snapshot.lights);
+    shadowMaps->update(frameIndex, snapshot.view, snapshot.proj, snapshot.sun, config.shadows);
 }
 
 void Engine::createCommandBuffers() {
+    IMPGINE_TRACE_FUNCTION();
+
     commandBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
 
     VkCommandBufferAllocateInfo allocInfo{};
@@ -1221,7 +2285,9 @@ void Engine::createCommandBuffers() {
     }
 }
 
-void Engine::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex) {
+void Engine::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex, const FrameSnapshot& snapshot) {
+    IMPGINE_TRACE_FUNCTION();
+
     VkCommandBufferBeginInfo beginInfo{};
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 
@@ -1229,28 +2295,54 @@ void Engine::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIn
         throw std::runtime_error("failed to begin recording command buffer!");
     }
 
-    // Add memory barrier to ensure previous frame is complete
-    VkMemoryBarrier memoryBarrier{};
-    memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
-    memoryBarrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
-    memoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
-    
-    vkCmdPipelineBarrier(
-        commandBuffer,
-        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-        0,
-        1, &memoryBarrier,
-        0, nullptr,
-        0, nullptr
-    );
+    // Null unless profiling; the scopes below are then no-ops
+    GpuProfiler* profiler = gpuProfiler.get();
+    if (profiler) {
+        profiler->beginFrame(commandBuffer, currentFrame);
+    }
+
+    {
+        GpuProfiler::Scope barrierScope(profiler, commandBuffer, "barrier");
+
+        // Add memory barrier to ensure previous frame is complete
+        VkMemoryBarrier memoryBarrier{};
+        memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        memoryBarrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+        memoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+        
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            0,
+            1, &memoryBarrier,
+            0, nullptr,
+            0, nullptr
+        );
+    }
+
+    {
+        GpuProfiler::Scope shadowScope(profiler, commandBuffer, "shadows");
+        shadowMaps->record(commandBuffer, currentFrame, snapshot.drawList, positionBuffer, indexBuffer, profiler);
+    }
+    {
+        GpuProfiler::Scope cullScope(profiler, commandBuffer, "light culling");
+        lightCulling->record(commandBuffer, currentFrame);
+    }
 
     VkRenderPassBeginInfo renderPassInfo{};
     renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
     renderPassInfo.renderPass = renderPass;
     renderPassInfo.framebuffer = swapChainFramebuffers[imageIndex];
+    // Below full scale only the top-left corner of the render targets is used
+    VkExtent2D renderExtent = getRenderExtent();
+
+    bool prepass = config.depthPrepass == DepthPrepassMode::On ||
+        (config.depthPrepass == DepthPrepassMode::Auto && overdrawMonitor->nextFrameUsesPrepass());
+    overdrawSamples[currentFrame].prepass = prepass;
+    overdrawSamples[currentFrame].pixels = static_cast<uint64_t>(renderExtent.width) * renderExtent.height;
     renderPassInfo.renderArea.offset = {0, 0};
-    renderPassInfo.renderArea.extent = swapChain->getSwapChainExtent();
+    renderPassInfo.renderArea.extent = renderExtent;
 
     std::array<VkClearValue, 3> clearValues{};
     clearValues[0].color = {{0.01f, 0.01f, 0.01f, 1.0f}};  // Color attachment (MSAA)
@@ -1259,66 +2351,185 @@ void Engine::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIn
     renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
     renderPassInfo.pClearValues = clearValues.data();
 
-    vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+    // Statistics queries may not straddle a render pass boundary, so they wrap the whole pass
+    if (profiler) {
+        profiler->beginPipelineStatistics(commandBuffer);
+    }
 
-    VkViewport viewport{};
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
-    viewport.width = static_cast<float>(swapChain->getSwapChainExtent().width);
-    viewport.height = static_cast<float>(swapChain->getSwapChainExtent().height);
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+    {
+        GpuProfiler::Scope passScope(profiler, commandBuffer, "main pass");
 
-    VkRect2D scissor{};
-    scissor.offset = {0, 0};
-    scissor.extent = swapChain->getSwapChainExtent();
-    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 
-    pipeline->bind(commandBuffer);
-    
-    VkBuffer vertexBuffers[] = {vertexBuffer};
-    VkDeviceSize offsets[] = {0};
-    vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
-    
-    vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
-    
-    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSets[imageIndex], 0, nullptr);
-    
-    vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(indices.size()), 1, 0, 0, 0);
+        VkViewport viewport{};
+        viewport.x = 0.0f;
+        viewport.y = 0.0f;
+        viewport.width = static_cast<float>(renderExtent.width);
+        viewport.height = static_cast<float>(renderExtent.height);
+        viewport.minDepth = 0.0f;
+        viewport.maxDepth = 1.0f;
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+        VkRect2D scissor{};
+        scissor.offset = {0, 0};
+        scissor.extent = renderExtent;
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+        vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+        
+        std::array<VkDescriptorSet, 3> sets = {descriptorSets[currentFrame], lightCulling->getDescriptorSet(currentFrame), shadowMaps->getDescriptorSet(currentFrame)};
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, static_cast<uint32_t>(sets.size()), sets.data(), 0, nullptr);
+        // Bindless: one set holds every texture, however many the scene uses
+        if (bindlessTextures) {
+            VkDescriptorSet textureSet = bindlessTextures->getDescriptorSet();
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 3, 1, &textureSet, 0, nullptr);
+        }
+
+        // All pipelines share the layout, so the descriptor set stays bound across them
+        if (prepass) {
+            GpuProfiler::Scope prepassScope(profiler, commandBuffer, "depth prepass");
 
-    vkCmdEndRenderPass(commandBuffer);
+            depthPrepassPipeline->bind(commandBuffer);
+            VkBuffer positionBuffers[] = {positionBuffer};
+            VkDeviceSize positionOffsets[] = {0};
+            vkCmdBindVertexBuffers(commandBuffer, 0, 1, positionBuffers, positionOffsets);
+
+            for (const auto& item : snapshot.drawList) {
+                PushConstantData push{};
+                push.model = item.model;
+                push.objectIndex = item.objectIndex;
+                push.materialIndex = item.materialIndex;
+                vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PushConstantData), &push);
+
+                vkCmdDrawIndexed(commandBuffer, item.indexCount, 1, item.firstIndex, item.vertexOffset, 0);
+            }
+        }
+
+        if (prepass) {
+            equalDepthPipeline->bind(commandBuffer);
+        } else {
+            pipeline->bind(commandBuffer);
+        }
+        
+        VkBuffer vertexBuffers[] = {vertexBuffer};
+        VkDeviceSize offsets[] = {0};
+        vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+        
+        // Each draw only pushes its own constants; without bindless textures the
+        // draw list is grouped by texture, so the material set changes once per texture
+        VkDescriptorSet boundTextureSet = VK_NULL_HANDLE;
+        for (const auto& item : snapshot.drawList) {
+            GpuProfiler::Scope drawScope(profiler, commandBuffer, "draw");
+
+            const MaterialTexture& materialTexture = materialTextures[materialTextureIndices[item.materialIndex]];
+            const MaterialTexture& texture = materialTexture.ready ? materialTexture : placeholderTexture;
+            if (!bindlessTextures && texture.descriptorSet != boundTextureSet) {
+                vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 3, 1, &texture.descriptorSet, 0, nullptr);
+                boundTextureSet = texture.descriptorSet;
+            }
+
+            PushConstantData push{};
+            push.model = item.model;
+            push.objectIndex = item.objectIndex;
+            push.materialIndex = item.materialIndex;
+            push.textureIndex = texture.bindlessSlot;
+            push.baseColor = glm::vec4(materials[item.materialIndex].diffuseColor, 1.0f);
+            vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PushConstantData), &push);
+
+            vkCmdDrawIndexed(commandBuffer, item.indexCount, 1, item.firstIndex, item.vertexOffset, 0);
+        }
+
+        vkCmdEndRenderPass(commandBuffer);
+    }
+
+    if (profiler) {
+        profiler->endPipelineStatistics(commandBuffer);
+    }
+
+    if (upscaler) {
+        GpuProfiler::Scope upscaleScope(profiler, commandBuffer, "upscale");
+        upscaler->record(commandBuffer, imageIndex, renderExtent);
+    }
+    if (fxaaPass) {
+        GpuProfiler::Scope fxaaScope(profiler, commandBuffer, "fxaa");
+        fxaaPass->record(commandBuffer, imageIndex);
+    }
+
+    if (profiler) {
+        profiler->endFrame(commandBuffer);
+    }
+
+    // Outside the GPU frame scope so hashing doesn't count towards GPU time
+    if (frameHashFile.is_open()) {
+        offscreenTarget->recordReadback(commandBuffer, imageIndex);
+        readbackFrames[imageIndex] = snapshot.sequence;
+    }
 
     if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
         throw std::runtime_error("failed to record command buffer!");
     }
 }
 
-void Engine::drawFrame() {
-    // Wait for the previous frame to finish
-    VkFence inFlightFence = swapChain->getInFlightFence(currentFrame);
-    vkWaitForFences(device, 1, &inFlightFence, VK_TRUE, UINT64_MAX);
+void Engine::drawFrame(const FrameSnapshot& snapshot) {
+    IMPGINE_TRACE_FUNCTION();
+    auto frameStart = StallTracker::Clock::now();
 
-    uint32_t imageIndex;
-    // Use frame-based semaphore for acquire
-    VkSemaphore imageAvailableSemaphore = swapChain->getImageAvailableSemaphore(currentFrame);
-    auto result = swapChain->acquireNextImage(&imageIndex, currentFrame, imageAvailableSemaphore);
+    // Wait for the previous frame to finish
+    VkFence inFlightFence = offscreenTarget ? offscreenTarget->getInFlightFence(currentFrame) : swapChain->getInFlightFence(currentFrame);
+    {
+        IMPGINE_TRACE_SCOPE("vkWaitForFences");
+        StallTracker::Scope stall(stallTracker.get(), StallCategory::FramePacing, "vkWaitForFences");
+        vkWaitForFences(device, 1, &inFlightFence, VK_TRUE, UINT64_MAX);
+    }
+    latencyTracker.markGpuComplete(currentFrame);
+
+    // Frames complete in submission order, so everything up to this slot's frame is done
+    completedFrames = std::max(completedFrames, frameSlotNumbers[currentFrame]);
+    deletionQueue.collect(completedFrames);
+    collectFrameTiming(currentFrame);
+    collectFrameHash(currentFrame);
+    auto cpuStart = FrameLatencyTracker::Clock::now();
+
+    // Requested or automatic sample count changes rebuild everything that depends on it
+    VkSampleCountFlagBits samples = selectSampleCount(snapshot.msaaSamples);
+    if (adaptiveMsaa && !gpuProfiler) {
+        createGpuProfiler();
+    }
+    if (samples != msaaSamples) {
+        changeSampleCount(samples);
+    }
+    uploadDecodedTextures(false);
+
+    // Offscreen targets have one image per frame slot and nothing to acquire
+    uint32_t imageIndex = currentFrame;
+    VkSemaphore imageAvailableSemaphore = VK_NULL_HANDLE;
+    if (swapChain) {
+        // Use frame-based semaphore for acquire
+        imageAvailableSemaphore = swapChain->getImageAvailableSemaphore(currentFrame);
+        VkResult result;
+        {
+            IMPGINE_TRACE_SCOPE("acquireNextImage");
+            StallTracker::Scope stall(stallTracker.get(), StallCategory::Acquire, "acquireNextImage");
+            result = swapChain->acquireNextImage(&imageIndex, currentFrame, imageAvailableSemaphore);
+        }
 
-    if (result == VK_ERROR_OUT_OF_DATE_KHR) {
-        recreateSwapChain();
-        return;
-    } else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
-        throw std::runtime_error("failed to acquire swap chain image!");
+        if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+            recreateSwapChain();
+            return;
+        } else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+            throw std::runtime_error("failed to acquire swap chain image!");
+        }
     }
 
     // Only reset the fence if we are submitting work
     vkResetFences(device, 1, &inFlightFence);
+    latencyTracker.beginFrame(currentFrame, snapshot.inputSampleTime);
 
-    updateUniformBuffer(imageIndex);
+    updateUniformBuffer(currentFrame, snapshot);
 
     // Reset and record command buffer
     vkResetCommandBuffer(commandBuffers[currentFrame], 0);
-    recordCommandBuffer(commandBuffers[currentFrame], imageIndex);
+    recordCommandBuffer(commandBuffers[currentFrame], imageIndex, snapshot);
 
     // Submit command buffer
     VkSubmitInfo submitInfo{};
@@ -1326,76 +2537,264 @@ void Engine::drawFrame() {
 
     VkSemaphore waitSemaphores[] = {imageAvailableSemaphore};
     VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-    submitInfo.waitSemaphoreCount = 1;
+    submitInfo.waitSemaphoreCount = swapChain ? 1 : 0;
     submitInfo.pWaitSemaphores = waitSemaphores;
     submitInfo.pWaitDstStageMask = waitStages;
 
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = &commandBuffers[currentFrame];
 
-    VkSemaphore signalSemaphores[] = {swapChain->getRenderFinishedSemaphore(imageIndex)};
-    submitInfo.signalSemaphoreCount = 1;
+    VkSemaphore signalSemaphores[] = {swapChain ? swapChain->getRenderFinishedSemaphore(imageIndex) : VK_NULL_HANDLE};
+    submitInfo.signalSemaphoreCount = swapChain ? 1 : 0;
     submitInfo.pSignalSemaphores = signalSemaphores;
 
-    if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, inFlightFence) != VK_SUCCESS) {
-        throw std::runtime_error("failed to submit draw command buffer!");
+    {
+        IMPGINE_TRACE_SCOPE("vkQueueSubmit");
+        if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, inFlightFence) != VK_SUCCESS) {
+            throw std::runtime_error("failed to submit draw command buffer!");
+        }
+    }
+    frameSlotNumbers[currentFrame] = ++submittedFrames;
+    latencyTracker.markSubmitted(currentFrame);
+
+    // Only frames that were actually submitted, so a replay draws exactly the live session
+    if (captureWriter) {
+        captureWriter->writeFrame(snapshot);
+    }
+
+    PendingFrameTiming& pending = pendingFrameTimings[currentFrame];
+    pending.measured = isBenchmarking() && snapshot.sequence > config.warmupFrames;
+    pending.timing.frame = snapshot.sequence - config.warmupFrames;
+    pending.timing.cpuMs = std::chrono::duration<double, std::milli>(FrameLatencyTracker::Clock::now() - cpuStart).count();
+
+    if (!swapChain) {
+        // Headless: the frame is done once submitted
+        latencyTracker.markPresented(currentFrame);
+        markPresentTime(currentFrame);
+        if (stallTracker) {
+            stallTracker->endFrame(StallTracker::Clock::now() - frameStart);
+        }
+        currentFrame = (currentFrame + 1) % SwapChain::MAX_FRAMES_IN_FLIGHT;
+        return;
     }
 
     // Present frame
-    result = swapChain->presentFrame(presentQueue, &imageIndex, currentFrame);
-    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || framebufferResized) {
-        framebufferResized = false;
+    VkResult result;
+    {
+        IMPGINE_TRACE_SCOPE("presentFrame");
+        StallTracker::Scope stall(stallTracker.get(), StallCategory::Present, "presentFrame");
+        result = swapChain->presentFrame(presentQueue, &imageIndex, currentFrame);
+    }
+    latencyTracker.markPresented(currentFrame);
+    markPresentTime(currentFrame);
+    bool resized = framebufferResized.exchange(false);
+    bool presentModeChanged = snapshot.presentMode != swapChainPresentMode;
+    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || resized || presentModeChanged) {
+        swapChainPresentMode = snapshot.presentMode;
         recreateSwapChain();
     } else if (result != VK_SUCCESS) {
         throw std::runtime_error("failed to present swap chain image!");
     }
 
+    if (stallTracker) {
+        stallTracker->endFrame(StallTracker::Clock::now() - frameStart);
+    }
     currentFrame = (currentFrame + 1) % SwapChain::MAX_FRAMES_IN_FLIGHT;
 }
 
 void Engine::recreateSwapChain() {
-    int width = 0, height = 0;
-    window->getFramebufferSize(&width, &height);
-    while (width == 0 || height == 0) {
-        window->getFramebufferSize(&width, &height);
-        window->waitEvents();
+    IMPGINE_TRACE_FUNCTION();
+
+    // A zero-sized swap chain is invalid; keep the request pending until the
+    // window is restored (the main loop blocks on events meanwhile). Asks the
+    // surface rather than GLFW, which may only be called from the main thread
+    VkSurfaceCapabilitiesKHR capabilities;
+    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, surface, &capabilities);
+    if (capabilities.currentExtent.width == 0 || capabilities.currentExtent.height == 0) {
+        framebufferResized = true;
+        return;
     }
 
-    vkDeviceWaitIdle(device);
+    // Frames already submitted may still use the old objects, so they are retired
+    // once the first frame on the new swap chain completes instead of idling the device
+    uint64_t retireFrame = submittedFrames + 1;
 
-    // Clean up old uniform buffers and descriptor pool
-    for (size_t i = 0; i < uniformBuffers.size(); i++) {
-        vkDestroyBuffer(device, uniformBuffers[i], nullptr);
-        vkFreeMemory(device, uniformBuffersMemory[i], nullptr);
-    }
-    
-    vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+    std::shared_ptr<SwapChain> oldSwapChain = std::move(swapChain);
+    swapChain = std::make_unique<SwapChain>(device, physicalDevice, surface, *window, swapChainPresentMode, oldSwapChain.get());
 
-    cleanupSwapChain();
+    retireSwapChainResources(retireFrame);
+
+    // The render pass and pipeline only depend on formats; viewport and scissor are dynamic
+    if (!swapChain->compareSwapFormats(*oldSwapChain)) {
+        retirePipelines(retireFrame);
+        deletionQueue.retireRenderPass(retireFrame, renderPass);
 
-    swapChain = std::make_unique<SwapChain>(device, physicalDevice, surface, *window);
+        createRenderPass();
+        createGraphicsPipeline();
+    }
+
+    deletionQueue.push(retireFrame, [oldSwapChain]() mutable {
+        oldSwapChain.reset();
+    });
 
     createColorResources();
     createDepthResources();
-    createRenderPass();
+    createUpscaler();
+    createFxaaPass();
     createFramebuffers();
 
-    // Recreate uniform buffers and descriptor resources for new swap chain
-    createUniformBuffers();
-    createDescriptorPool();
-    createDescriptorSets();
+    // Nothing has been presented at the new size yet; an idle on-demand
+    // window would otherwise keep showing the old frame until the next input
+    requestRedraw();
+}
 
-    // Recreate pipeline since it depends on render pass
-    pipeline.reset();
+void Engine::applyCameraPath(uint64_t frameIndex) {
+    glm::vec3 position, rotation;
+    cameraPath->sample(static_cast<float>(frameIndex) * config.benchmarkTimeStep, position, rotation);
+    camera.setViewYXZ(position, rotation);
+}
 
-    PipelineConfigInfo pipelineConfig{};
-    Pipeline::defaultPipelineConfigInfo(pipelineConfig);
-    pipelineConfig.renderPass = renderPass;
-    pipelineConfig.pipelineLayout = pipelineLayout;
-    pipelineConfig.multisampleInfo.rasterizationSamples = msaaSamples;
+void Engine::createGpuProfiler() {
+    IMPGINE_TRACE_FUNCTION();
 
-    pipeline =
-        std::make_unique<Pipeline>(device, "shaders/vert.spv", "shaders/frag.spv", pipelineConfig);
+    QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
+    gpuProfiler = std::make_unique<GpuProfiler>(device, physicalDevice, indices.graphicsFamily.value(), SwapChain::MAX_FRAMES_IN_FLIGHT, pipelineStatisticsSupported);
+    if (!gpuProfiler->isSupported()) {
+        std::cerr << "GPU timestamps unsupported on the graphics queue; GPU time will not be reported" << std::endl;
+    } else if (!config.traceOutput.empty()) {
+        // GPU zones only line up with CPU zones once the clocks are related
+        StallTracker::Scope stall(stallTracker.get(), StallCategory::Upload, "calibrate");
+        gpuProfiler->calibrate(graphicsQueue, commandPool);
+    }
+    if (dynamicResolution && !gpuProfiler->isSupported()) {
+        std::cerr << "Dynamic resolution needs GPU timestamps; rendering at the maximum scale" << std::endl;
+    }
+    if (adaptiveMsaa && !gpuProfiler->isSupported()) {
+        std::cerr << "Automatic MSAA needs GPU timestamps; staying at the current sample count" << std::endl;
+    }
+}
+
+void Engine::markPresentTime(uint32_t frameIndex) {
+    auto now = FrameLatencyTracker::Clock::now();
+    PendingFrameTiming& pending = pendingFrameTimings[frameIndex];
+    pending.timing.presentIntervalMs = hasPresented ? std::chrono::duration<double, std::milli>(now - lastPresentTime).count() : -1.0;
+    lastPresentTime = now;
+    hasPresented = true;
+}
+
+void Engine::collectFrameTiming(uint32_t frameIndex) {
+    PendingFrameTiming& pending = pendingFrameTimings[frameIndex];
+    bool measured = pending.measured;
+    pending.measured = false;
+
+    // Called after the slot's fence, so the results are available without waiting.
+    // Warm-up frames are kept out of the GPU statistics too
+    const GpuProfiler::FrameResult* gpuFrame = nullptr;
+    if (gpuProfiler) {
+        gpuFrame = gpuProfiler->collect(frameIndex, measured || !isBenchmarking());
+    }
+    if (gpuFrame && dynamicResolution) {
+        dynamicResolution->update(gpuFrame->totalMs);
+    }
+    if (gpuFrame && adaptiveMsaa) {
+        adaptiveMsaa->update(gpuFrame->totalMs);
+    }
+    // The prepass has no fragment stage, so the counter only sees the shading pass
+    if (gpuFrame && gpuFrame->hasPipelineStatistics && overdrawMonitor) {
+        const OverdrawSample& sample = overdrawSamples[frameIndex];
+        overdrawMonitor->record(gpuFrame->pipelineStatistics.fragmentShaderInvocations, sample.pixels, sample.prepass);
+    }
+
+#ifdef IMPGINE_ENABLE_TRACING
+    if (gpuFrame && gpuProfiler->isCalibrated()) {
+        int64_t offset = gpuProfiler->getCpuOffsetNs();
+        Trace::recordGpuZone("GPU frame", gpuFrame->beginNs + offset, gpuFrame->endNs + offset);
+        for (const auto& scope : gpuFrame->scopes) {
+            Trace::recordGpuZone(scope.name, scope.beginNs + offset, scope.endNs + offset);
+        }
+    }
+#endif
+
+    if (!measured) {
+        return;
+    }
+    pending.timing.gpuMs = gpuFrame ? gpuFrame->totalMs : -1.0;
+    frameTimes.record(pending.timing);
+}
+
+void Engine::collectInFlightFrames() {
+    // Oldest first, so hashes come out in frame order
+    for (uint32_t i = 0; i < SwapChain::MAX_FRAMES_IN_FLIGHT; i++) {
+        uint32_t frameIndex = (currentFrame + i) % SwapChain::MAX_FRAMES_IN_FLIGHT;
+        collectFrameTiming(frameIndex);
+        collectFrameHash(frameIndex);
+    }
+}
+
+void Engine::finishBenchmark() {
+    collectInFlightFrames();
+    if (!isBenchmarking()) {
+        return;
+    }
+
+    frameTimes.report(std::cout);
+    gpuProfiler->report(std::cout);
+    if (!config.benchmarkCsv.empty()) {
+        frameTimes.writeCsv(config.benchmarkCsv);
+        std::cout << "Wrote " << config.benchmarkCsv << std::endl;
+    }
+}
+
+FrameSnapshot Engine::replaySnapshot(uint64_t frameIndex) const {
+    // Warm-up frames repeat the first captured frame; --frames past the end loops
+    uint64_t captured = frameIndex < config.warmupFrames ? 0 : frameIndex - config.warmupFrames;
+    FrameSnapshot snapshot = replayCapture->getFrame(captured % replayCapture->frameCount());
+    snapshot.sequence = frameIndex + 1;
+    snapshot.presentMode = config.presentMode;
+    snapshot.msaaSamples = config.msaaSamples;
+    snapshot.inputSampleTime = FrameLatencyTracker::Clock::now();
+    return snapshot;
+}
+
+void Engine::resizeOffscreenTarget(VkExtent2D extent) {
+    IMPGINE_TRACE_FUNCTION();
+
+    // The in-flight fences belong to the target, so unlike a swap chain it
+    // can't be retired through the deletion queue; captured resizes are rare
+    // enough that idling the device is fine
+    {
+        StallTracker::Scope stall(stallTracker.get(), StallCategory::Resize, "vkDeviceWaitIdle");
+        vkDeviceWaitIdle(device);
+    }
+    collectInFlightFrames();
+
+    completedFrames = submittedFrames;
+    retireSwapChainResources(completedFrames);
+    deletionQueue.collect(completedFrames);
+
+    offscreenTarget = std::make_unique<OffscreenTarget>(device, physicalDevice, extent, SwapChain::MAX_FRAMES_IN_FLIGHT);
+    if (frameHashFile.is_open()) {
+        offscreenTarget->enableReadback();
+    }
+    createColorResources();
+    createDepthResources();
+    createUpscaler();
+    createFxaaPass();
+    createFramebuffers();
+}
+
+void Engine::collectFrameHash(uint32_t frameIndex) {
+    uint64_t frame = readbackFrames[frameIndex];
+    if (frame == 0) {
+        return;
+    }
+    readbackFrames[frameIndex] = 0;
+
+    uint64_t hash = FrameCapture::hashBytes(offscreenTarget->getReadbackPixels(frameIndex), offscreenTarget->pixelDataSize());
+    frameHashFile << frame << ' ' << std::hex << hash << std::dec << '\n';
+    if (!frameHashFile) {
+        throw std::runtime_error("failed to write " + config.frameHashesOutput + "!");
+    }
 }
 
 void Engine::framebufferResizeCallback(GLFWwindow* window, int width, int height) {
@@ -1403,6 +2802,12 @@ void Engine::framebufferResizeCallback(GLFWwindow* window, int width, int height
     (void)height;
     auto app = reinterpret_cast<Engine*>(glfwGetWindowUserPointer(window));
     app->framebufferResized = true;
+    app->requestRedraw();
+}
+
+void Engine::windowRefreshCallback(GLFWwindow* window) {
+    auto app = reinterpret_cast<Engine*>(glfwGetWindowUserPointer(window));
+    app->requestRedraw();
 }
 
 VKAPI_ATTR VkBool32 VKAPI_CALL
@@ -1418,39 +2823,47 @@ Engine::debugCallback(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
     return VK_FALSE;
 }
 
-void Engine::processInput(float deltaTime) {
+bool Engine::processInput(float deltaTime) {
     const float moveSpeed = 5.0f; // units per second
+    bool moved = false;
     
     // WASD movement (using ZQSD for AZERTY keyboards, but we'll use WASD)
     if (window->isKeyPressed(GLFW_KEY_W)) {
         camera.moveForward(moveSpeed * deltaTime);
+        moved = true;
     }
     if (window->isKeyPressed(GLFW_KEY_S)) {
         camera.moveBackward(moveSpeed * deltaTime);
+        moved = true;
     }
     if (window->isKeyPressed(GLFW_KEY_A)) {
         camera.moveLeft(moveSpeed * deltaTime);
+        moved = true;
     }
     if (window->isKeyPressed(GLFW_KEY_D)) {
         camera.moveRight(moveSpeed * deltaTime);
+        moved = true;
     }
     
     // Space and Shift for up/down movement
     if (window->isKeyPressed(GLFW_KEY_SPACE)) {
         camera.moveUp(moveSpeed * deltaTime);
+        moved = true;
     }
     if (window->isKeyPressed(GLFW_KEY_LEFT_SHIFT)) {
         camera.moveDown(moveSpeed * deltaTime);
+        moved = true;
     }
     
     // ESC to close application
     if (window->isKeyPressed(GLFW_KEY_ESCAPE)) {
         glfwSetWindowShouldClose(window->getGLFWWindow(), GLFW_TRUE);
     }
+    return moved;
 }
 
-void Engine::handleMouseMovement() {
-    if (!mouseCaptured) return;
+bool Engine::handleMouseMovement() {
+    if (!mouseCaptured) return false;
     
     double xpos, ypos;
     window->getCursorPos(&xpos, &ypos);
@@ -1470,6 +2883,7 @@ void Engine::handleMouseMovement() {
     const float sensitivity = 0.002f; // Adjust as needed
     camera.rotateYaw(static_cast<float>(xoffset * sensitivity));
     camera.rotatePitch(static_cast<float>(yoffset * sensitivity));
+    return xoffset != 0.0 || yoffset != 0.0;
 }
 
 }  // namespace impgine
\ No newline at end of file
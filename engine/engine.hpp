@@ -12,30 +12,72 @@
 
 #include "../external/stb_image.h"
 
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <cstring>
+#include <fstream>
 #include <iostream>
 #include <memory>
 #include <optional>
 #include <set>
 #include <stdexcept>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
+#include "adaptive_msaa.hpp"
+#include "assets/mesh_cache.hpp"
+#include "assets/model_loader.hpp"
+#include "backend/bindless_textures.hpp"
 #include "backend/buffers.hpp"
+#include "backend/deletion_queue.hpp"
+#include "backend/fxaa_pass.hpp"
+#include "backend/light_culling.hpp"
+#include "backend/offscreen_target.hpp"
 #include "backend/pipeline.hpp"
+#include "backend/pipeline_layout.hpp"
+#include "backend/shadow_maps.hpp"
 #include "backend/swap_chain.hpp"
+#include "backend/upscaler.hpp"
 #include "backend/window.hpp"
+#include "benchmark/camera_path.hpp"
+#include "benchmark/frame_capture.hpp"
 #include "camera.hpp"
+#include "core/job_system.hpp"
+#include "directional_light.hpp"
+#include "dynamic_resolution.hpp"
+#include "engine_config.hpp"
+#include "frame_limiter.hpp"
+#include "frame_snapshot.hpp"
+#include "point_light.hpp"
+#include "profiling/frame_latency.hpp"
+#include "profiling/frame_time_recorder.hpp"
+#include "profiling/gpu_profiler.hpp"
+#include "profiling/overdraw_monitor.hpp"
+#include "profiling/stall_tracker.hpp"
+#include "profiling/trace.hpp"
+#include "snapshot_queue.hpp"
 
 namespace impgine {
 
+    // Per-frame data shared by every draw
     struct UniformBufferObject {
-        alignas(16) glm::mat4 model;
         alignas(16) glm::mat4 view;
         alignas(16) glm::mat4 proj;
     };
 
+    // Per-draw data, pushed with a single vkCmdPushConstants per draw
+    struct PushConstantData {
+        alignas(16) glm::mat4 model;
+        uint32_t objectIndex;
+        uint32_t materialIndex;
+        // Slot of the material's texture in the bindless array
+        uint32_t textureIndex;
+        // The material's diffuse color, multiplied with its texture
+        alignas(16) glm::vec4 baseColor;
+    };
+
     struct QueueFamilyIndices {
         std::optional < uint32_t > graphicsFamily;
         std::optional < uint32_t > presentFamily;
@@ -50,25 +92,80 @@ namespace impgine {
         static constexpr int HEIGHT = 600;
         
         static const std::string MODEL_PATH;
+        // Used by faces without a material, and in place of missing textures
         static const std::string TEXTURE_PATH;
+        static const std::string FALLBACK_TEXTURE_PATH;
+        // shader.frag compiled with -DBINDLESS; without it textures aren't bindless
+        static const std::string BINDLESS_FRAGMENT_SHADER;
 
-        Engine();
+        explicit Engine(const EngineConfig & config = EngineConfig {});
         ~Engine();
 
         // Delete copy constructor and assignment operator
         Engine(const Engine & ) = delete;
         Engine & operator = (const Engine & ) = delete;
 
+        // bench/engine_bench.cpp times the private upload, mip and recording paths
+        friend class EngineBench;
+
         void run();
 
+        // Takes effect on the next frame; falls back if the surface lacks the mode.
+        // Like everything below, call from the thread running run()
+        void setPresentMode(VkPresentModeKHR mode);
+        void setFrameRateLimit(double framesPerSecond);
+        // 0 picks the count automatically; others round down to what the device supports
+        void setMsaaSamples(uint32_t samples);
+        // With EngineConfig::onDemand, renders the next frame even if nothing the
+        // engine tracks changed (e.g. after an asset update). The setters here
+        // request one themselves. Safe to call from any thread
+        void requestRedraw();
+        // With EngineConfig::onDemand, renders every frame while true
+        void setAnimating(bool animating);
+        // Replaces the scene's point lights; at most LightCulling::MAX_LIGHTS
+        void setLights(std::vector < PointLight > lights);
+        // Shadowed only with EngineConfig::shadows; an intensity of 0 turns it off
+        void setDirectionalLight(const DirectionalLight & light);
+        const FrameLatencyTracker & getLatencyTracker() const {
+            return latencyTracker;
+        }
+
+        // Objects waiting for their last frame to retire (swapchain recreation etc.)
+        size_t getDeletionQueueDepth() const {
+            return deletionQueue.size();
+        }
+        size_t getPeakDeletionQueueDepth() const {
+            return deletionQueue.peakSize();
+        }
+
+        // Null unless GPU profiling or benchmarking is enabled
+        const GpuProfiler * getGpuProfiler() const {
+            return gpuProfiler.get();
+        }
+        // Null unless stall reporting or the stall watchdog is enabled
+        const StallTracker * getStallTracker() const {
+            return stallTracker.get();
+        }
+
         private: void initVulkan();
         void mainLoop();
+        void renderLoop();
+        void headlessLoop();
+        // Frames to render in total, warm-up included; 0 means until the window closes
+        uint64_t totalFrameCount() const;
+        FrameSnapshot captureSnapshot();
         void cleanup();
         void cleanupSwapChain();
+        void retireSwapChainResources(uint64_t retireFrame);
+
+        // Anything submitted before the next frame has completed once that frame's fence signals
+        uint64_t nextFrameNumber() const {
+            return submittedFrames + 1;
+        }
         
-        // Input handling
-        void processInput(float deltaTime);
-        void handleMouseMovement();
+        // Input handling; both return whether the camera moved
+        bool processInput(float deltaTime);
+        bool handleMouseMovement();
 
         // Vulkan initialization functions
         void createInstance();
@@ -80,13 +177,43 @@ namespace impgine {
         void createLogicalDevice();
         void createCommandPool();
         void createVertexBuffer();
+        void createPositionBuffer();
         void createIndexBuffer();
         void createUniformBuffers();
         void createDescriptorSetLayout();
         void createDescriptorPool();
         void createDescriptorSets();
-        void createTextureImage();
-        void createTextureImageView();
+        void createPipelineLayout();
+        void createGraphicsPipeline();
+        // Hands every graphics pipeline to the deletion queue
+        void retirePipelines(uint64_t retireFrame);
+        // One image per distinct diffuse texture of the model's materials. Files
+        // are decoded on workers; draws use placeholderTexture until theirs is
+        // uploaded. The MTL files' textures start before the OBJ is parsed, the
+        // rest (and the material -> texture mapping) once it is
+        void startMaterialTextures();
+        void createMaterialTextures();
+        // The texture index for a material's texture path, starting its decode the first time
+        uint32_t materialTexture(const std::string & path);
+        // The file a material's texture is loaded from: the path itself, or the fallback when it's missing
+        static std::string resolveTexturePath(const std::string & path);
+        // Everything frames depend on beyond the capture itself: the model, its
+        // MTL files and every texture the materials resolve to
+        static std::vector < std::string > sceneAssetPaths();
+        void startTextureDecode(uint32_t textureIndex, const std::string & source, uint32_t width, uint32_t height);
+        // Uploads every finished decode in one submission ahead of the next frame;
+        // with `waitForAll`, waits for the decodes still running first
+        void uploadDecodedTextures(bool waitForAll);
+        struct MaterialTexture;
+        // Synchronous upload of a small, already decoded image
+        MaterialTexture createMaterialTexture(const stbi_uc * pixels, uint32_t width, uint32_t height);
+        // RGBA8 staging gets its mips blitted on the GPU; a block-compressed
+        // format's staging holds the whole chain, packed base level first
+        void recordTextureUpload(VkCommandBuffer commandBuffer, VkBuffer stagingBuffer, uint32_t width, uint32_t height, VkFormat format, MaterialTexture & texture);
+        // Makes an uploaded texture visible to draws
+        void activateTexture(MaterialTexture & texture);
+        void writeMaterialDescriptorSet(const MaterialTexture & texture);
+        void createMaterialDescriptorSets();
         void createTextureSampler();
         void createColorResources();
         void createDepthResources();
@@ -94,8 +221,10 @@ namespace impgine {
         void createFramebuffers();
         void createCommandBuffers();
         void loadModel();
+        void buildDrawList();
         void generateMipmaps(VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels);
-        void updateUniformBuffer(uint32_t currentImage);
+        void recordMipmaps(VkCommandBuffer commandBuffer, VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels);
+        void updateUniformBuffer(uint32_t frameIndex, const FrameSnapshot & snapshot);
 
         // Helper functions
         bool isDeviceSuitable(VkPhysicalDevice device);
@@ -113,26 +242,71 @@ namespace impgine {
         VkFormat findDepthFormat();
         VkFormat findSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
         bool hasStencilComponent(VkFormat format);
-        VkSampleCountFlagBits getMaxUsableSampleCount();
+        VkSampleCountFlags getUsableSampleCounts();
+        VkSampleCountFlagBits supportedSampleCount(uint32_t requested) const;
+        // Resolves a requested count, where 0 defers to the adaptive controller
+        VkSampleCountFlagBits selectSampleCount(uint32_t requested);
+        void changeSampleCount(VkSampleCountFlagBits samples);
+        bool useFxaa() const;
+        void createFxaaPass();
+        // GPU time budget for automatic quality settings, from the frame rate limit
+        double defaultGpuBudgetMs() const;
         std::vector <
         const char * > getRequiredExtensions();
+        std::vector <
+        const char * > getRequiredDeviceExtensions();
+
+        // The swap chain or, when headless, the offscreen target
+        VkFormat getTargetImageFormat() const;
+        VkExtent2D getTargetExtent() const;
+        size_t getTargetImageCount() const;
+        VkImageView getTargetImageView(size_t index) const;
+        VkImage getTargetImage(size_t index) const;
+        // Size the color and depth targets are allocated at, and the part of them this frame renders
+        VkExtent2D getRenderTargetExtent() const;
+        VkExtent2D getRenderExtent() const;
+        void createUpscaler();
 
         // Drawing
-        void drawFrame();
-        void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+        void drawFrame(const FrameSnapshot & snapshot);
+        void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex, const FrameSnapshot & snapshot);
         void recreateSwapChain();
 
+        // Benchmark mode
+        void applyCameraPath(uint64_t frameIndex);
+        void createGpuProfiler();
+        void markPresentTime(uint32_t frameIndex);
+        void collectFrameTiming(uint32_t frameIndex);
+        // Reads back every slot still holding a frame; the device must be idle
+        void collectInFlightFrames();
+        void finishBenchmark();
+        bool isBenchmarking() const {
+            return cameraPath || replayCapture;
+        }
+
+        // Capture and replay
+        FrameSnapshot replaySnapshot(uint64_t frameIndex) const;
+        void resizeOffscreenTarget(VkExtent2D extent);
+        void collectFrameHash(uint32_t frameIndex);
+
         // Callback functions
         static void framebufferResizeCallback(GLFWwindow * window, int width, int height);
+        static void windowRefreshCallback(GLFWwindow * window);
         static VKAPI_ATTR VkBool32 VKAPI_CALL
         debugCallback(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
             VkDebugUtilsMessageTypeFlagsEXT messageType,
             const VkDebugUtilsMessengerCallbackDataEXT * pCallbackData, void * pUserData);
 
         // Member variables
+        EngineConfig config;
+        JobSystem jobs;
         std::unique_ptr < Window > window;
         std::unique_ptr < Pipeline > pipeline;
+        // Only with the depth prepass enabled
+        std::unique_ptr < Pipeline > depthPrepassPipeline;
+        std::unique_ptr < Pipeline > equalDepthPipeline;
         std::unique_ptr < SwapChain > swapChain;
+        std::unique_ptr < OffscreenTarget > offscreenTarget;
         Camera camera;
 
         // Validation layers
@@ -155,7 +329,7 @@ namespace impgine {
         // Vulkan objects
         VkInstance instance;
         VkDebugUtilsMessengerEXT debugMessenger;
-        VkSurfaceKHR surface;
+        VkSurfaceKHR surface = VK_NULL_HANDLE;
         VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
         VkDevice device;
         VkQueue graphicsQueue;
@@ -163,8 +337,11 @@ namespace impgine {
         VkCommandPool commandPool;
         std::vector<Vertex> vertices;
         std::vector<uint32_t> indices;
+        std::vector<DrawItem> drawList;
         VkBuffer vertexBuffer;
         VkDeviceMemory vertexBufferMemory;
+        VkBuffer positionBuffer = VK_NULL_HANDLE;
+        VkDeviceMemory positionBufferMemory = VK_NULL_HANDLE;
         VkBuffer indexBuffer;
         VkDeviceMemory indexBufferMemory;
         std::vector<VkBuffer> uniformBuffers;
@@ -172,14 +349,57 @@ namespace impgine {
         VkDescriptorSetLayout descriptorSetLayout;
         VkDescriptorPool descriptorPool;
         std::vector<VkDescriptorSet> descriptorSets;
-        uint32_t mipLevels;
         VkSampleCountFlagBits msaaSamples = VK_SAMPLE_COUNT_1_BIT;
+        VkSampleCountFlags usableSampleCounts = VK_SAMPLE_COUNT_1_BIT;
         VkImage colorImage;
         VkDeviceMemory colorImageMemory;
         VkImageView colorImageView;
-        VkImage textureImage;
-        VkDeviceMemory textureImageMemory;
-        VkImageView textureImageView;
+        // Materials are immutable after loading, so the render thread reads them
+        // freely. Their textures become ready on whichever thread draws frames
+        struct MaterialTexture {
+            VkImage image;
+            VkDeviceMemory memory;
+            VkImageView view;
+            // Set 3, bound whenever a draw switches textures; unused with bindless textures
+            VkDescriptorSet descriptorSet;
+            uint32_t bindlessSlot;
+            bool ready;
+        };
+        // A texture file being decoded on a worker, straight into its mapped
+        // staging buffer, or loaded block-compressed from its KTX2 cache
+        struct PendingTexture {
+            uint32_t textureIndex;
+            std::string source;
+            uint32_t width;
+            uint32_t height;
+            VkFormat format;
+            bool fromCache;
+            VkBuffer stagingBuffer;
+            VkDeviceMemory stagingMemory;
+            void * mapped;
+            JobCounter decoded;
+            std::exception_ptr error;
+        };
+        std::vector<Material> materials;
+        std::vector<MeshRange> meshRanges;
+        std::vector<MaterialTexture> materialTextures;
+        MaterialTexture placeholderTexture {};
+        std::vector < std::unique_ptr < PendingTexture >> pendingTextures;
+        // Redraw requests queued behind the decodes, waited for before the window goes
+        JobCounter textureRedraws;
+        // materials[i] samples materialTextures[materialTextureIndices[i]]
+        std::vector<uint32_t> materialTextureIndices;
+        std::unordered_map < std::string, uint32_t > texturesByPath;
+        std::unordered_map < uint64_t, uint32_t > texturesByContent;
+        VkDescriptorSetLayout materialSetLayout = VK_NULL_HANDLE;
+        VkDescriptorPool materialDescriptorPool = VK_NULL_HANDLE;
+        // Set 3 instead of the material sets when the device has descriptor indexing
+        std::unique_ptr < BindlessTextures > bindlessTextures;
+        uint32_t bindlessCapacity = 0; // 0 = unsupported or turned off
+        bool physicalDeviceProperties2 = false;
+        // Format of textures loaded from files; RGBA8 unless the device samples
+        // the configured BC format
+        VkFormat textureFormat = VK_FORMAT_R8G8B8A8_SRGB;
         VkSampler textureSampler;
         VkImage depthImage;
         VkDeviceMemory depthImageMemory;
@@ -189,15 +409,91 @@ namespace impgine {
         std::vector < VkCommandBuffer > commandBuffers;
         VkPipelineLayout pipelineLayout;
 
+        // Everything from here to the pacing block is owned by whichever thread renders
         uint32_t currentFrame = 0;
-        bool framebufferResized = false;
+        VkPresentModeKHR swapChainPresentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+        // Set from the GLFW callback on the main thread
+        std::atomic < bool > framebufferResized {
+            false
+        };
+
+        // Frame numbers start at 1; a slot holds the number of its last submitted frame
+        DeletionQueue deletionQueue;
+        uint64_t submittedFrames = 0;
+        uint64_t completedFrames = 0;
+        std::array < uint64_t, SwapChain::MAX_FRAMES_IN_FLIGHT > frameSlotNumbers {};
+
+
+        // Pacing and latency
+        FrameLimiter frameLimiter;
+        FrameLatencyTracker latencyTracker {
+            SwapChain::MAX_FRAMES_IN_FLIGHT
+        };
+
+        // Main thread -> render thread handoff
+        SnapshotQueue snapshotQueue;
+        uint64_t snapshotSequence = 0;
+        std::exception_ptr renderThreadError;
         bool needsPortabilitySubset = false;
+
+        // Benchmark mode; timings wait in their frame slot until its fence signals
+        struct PendingFrameTiming {
+            bool measured = false;
+            FrameTimeRecorder::FrameTiming timing {};
+        };
+        std::unique_ptr < CameraPath > cameraPath;
+        FrameTimeRecorder frameTimes;
+        std::array < PendingFrameTiming, SwapChain::MAX_FRAMES_IN_FLIGHT > pendingFrameTimings {};
+        FrameLatencyTracker::Clock::time_point lastPresentTime {};
+        bool hasPresented = false;
+        std::unique_ptr < GpuProfiler > gpuProfiler;
+        bool pipelineStatisticsSupported = false;
+        std::unique_ptr < StallTracker > stallTracker;
+
+        // Dynamic resolution; the upscaler is recreated with the swap chain
+        std::unique_ptr < DynamicResolution > dynamicResolution;
+        std::unique_ptr < Upscaler > upscaler;
+
+        // Anti-aliasing; both are owned by the rendering thread
+        std::unique_ptr < AdaptiveMsaa > adaptiveMsaa;
+        std::unique_ptr < FxaaPass > fxaaPass;
+
+        // Depth prepass; whether each slot's frame used it, for its overdraw sample
+        struct OverdrawSample {
+            bool prepass = false;
+            uint64_t pixels = 0;
+        };
+        std::unique_ptr < OverdrawMonitor > overdrawMonitor;
+        std::array < OverdrawSample, SwapChain::MAX_FRAMES_IN_FLIGHT > overdrawSamples {};
+
+        // Clustered lighting; the list is owned by the simulation thread and
+        // reaches the renderer through snapshots
+        std::shared_ptr < const std::vector < PointLight >> lights;
+        std::unique_ptr < LightCulling > lightCulling;
+        DirectionalLight sun {
+            glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(1.0f), 0.0f
+        };
+        std::unique_ptr < ShadowMaps > shadowMaps;
+
+        // Capture and replay; hashed frames wait in their slot like timings do.
+        // Captured frames are written by whichever thread draws them
+        std::unique_ptr < FrameCapture::Writer > captureWriter;
+        std::unique_ptr < FrameCapture > replayCapture;
+        std::ofstream frameHashFile;
+        std::array < uint64_t, SwapChain::MAX_FRAMES_IN_FLIGHT > readbackFrames {}; // 0 = nothing to hash
         
         // Input and movement
         double lastMouseX = WIDTH / 2.0;
         double lastMouseY = HEIGHT / 2.0;
         bool firstMouse = true;
         bool mouseCaptured = true;  // Start with mouse captured
+
+        // On-demand rendering, on the main thread; redraws are requested from any
+        std::atomic < bool > redrawRequested {
+            true
+        };
+        bool animating = false;
+        std::chrono::steady_clock::time_point lastRenderTime {};
     };
 
     // Helper functions (in global namespace within impgine)
@@ -0,0 +1,297 @@
+#include "engine_config.hpp"
+
+#include <stdexcept>
+
+namespace impgine {
+
+    namespace {
+
+        // Splits "--name=value" into name and value; value is empty for bare flags
+        void splitOption(const std::string & arg, std::string & name, std::string & value) {
+            size_t equals = arg.find('=');
+            if (equals == std::string::npos) {
+                name = arg;
+                value.clear();
+            } else {
+                name = arg.substr(0, equals);
+                value = arg.substr(equals + 1);
+            }
+        }
+
+        double parseNumber(const std::string & name, const std::string & value) {
+            try {
+                size_t consumed = 0;
+                double number = std::stod(value, & consumed);
+                if (consumed == value.size()) {
+                    return number;
+                }
+            } catch (const std::exception & ) {}
+            throw std::runtime_error("invalid value for " + name + ": '" + value + "'");
+        }
+
+        // Parses "WIDTHxHEIGHT" with both sides positive
+        bool parseExtent(const std::string & value, VkExtent2D * extent) {
+            size_t separator = value.find('x');
+            if (separator == std::string::npos || separator == 0 || separator + 1 == value.size()) {
+                return false;
+            }
+
+            try {
+                size_t consumedWidth = 0, consumedHeight = 0;
+                unsigned long width = std::stoul(value.substr(0, separator), & consumedWidth);
+                unsigned long height = std::stoul(value.substr(separator + 1), & consumedHeight);
+                if (consumedWidth != separator || consumedHeight != value.size() - separator - 1 ||
+                    width == 0 || height == 0 || width > 16384 || height > 16384) {
+                    return false;
+                }
+                extent -> width = static_cast < uint32_t > (width);
+                extent -> height = static_cast < uint32_t > (height);
+                return true;
+            } catch (const std::exception & ) {
+                return false;
+            }
+        }
+
+    } // namespace
+
+    bool parsePresentMode(const std::string & name, VkPresentModeKHR * mode) {
+        if (name == "immediate") {
+            * mode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+        } else if (name == "mailbox") {
+            * mode = VK_PRESENT_MODE_MAILBOX_KHR;
+        } else if (name == "fifo" || name == "vsync") {
+            * mode = VK_PRESENT_MODE_FIFO_KHR;
+        } else if (name == "fifo-relaxed") {
+            * mode = VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    EngineConfig EngineConfig::fromCommandLine(int argc, char ** argv) {
+        EngineConfig config;
+
+        for (int i = 1; i < argc; i++) {
+            std::string name, value;
+            splitOption(argv[i], name, value);
+
+            if (name == "--present-mode") {
+                if (!parsePresentMode(value, & config.presentMode)) {
+                    throw std::runtime_error("unknown present mode: '" + value +
+                        "' (expected immediate, mailbox, fifo or fifo-relaxed)");
+                }
+            } else if (name == "--fps-limit") {
+                config.frameRateLimit = parseNumber(name, value);
+                if (config.frameRateLimit < 0.0) {
+                    throw std::runtime_error("--fps-limit must not be negative");
+                }
+            } else if (name == "--latency-report") {
+                config.reportLatency = true;
+            } else if (name == "--render-thread") {
+                config.renderThread = true;
+            } else if (name == "--worker-threads") {
+                double workers = parseNumber(name, value);
+                if (workers < 0.0 || workers != static_cast < unsigned > (workers)) {
+                    throw std::runtime_error("--worker-threads must be a non-negative integer");
+                }
+                config.workerThreads = static_cast < unsigned > (workers);
+            } else if (name == "--headless") {
+                config.headless = true;
+            } else if (name == "--size") {
+                if (!parseExtent(value, & config.headlessExtent)) {
+                    throw std::runtime_error("invalid value for --size: '" + value + "' (expected WIDTHxHEIGHT)");
+                }
+            } else if (name == "--frames") {
+                double frames = parseNumber(name, value);
+                if (frames < 0.0 || frames != static_cast < uint64_t > (frames)) {
+                    throw std::runtime_error("--frames must be a non-negative integer");
+                }
+                config.frameCount = static_cast < uint64_t > (frames);
+            } else if (name == "--output") {
+                config.outputImage = value;
+            } else if (name == "--benchmark") {
+                config.benchmarkPath = value;
+            } else if (name == "--timestep") {
+                config.benchmarkTimeStep = static_cast < float > (parseNumber(name, value));
+                if (!(config.benchmarkTimeStep > 0.0f)) {
+                    throw std::runtime_error("--timestep must be positive");
+                }
+            } else if (name == "--warmup") {
+                double frames = parseNumber(name, value);
+                if (frames < 0.0 || frames != static_cast < uint64_t > (frames)) {
+                    throw std::runtime_error("--warmup must be a non-negative integer");
+                }
+                config.warmupFrames = static_cast < uint64_t > (frames);
+            } else if (name == "--csv") {
+                config.benchmarkCsv = value;
+            } else if (name == "--capture") {
+                config.captureOutput = value;
+            } else if (name == "--replay") {
+                config.replayPath = value;
+                config.headless = true;
+            } else if (name == "--frame-hashes") {
+                config.frameHashesOutput = value;
+            } else if (name == "--gpu-profile") {
+                config.gpuProfile = true;
+            } else if (name == "--trace") {
+#ifndef IMPGINE_ENABLE_TRACING
+                throw std::runtime_error("--trace needs a build configured with -DIMPGINE_ENABLE_TRACING=ON");
+#endif
+                config.traceOutput = value;
+            } else if (name == "--pipeline-stats") {
+                config.gpuProfile = true;
+                config.pipelineStatistics = true;
+            } else if (name == "--stall-report") {
+                config.stallReport = true;
+            } else if (name == "--stall-watchdog") {
+                config.stallWatchdogMs = parseNumber(name, value);
+                if (!(config.stallWatchdogMs > 0.0)) {
+                    throw std::runtime_error("--stall-watchdog must be positive");
+                }
+            } else if (name == "--dynamic-resolution") {
+                config.dynamicResolution = true;
+                if (!value.empty()) {
+                    config.dynamicResolutionBudgetMs = parseNumber(name, value);
+                    if (!(config.dynamicResolutionBudgetMs > 0.0)) {
+                        throw std::runtime_error("--dynamic-resolution budget must be positive");
+                    }
+                }
+            } else if (name == "--min-scale") {
+                config.minRenderScale = static_cast < float > (parseNumber(name, value));
+            } else if (name == "--max-scale") {
+                config.maxRenderScale = static_cast < float > (parseNumber(name, value));
+            } else if (name == "--msaa") {
+                if (value == "auto") {
+                    config.msaaSamples = 0;
+                } else if (value == "max") {
+                    config.msaaSamples = VK_SAMPLE_COUNT_64_BIT;
+                } else if (value == "off") {
+                    config.msaaSamples = VK_SAMPLE_COUNT_1_BIT;
+                } else {
+                    double samples = parseNumber(name, value);
+                    if (!(samples >= 1.0 && samples <= 64.0) || samples != static_cast < uint32_t > (samples) ||
+                        (static_cast < uint32_t > (samples) & (static_cast < uint32_t > (samples) - 1)) != 0) {
+                        throw std::runtime_error("--msaa must be auto, max, off or a power of two up to 64");
+                    }
+                    config.msaaSamples = static_cast < uint32_t > (samples);
+                }
+            } else if (name == "--fxaa") {
+                config.fxaa = true;
+            } else if (name == "--depth-prepass") {
+                if (value.empty() || value == "on") {
+                    config.depthPrepass = DepthPrepassMode::On;
+                } else if (value == "off") {
+                    config.depthPrepass = DepthPrepassMode::Off;
+                } else if (value == "auto") {
+                    config.depthPrepass = DepthPrepassMode::Auto;
+                } else {
+                    throw std::runtime_error("unknown depth prepass mode: '" + value + "' (expected on, off or auto)");
+                }
+            } else if (name == "--overdraw-threshold") {
+                config.overdrawThreshold = parseNumber(name, value);
+                if (!(config.overdrawThreshold > 0.0)) {
+                    throw std::runtime_error("--overdraw-threshold must be positive");
+                }
+            } else if (name == "--lights") {
+                double count = parseNumber(name, value);
+                if (!(count >= 0.0 && count <= 4096.0) || count != static_cast < uint32_t > (count)) {
+                    throw std::runtime_error("--lights must be a whole number up to 4096");
+                }
+                config.lights = static_cast < uint32_t > (count);
+            } else if (name == "--on-demand") {
+                config.onDemand = true;
+            } else if (name == "--idle-redraw") {
+                config.idleRedrawSeconds = parseNumber(name, value);
+                if (!(config.idleRedrawSeconds > 0.0)) {
+                    throw std::runtime_error("--idle-redraw must be positive");
+                }
+            } else if (name == "--generate-normals") {
+                config.generateNormals = true;
+            } else if (name == "--normal-weighting") {
+                if (value == "angle") {
+                    config.normalWeighting = NormalWeighting::Angle;
+                } else if (value == "area") {
+                    config.normalWeighting = NormalWeighting::Area;
+                } else {
+                    throw std::runtime_error("unknown normal weighting: '" + value + "' (expected angle or area)");
+                }
+            } else if (name == "--crease-angle") {
+                double degrees = parseNumber(name, value);
+                if (!(degrees >= 0.0 && degrees <= 180.0)) {
+                    throw std::runtime_error("--crease-angle must be from 0 to 180 degrees");
+                }
+                config.creaseAngle = static_cast < float > (degrees);
+            } else if (name == "--bake-ao") {
+                config.occlusionSamples = 64;
+                if (!value.empty()) {
+                    double samples = parseNumber(name, value);
+                    if (!(samples >= 1.0 && samples <= 4096.0) || samples != static_cast < uint32_t > (samples)) {
+                        throw std::runtime_error("--bake-ao samples must be a whole number from 1 to 4096");
+                    }
+                    config.occlusionSamples = static_cast < uint32_t > (samples);
+                }
+            } else if (name == "--no-mesh-cache") {
+                config.meshCache = false;
+            } else if (name == "--load-report") {
+                config.loadReport = true;
+            } else if (name == "--no-bindless") {
+                config.bindless = false;
+            } else if (name == "--texture-compression") {
+                config.textureCompression = value != "off";
+                if (value == "bc1") {
+                    config.textureFormat = BlockFormat::BC1;
+                } else if (value == "bc3") {
+                    config.textureFormat = BlockFormat::BC3;
+                } else if (value == "bc7") {
+                    config.textureFormat = BlockFormat::BC7;
+                } else if (value != "off") {
+                    throw std::runtime_error("unknown texture compression: '" + value + "' (expected bc1, bc3, bc7 or off)");
+                }
+            } else if (name == "--shadows") {
+                config.shadows = true;
+                if (!value.empty()) {
+                    double size = parseNumber(name, value);
+                    if (!(size >= 256.0 && size <= 8192.0) || size != static_cast < uint32_t > (size)) {
+                        throw std::runtime_error("--shadows map size must be a whole number from 256 to 8192");
+                    }
+                    config.shadowMapSize = static_cast < uint32_t > (size);
+                }
+            } else {
+                throw std::runtime_error("unknown option: " + name);
+            }
+        }
+
+        if (!config.outputImage.empty() && !config.headless) {
+            throw std::runtime_error("--output needs --headless");
+        }
+        if (!config.benchmarkCsv.empty() && config.benchmarkPath.empty() && config.replayPath.empty()) {
+            throw std::runtime_error("--csv needs --benchmark or --replay");
+        }
+        if (!config.replayPath.empty() && !config.benchmarkPath.empty()) {
+            throw std::runtime_error("--replay and --benchmark both drive the camera; pick one");
+        }
+        if (!config.frameHashesOutput.empty() && !config.headless) {
+            throw std::runtime_error("--frame-hashes needs --headless or --replay");
+        }
+        if (!(config.minRenderScale > 0.0f && config.minRenderScale <= config.maxRenderScale && config.maxRenderScale <= 2.0f)) {
+            throw std::runtime_error("render scales must satisfy 0 < --min-scale <= --max-scale <= 2");
+        }
+        // Both would steer by the same GPU time and fight each other
+        if (config.dynamicResolution && config.msaaSamples == 0) {
+            throw std::runtime_error("--msaa=auto and --dynamic-resolution both adapt to GPU time; pick one");
+        }
+        if (config.onDemand && config.headless) {
+            throw std::runtime_error("--on-demand needs a window");
+        }
+        if (config.idleRedrawSeconds > 0.0 && !config.onDemand) {
+            throw std::runtime_error("--idle-redraw needs --on-demand");
+        }
+        if (config.dynamicResolution && config.fxaa) {
+            throw std::runtime_error("--fxaa is not supported with --dynamic-resolution");
+        }
+
+        return config;
+    }
+
+} // namespace impgine
\ No newline at end of file
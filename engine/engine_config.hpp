@@ -0,0 +1,142 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <string>
+
+#include "assets/block_compression.hpp"
+#include "assets/mesh_attributes.hpp"
+
+namespace impgine {
+
+    enum class DepthPrepassMode {
+        Off,
+        On,
+        // On while the measured overdraw exceeds EngineConfig::overdrawThreshold
+        Auto
+    };
+
+    // Runtime options for an Engine instance. Defaults reproduce the
+    // behaviour of a plain `Impgine` launch.
+    struct EngineConfig {
+        // Preferred present mode; SwapChain falls back when the surface lacks it
+        VkPresentModeKHR presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+        // 0 disables the frame limiter
+        double frameRateLimit = 0.0;
+        // Only render when something changed: camera input, a resize, a
+        // setter, Engine::requestRedraw or a running animation. Otherwise
+        // block on window events, redrawing at least every idleRedrawSeconds
+        // (0 = never)
+        bool onDemand = false;
+        double idleRedrawSeconds = 0.0;
+        // Print input/submit/GPU/present latency histograms on shutdown
+        bool reportLatency = false;
+        // Record and submit on a dedicated thread fed with frame snapshots
+        bool renderThread = false;
+        // Job system workers; 0 uses one per hardware thread minus the main thread
+        unsigned workerThreads = 0;
+        // Render into an offscreen image instead of a window; needs no display.
+        // Always renders on the calling thread
+        bool headless = false;
+        VkExtent2D headlessExtent = {
+            1280,
+            720
+        };
+        // Stop after this many frames; 0 runs until the window closes (one frame when headless)
+        uint64_t frameCount = 0;
+        // Headless only: write the last frame here as a PPM image
+        std::string outputImage;
+
+        // Benchmark mode: replay this camera path with a fixed time step and
+        // report per-frame CPU, GPU and present timings. Without --frames the
+        // path is played once
+        std::string benchmarkPath;
+        float benchmarkTimeStep = 1.0f / 60.0f;
+        // Frames rendered before measuring starts; not counted in frameCount
+        uint64_t warmupFrames = 0;
+        // Per-frame timings as CSV
+        std::string benchmarkCsv;
+
+        // Record every frame's snapshot and the asset set to this file
+        std::string captureOutput;
+        // Replay a capture offscreen at full speed and report frame timings like
+        // a benchmark run; implies headless
+        std::string replayPath;
+        // Headless only: FNV-1a hash of every rendered frame, one "frame hash" line each
+        std::string frameHashesOutput;
+
+        // GPU timestamp scopes, reported on shutdown; always on when benchmarking
+        bool gpuProfile = false;
+        // Adds vertex/clipping/fragment counters; implies gpuProfile
+        bool pipelineStatistics = false;
+        // Chrome trace JSON of CPU and GPU zones, written on exit. Needs a build
+        // configured with IMPGINE_ENABLE_TRACING
+        std::string traceOutput;
+
+        // Time every blocking Vulkan call and print the breakdown on exit
+        bool stallReport = false;
+        // Report waits still blocked after this many milliseconds while they
+        // happen; 0 disables the watchdog
+        double stallWatchdogMs = 0.0;
+
+        // Render the scene below output resolution whenever the GPU misses its
+        // budget and upscale the result. A budget of 0 derives it from the
+        // frame rate limit (60 fps without one)
+        bool dynamicResolution = false;
+        double dynamicResolutionBudgetMs = 0.0;
+        // Render scale bounds, as a fraction of the output size per axis
+        float minRenderScale = 0.5f;
+        float maxRenderScale = 1.0f;
+
+        // MSAA sample count, rounded down to what the device supports; the
+        // default uses its maximum. 0 picks the highest count that fits the GPU
+        // frame budget and keeps adjusting it while running
+        uint32_t msaaSamples = VK_SAMPLE_COUNT_64_BIT;
+        // FXAA compute pass whenever rendering with a single sample
+        bool fxaa = false;
+
+        // Depth-only pass over a position-only vertex stream before shading, so
+        // the main pass shades each pixel once with an EQUAL depth test.
+        // Fragment invocations with and without it are reported on exit
+        DepthPrepassMode depthPrepass = DepthPrepassMode::Off;
+        // Fragment shader invocations per rendered pixel
+        double overdrawThreshold = 2.0;
+
+        // Point lights scattered through the scene at startup (up to 4096)
+        uint32_t lights = 0;
+
+        // Cascaded shadow maps for the directional light, each this many texels
+        // square; also turns on a default sun
+        bool shadows = false;
+        uint32_t shadowMapSize = 2048;
+
+        // Model import: regenerate normals even when the file has them, how
+        // faces are weighted, and the crease angle in degrees beyond which
+        // generated normals stay hard
+        bool generateNormals = false;
+        NormalWeighting normalWeighting = NormalWeighting::Angle;
+        float creaseAngle = 60.0f;
+        // Bake per-vertex ambient occlusion with this many rays per vertex; 0 skips the bake
+        uint32_t occlusionSamples = 0;
+        // Keep the processed model next to the OBJ and reuse it while the file
+        // and the options above are unchanged
+        bool meshCache = true;
+        // Print the time each model load stage took
+        bool loadReport = false;
+
+        // Index every texture from one descriptor array, bound once per frame,
+        // where the device supports descriptor indexing; otherwise (or when
+        // off) each texture gets its own set, rebound between draws
+        bool bindless = true;
+        // Keep textures block-compressed in VRAM where the device samples BC
+        // formats. Each file is encoded once into "<file>.<format>.ktx2" and
+        // reloaded from there; off (or unsupported) uploads RGBA8
+        bool textureCompression = true;
+        BlockFormat textureFormat = BlockFormat::BC7;
+
+        static EngineConfig fromCommandLine(int argc, char ** argv);
+    };
+
+    bool parsePresentMode(const std::string & name, VkPresentModeKHR * mode);
+
+} // namespace impgine
\ No newline at end of file
@@ -0,0 +1,44 @@
+#include "frame_limiter.hpp"
+
+#include <thread>
+
+namespace impgine {
+
+    void FrameLimiter::setTargetFrameRate(double framesPerSecond) {
+        if (framesPerSecond <= 0.0) {
+            framePeriod = Clock::duration {
+                0
+            };
+            return;
+        }
+
+        framePeriod = std::chrono::duration_cast < Clock::duration > (
+            std::chrono::duration < double > (1.0 / framesPerSecond));
+        nextDeadline = Clock::now();
+    }
+
+    void FrameLimiter::wait() {
+        if (!isEnabled()) {
+            return;
+        }
+
+        nextDeadline += framePeriod;
+        auto now = Clock::now();
+
+        // Fell more than a frame behind (stall, breakpoint): restart the cadence
+        // instead of bursting frames to catch up
+        if (now > nextDeadline + framePeriod) {
+            nextDeadline = now;
+            return;
+        }
+
+        if (nextDeadline - now > spinThreshold) {
+            std::this_thread::sleep_for(nextDeadline - now - spinThreshold);
+        }
+
+        while (Clock::now() < nextDeadline) {
+            std::this_thread::yield();
+        }
+    }
+
+} // namespace impgine
\ No newline at end of file
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <chrono>
+
+namespace impgine {
+
+    // Caps the loop rate by sleeping for most of the remaining frame budget and
+    // spinning for the last stretch, since OS sleeps routinely overshoot by a
+    // millisecond or more.
+    class FrameLimiter {
+        public: using Clock = std::chrono::steady_clock;
+
+        void setTargetFrameRate(double framesPerSecond);
+        bool isEnabled() const {
+            return framePeriod.count() > 0;
+        }
+
+        // Blocks until the next frame slot opens
+        void wait();
+
+        private: Clock::duration framePeriod {
+            0
+        };
+        Clock::time_point nextDeadline {};
+        // Portion of the wait that is spun instead of slept
+        Clock::duration spinThreshold = std::chrono::microseconds(1500);
+    };
+
+} // namespace impgine
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#define GLM_FORCE_DEFAULT_ALIGNED_GENTYPES
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "directional_light.hpp"
+#include "point_light.hpp"
+#include "profiling/frame_latency.hpp"
+
+namespace impgine {
+
+    struct DrawItem {
+        glm::mat4 model {
+            1.0f
+        };
+        uint32_t firstIndex = 0;
+        uint32_t indexCount = 0;
+        int32_t vertexOffset = 0;
+        uint32_t objectIndex = 0;
+        uint32_t materialIndex = 0;
+        // Moves independently of the static scene, so it is drawn into the
+        // shadow maps every frame instead of into their caches
+        bool dynamic = false;
+    };
+
+    // Everything the renderer needs to draw one frame, captured by the thread
+    // that owns input and simulation. Never modified after it is published, so
+    // the render thread can read it without locks.
+    struct FrameSnapshot {
+        uint64_t sequence = 0;
+        glm::mat4 view {
+            1.0f
+        };
+        glm::mat4 proj {
+            1.0f
+        };
+        std::vector < DrawItem > drawList;
+        // Shared rather than copied: the list only changes when it is replaced
+        std::shared_ptr < const std::vector < PointLight >> lights;
+        DirectionalLight sun {
+            glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(1.0f), 0.0f
+        };
+        VkExtent2D framebufferExtent {
+            0, 0
+        };
+        VkPresentModeKHR presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+        // Requested MSAA sample count; 0 = automatic
+        uint32_t msaaSamples = VK_SAMPLE_COUNT_64_BIT;
+        FrameLatencyTracker::Clock::time_point inputSampleTime {};
+    };
+
+} // namespace impgine
\ No newline at end of file
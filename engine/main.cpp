@@ -5,10 +5,11 @@
 #include "engine.hpp"
 
 namespace impgine {
-    int main() {
-        Engine engine;
-
+    int main(int argc, char ** argv) {
         try {
+            Engine engine {
+                EngineConfig::fromCommandLine(argc, argv)
+            };
             engine.run();
         } catch (const std::exception & e) {
             std::cerr << e.what() << std::endl;
@@ -19,6 +20,6 @@ namespace impgine {
     }
 } // namespace impgine
 
-int main() {
-    return impgine::main();
+int main(int argc, char ** argv) {
+    return impgine::main(argc, argv);
 }
\ No newline at end of file
@@ -0,0 +1,25 @@
+#include "point_light.hpp"
+
+#include <algorithm>
+#include <random>
+
+namespace impgine {
+
+    std::vector < PointLight > scatterPointLights(uint32_t count, glm::vec3 boundsMin, glm::vec3 boundsMax,
+        float radius, uint32_t seed) {
+        std::mt19937 generator(seed);
+        std::uniform_real_distribution < float > unit(0.0f, 1.0f);
+
+        std::vector < PointLight > lights(count);
+        for (PointLight & light: lights) {
+            light.position = boundsMin + (boundsMax - boundsMin) * glm::vec3(unit(generator), unit(generator), unit(generator));
+            light.radius = radius;
+            // Saturated colours, so overlapping lights stay distinguishable
+            light.color = glm::vec3(unit(generator), unit(generator), unit(generator));
+            light.color /= std::max({light.color.x, light.color.y, light.color.z, 0.001f});
+            light.intensity = 1.0f;
+        }
+        return lights;
+    }
+
+} // namespace impgine
\ No newline at end of file
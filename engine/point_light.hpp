@@ -0,0 +1,30 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#define GLM_FORCE_DEFAULT_ALIGNED_GENTYPES
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace impgine {
+
+    // World-space point light. Its contribution fades to exactly zero at
+    // `radius`, which is also the bound the clustered culling tests against
+    struct PointLight {
+        glm::vec3 position {
+            0.0f
+        };
+        float radius = 1.0f;
+        glm::vec3 color {
+            1.0f
+        };
+        float intensity = 1.0f;
+    };
+
+    // Deterministic pseudo-random lights inside the given box, for demos and benchmarks
+    std::vector < PointLight > scatterPointLights(uint32_t count, glm::vec3 boundsMin, glm::vec3 boundsMax,
+        float radius, uint32_t seed = 1);
+
+} // namespace impgine
\ No newline at end of file
@@ -0,0 +1,65 @@
+#include "frame_latency.hpp"
+
+namespace impgine {
+
+    FrameLatencyTracker::FrameLatencyTracker(size_t framesInFlight): frames(framesInFlight) {}
+
+    void FrameLatencyTracker::markGpuComplete(uint32_t frameIndex, Clock::time_point time) {
+        FrameTimestamps & frame = frames[frameIndex];
+        if (!frame.submitted) {
+            return;
+        }
+
+        inputToGpuCompleteUs.record(microsecondsBetween(frame.inputSample, time));
+        submitToGpuCompleteUs.record(microsecondsBetween(frame.cpuSubmit, time));
+        frame.submitted = false;
+    }
+
+    void FrameLatencyTracker::beginFrame(uint32_t frameIndex, Clock::time_point inputSampleTime) {
+        FrameTimestamps & frame = frames[frameIndex];
+        frame = FrameTimestamps {};
+        frame.inputSample = inputSampleTime;
+    }
+
+    void FrameLatencyTracker::markSubmitted(uint32_t frameIndex, Clock::time_point time) {
+        FrameTimestamps & frame = frames[frameIndex];
+        frame.cpuSubmit = time;
+        frame.submitted = true;
+        inputToSubmitUs.record(microsecondsBetween(frame.inputSample, time));
+    }
+
+    void FrameLatencyTracker::markPresented(uint32_t frameIndex, Clock::time_point time) {
+        FrameTimestamps & frame = frames[frameIndex];
+        frame.present = time;
+        inputToPresentUs.record(microsecondsBetween(frame.inputSample, time));
+
+        if (hasPresented) {
+            presentIntervalUs.record(microsecondsBetween(lastPresent, time));
+        }
+        lastPresent = time;
+        hasPresented = true;
+    }
+
+    void FrameLatencyTracker::reset() {
+        for (auto & frame: frames) {
+            frame = FrameTimestamps {};
+        }
+        hasPresented = false;
+
+        inputToSubmitUs.reset();
+        inputToPresentUs.reset();
+        inputToGpuCompleteUs.reset();
+        submitToGpuCompleteUs.reset();
+        presentIntervalUs.reset();
+    }
+
+    void FrameLatencyTracker::report(std::ostream & out) const {
+        out << "Frame latency:\n";
+        inputToSubmitUs.print(out, "  input -> submit");
+        inputToPresentUs.print(out, "  input -> present");
+        inputToGpuCompleteUs.print(out, "  input -> GPU done");
+        submitToGpuCompleteUs.print(out, "  submit -> GPU done");
+        presentIntervalUs.print(out, "  present interval");
+    }
+
+} // namespace impgine
\ No newline at end of file
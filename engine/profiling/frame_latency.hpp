@@ -0,0 +1,67 @@
+#pragma once
+
+#include <chrono>
+#include <ostream>
+#include <vector>
+
+#include "histogram.hpp"
+
+namespace impgine {
+
+    // Follows each frame from the moment its input was sampled until the GPU is
+    // known to have finished it. GPU completion is taken from the frame's
+    // in-flight fence, so it is the time the CPU *observed* the fence signaled,
+    // an upper bound on the real completion time.
+    class FrameLatencyTracker {
+        public: using Clock = std::chrono::steady_clock;
+
+        explicit FrameLatencyTracker(size_t framesInFlight);
+
+        // Called right after the in-flight fence of `frameIndex` has been waited on
+        void markGpuComplete(uint32_t frameIndex, Clock::time_point time = Clock::now());
+        void beginFrame(uint32_t frameIndex, Clock::time_point inputSampleTime);
+        void markSubmitted(uint32_t frameIndex, Clock::time_point time = Clock::now());
+        void markPresented(uint32_t frameIndex, Clock::time_point time = Clock::now());
+
+        const Histogram & inputToSubmit() const {
+            return inputToSubmitUs;
+        }
+        const Histogram & inputToPresent() const {
+            return inputToPresentUs;
+        }
+        const Histogram & inputToGpuComplete() const {
+            return inputToGpuCompleteUs;
+        }
+        const Histogram & submitToGpuComplete() const {
+            return submitToGpuCompleteUs;
+        }
+        const Histogram & presentInterval() const {
+            return presentIntervalUs;
+        }
+
+        void reset();
+        void report(std::ostream & out) const;
+
+        private: struct FrameTimestamps {
+            Clock::time_point inputSample;
+            Clock::time_point cpuSubmit;
+            Clock::time_point present;
+            bool submitted = false;
+        };
+
+        static double microsecondsBetween(Clock::time_point from, Clock::time_point to) {
+            return std::chrono::duration < double, std::micro > (to - from).count();
+        }
+
+        std::vector < FrameTimestamps > frames;
+        Clock::time_point lastPresent {};
+        bool hasPresented = false;
+
+        Histogram inputToSubmitUs;
+        Histogram inputToPresentUs;
+        Histogram inputToGpuCompleteUs;
+        Histogram submitToGpuCompleteUs;
+        Histogram presentIntervalUs;
+    };
+
+} // namespace impgine
\ No newline at end of file
@@ -0,0 +1,94 @@
+#include "frame_time_recorder.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+namespace impgine {
+
+    namespace {
+
+        // Same columns as Histogram::print, computed exactly from the samples
+        void printStats(std::ostream & out,
+            const char * label, std::vector < double > values) {
+            out << std::fixed << std::setprecision(3) << std::left << std::setw(24) << label << std::right;
+            if (values.empty()) {
+                out << " n/a\n";
+                return;
+            }
+
+            std::sort(values.begin(), values.end());
+            double sum = 0.0;
+            for (double value: values) {
+                sum += value;
+            }
+
+            // Nearest-rank percentile
+            auto percentile = [ & values](double p) {
+                size_t rank = static_cast < size_t > (std::ceil(p * values.size()));
+                return values[std::max < size_t > (rank, 1) - 1];
+            };
+
+            out << " n=" << std::setw(6) << values.size() <<
+                "  min " << std::setw(8) << values.front() <<
+                "  mean " << std::setw(8) << sum / values.size() <<
+                "  p50 " << std::setw(8) << percentile(0.50) <<
+                "  p95 " << std::setw(8) << percentile(0.95) <<
+                "  p99 " << std::setw(8) << percentile(0.99) <<
+                "  max " << std::setw(8) << values.back() << " ms\n";
+        }
+
+    } // namespace
+
+    void FrameTimeRecorder::report(std::ostream & out) const {
+        std::vector < double > cpu, gpu, presentInterval;
+        for (const auto & frame: frames) {
+            cpu.push_back(frame.cpuMs);
+            if (frame.gpuMs >= 0.0) {
+                gpu.push_back(frame.gpuMs);
+            }
+            // The first measured frame has no previous present to compare with
+            if (frame.presentIntervalMs >= 0.0) {
+                presentInterval.push_back(frame.presentIntervalMs);
+            }
+        }
+
+        out << "Benchmark (" << frames.size() << " frames):\n";
+        printStats(out, "  CPU frame time", cpu);
+        printStats(out, "  GPU time", gpu);
+        printStats(out, "  present interval", presentInterval);
+    }
+
+    void FrameTimeRecorder::writeCsv(const std::string & filepath) const {
+        std::ofstream file(filepath);
+        if (!file) {
+            throw std::runtime_error("failed to open " + filepath + " for writing!");
+        }
+
+        // Unavailable values are left empty rather than written as -1
+        auto field = [ & file](double value) {
+            if (value >= 0.0) {
+                file << value;
+            }
+        };
+
+        file << "frame,cpu_ms,gpu_ms,present_interval_ms\n";
+        file << std::fixed << std::setprecision(4);
+        for (const auto & frame: frames) {
+            file << frame.frame << ",";
+            field(frame.cpuMs);
+            file << ",";
+            field(frame.gpuMs);
+            file << ",";
+            field(frame.presentIntervalMs);
+            file << "\n";
+        }
+
+        if (!file) {
+            throw std::runtime_error("failed to write " + filepath + "!");
+        }
+    }
+
+} // namespace impgine
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace impgine {
+
+    // Keeps every measured frame of a benchmark run so statistics are exact
+    // and the run can be dumped as CSV for offline comparison.
+    class FrameTimeRecorder {
+        public: struct FrameTiming {
+            uint64_t frame;
+            // CPU time spent building and submitting the frame, fence wait excluded
+            double cpuMs;
+            // Timestamp delta around the command buffer; negative when unsupported
+            double gpuMs;
+            // Time since the previous present (or submit when headless)
+            double presentIntervalMs;
+        };
+
+        void record(const FrameTiming & timing) {
+            frames.push_back(timing);
+        }
+        size_t size() const {
+            return frames.size();
+        }
+
+        void report(std::ostream & out) const;
+        void writeCsv(const std::string & filepath) const;
+
+        private: std::vector < FrameTiming > frames;
+    };
+
+} // namespace impgine
\ No newline at end of file
@@ -0,0 +1,344 @@
+#include "gpu_profiler.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <stdexcept>
+
+namespace impgine {
+
+    namespace {
+
+        // Frame begin and end come first, then a begin/end pair per scope
+        constexpr uint32_t FRAME_QUERIES = 2;
+        constexpr uint32_t QUERIES_PER_POOL = FRAME_QUERIES + GpuProfiler::MAX_SCOPES_PER_FRAME * 2;
+
+        constexpr VkQueryPipelineStatisticFlags STATISTICS_FLAGS =
+            VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+            VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+            VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+            VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
+            VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+            VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+        constexpr uint32_t STATISTICS_COUNT = 6;
+
+    } // namespace
+
+    GpuProfiler::Scope::Scope(GpuProfiler * profiler, VkCommandBuffer commandBuffer,
+        const char * name): profiler {
+        profiler
+    }, commandBuffer {
+        commandBuffer
+    }, index {
+        profiler ? profiler -> beginScope(commandBuffer, name) : NO_SCOPE
+    } {}
+
+    GpuProfiler::Scope::~Scope() {
+        if (profiler) {
+            profiler -> endScope(commandBuffer, index);
+        }
+    }
+
+    GpuProfiler::GpuProfiler(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex,
+        uint32_t framesInFlight, bool pipelineStatistics): device {
+        device
+    }, pipelineStatisticsEnabled {
+        pipelineStatistics
+    } {
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, & queueFamilyCount, nullptr);
+        std::vector < VkQueueFamilyProperties > queueFamilies(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, & queueFamilyCount, queueFamilies.data());
+
+        uint32_t validBits = queueFamilies.at(queueFamilyIndex).timestampValidBits;
+        if (validBits == 0) {
+            return;
+        }
+        timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevice, & properties);
+        timestampPeriod = properties.limits.timestampPeriod;
+
+        framePools.resize(framesInFlight);
+        for (auto & pool: framePools) {
+            VkQueryPoolCreateInfo timestampInfo {};
+            timestampInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+            timestampInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+            timestampInfo.queryCount = QUERIES_PER_POOL;
+
+            if (vkCreateQueryPool(device, & timestampInfo, nullptr, & pool.timestamps) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create timestamp query pool!");
+            }
+
+            if (pipelineStatisticsEnabled) {
+                VkQueryPoolCreateInfo statisticsInfo {};
+                statisticsInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+                statisticsInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+                statisticsInfo.queryCount = 1;
+                statisticsInfo.pipelineStatistics = STATISTICS_FLAGS;
+
+                if (vkCreateQueryPool(device, & statisticsInfo, nullptr, & pool.statistics) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to create pipeline statistics query pool!");
+                }
+            }
+
+            pool.scopes.reserve(MAX_SCOPES_PER_FRAME);
+        }
+    }
+
+    GpuProfiler::~GpuProfiler() {
+        for (auto & pool: framePools) {
+            vkDestroyQueryPool(device, pool.timestamps, nullptr);
+            if (pool.statistics != VK_NULL_HANDLE) {
+                vkDestroyQueryPool(device, pool.statistics, nullptr);
+            }
+        }
+    }
+
+    void GpuProfiler::calibrate(VkQueue queue, VkCommandPool commandPool) {
+        if (!isSupported()) {
+            return;
+        }
+
+        VkCommandBufferAllocateInfo allocInfo {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandPool = commandPool;
+        allocInfo.commandBufferCount = 1;
+
+        VkCommandBuffer commandBuffer;
+        if (vkAllocateCommandBuffers(device, & allocInfo, & commandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate calibration command buffer!");
+        }
+
+        // Borrow the first query of slot 0; beginFrame resets it before use anyway
+        VkQueryPool pool = framePools[0].timestamps;
+
+        VkCommandBufferBeginInfo beginInfo {};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(commandBuffer, & beginInfo);
+        vkCmdResetQueryPool(commandBuffer, pool, 0, 1);
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, pool, 0);
+        vkEndCommandBuffer(commandBuffer);
+
+        VkSubmitInfo submitInfo {};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = & commandBuffer;
+
+        auto toNs = [](std::chrono::steady_clock::time_point time) {
+            return static_cast < int64_t > (std::chrono::duration_cast < std::chrono::nanoseconds > (
+                time.time_since_epoch()).count());
+        };
+
+        int64_t cpuBefore = toNs(std::chrono::steady_clock::now());
+        vkQueueSubmit(queue, 1, & submitInfo, VK_NULL_HANDLE);
+        vkQueueWaitIdle(queue);
+        int64_t cpuAfter = toNs(std::chrono::steady_clock::now());
+
+        uint64_t ticks = 0;
+        if (vkGetQueryPoolResults(device, pool, 0, 1, sizeof(ticks), & ticks, sizeof(ticks),
+                VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT) == VK_SUCCESS) {
+            cpuOffsetNs = cpuBefore + (cpuAfter - cpuBefore) / 2 - static_cast < int64_t > (toNanoseconds(ticks));
+            calibrated = true;
+        }
+
+        vkFreeCommandBuffers(device, commandPool, 1, & commandBuffer);
+    }
+
+    void GpuProfiler::beginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex) {
+        if (!isSupported()) {
+            return;
+        }
+
+        recording = & framePools[frameIndex];
+        recording -> scopes.clear();
+        recording -> queryCount = FRAME_QUERIES;
+        recording -> statisticsWritten = false;
+        recording -> pending = false;
+        scopeDepth = 0;
+
+        vkCmdResetQueryPool(commandBuffer, recording -> timestamps, 0, QUERIES_PER_POOL);
+        if (recording -> statistics != VK_NULL_HANDLE) {
+            vkCmdResetQueryPool(commandBuffer, recording -> statistics, 0, 1);
+        }
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, recording -> timestamps, 0);
+    }
+
+    void GpuProfiler::endFrame(VkCommandBuffer commandBuffer) {
+        if (recording == nullptr) {
+            return;
+        }
+
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, recording -> timestamps, 1);
+        recording -> pending = true;
+        recording = nullptr;
+    }
+
+    uint32_t GpuProfiler::beginScope(VkCommandBuffer commandBuffer,
+        const char * name) {
+        if (recording == nullptr || recording -> queryCount + 2 > QUERIES_PER_POOL) {
+            if (recording != nullptr) {
+                droppedScopes++;
+            }
+            return NO_SCOPE;
+        }
+
+        ScopeRecord scope {};
+        scope.name = name;
+        scope.depth = scopeDepth++;
+        scope.beginQuery = recording -> queryCount;
+        scope.endQuery = recording -> queryCount + 1;
+        recording -> queryCount += 2;
+
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, recording -> timestamps, scope.beginQuery);
+        recording -> scopes.push_back(scope);
+        return static_cast < uint32_t > (recording -> scopes.size() - 1);
+    }
+
+    void GpuProfiler::endScope(VkCommandBuffer commandBuffer, uint32_t index) {
+        if (recording == nullptr || index == NO_SCOPE) {
+            return;
+        }
+
+        scopeDepth--;
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, recording -> timestamps,
+            recording -> scopes[index].endQuery);
+    }
+
+    void GpuProfiler::beginPipelineStatistics(VkCommandBuffer commandBuffer) {
+        if (recording == nullptr || recording -> statistics == VK_NULL_HANDLE) {
+            return;
+        }
+        vkCmdBeginQuery(commandBuffer, recording -> statistics, 0, 0);
+    }
+
+    void GpuProfiler::endPipelineStatistics(VkCommandBuffer commandBuffer) {
+        if (recording == nullptr || recording -> statistics == VK_NULL_HANDLE) {
+            return;
+        }
+        vkCmdEndQuery(commandBuffer, recording -> statistics, 0);
+        recording -> statisticsWritten = true;
+    }
+
+    uint64_t GpuProfiler::toNanoseconds(uint64_t ticks) const {
+        return static_cast < uint64_t > (static_cast < double > (ticks & timestampMask) * timestampPeriod);
+    }
+
+    const GpuProfiler::FrameResult * GpuProfiler::collect(uint32_t frameIndex, bool accumulate) {
+        if (!isSupported() || !framePools[frameIndex].pending) {
+            return nullptr;
+        }
+
+        FramePool & pool = framePools[frameIndex];
+        pool.pending = false;
+
+        // The fence has signaled, so the results are there; no WAIT flag needed
+        std::array < uint64_t, QUERIES_PER_POOL > ticks {};
+        if (vkGetQueryPoolResults(device, pool.timestamps, 0, pool.queryCount, pool.queryCount * sizeof(uint64_t),
+                ticks.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS) {
+            return nullptr;
+        }
+
+        auto millisecondsBetween = [this](uint64_t begin, uint64_t end) {
+            return static_cast < double > ((end - begin) & timestampMask) * timestampPeriod / 1.0e6;
+        };
+
+        latest.beginNs = toNanoseconds(ticks[0]);
+        latest.endNs = toNanoseconds(ticks[1]);
+        latest.totalMs = millisecondsBetween(ticks[0], ticks[1]);
+        latest.scopes.clear();
+        for (const auto & scope: pool.scopes) {
+            ScopeResult result {};
+            result.name = scope.name;
+            result.depth = scope.depth;
+            result.beginNs = toNanoseconds(ticks[scope.beginQuery]);
+            result.endNs = toNanoseconds(ticks[scope.endQuery]);
+            result.durationMs = millisecondsBetween(ticks[scope.beginQuery], ticks[scope.endQuery]);
+            latest.scopes.push_back(result);
+        }
+
+        latest.hasPipelineStatistics = false;
+        if (pool.statisticsWritten) {
+            std::array < uint64_t, STATISTICS_COUNT > counters {};
+            if (vkGetQueryPoolResults(device, pool.statistics, 0, 1, sizeof(counters), counters.data(),
+                    sizeof(counters), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS) {
+                // Results come in the order of the flag bits
+                latest.hasPipelineStatistics = true;
+                latest.pipelineStatistics.inputAssemblyVertices = counters[0];
+                latest.pipelineStatistics.inputAssemblyPrimitives = counters[1];
+                latest.pipelineStatistics.vertexShaderInvocations = counters[2];
+                latest.pipelineStatistics.clippingInvocations = counters[3];
+                latest.pipelineStatistics.clippingPrimitives = counters[4];
+                latest.pipelineStatistics.fragmentShaderInvocations = counters[5];
+            }
+        }
+
+        if (accumulate) {
+            frameHistogram.record(latest.totalMs * 1000.0);
+            for (const auto & scope: latest.scopes) {
+                auto inserted = scopeHistograms.emplace(scope.name, Histogram {});
+                if (inserted.second) {
+                    scopeOrder.push_back(scope.name);
+                }
+                inserted.first -> second.record(scope.durationMs * 1000.0);
+            }
+
+            if (latest.hasPipelineStatistics) {
+                const PipelineStatistics & stats = latest.pipelineStatistics;
+                statisticsSum.inputAssemblyVertices += stats.inputAssemblyVertices;
+                statisticsSum.inputAssemblyPrimitives += stats.inputAssemblyPrimitives;
+                statisticsSum.vertexShaderInvocations += stats.vertexShaderInvocations;
+                statisticsSum.clippingInvocations += stats.clippingInvocations;
+                statisticsSum.clippingPrimitives += stats.clippingPrimitives;
+                statisticsSum.fragmentShaderInvocations += stats.fragmentShaderInvocations;
+                statisticsFrames++;
+            }
+        }
+
+        return & latest;
+    }
+
+    void GpuProfiler::resetStatistics() {
+        frameHistogram.reset();
+        scopeHistograms.clear();
+        scopeOrder.clear();
+        statisticsSum = PipelineStatistics {};
+        statisticsFrames = 0;
+    }
+
+    void GpuProfiler::report(std::ostream & out) const {
+        if (!isSupported()) {
+            out << "GPU timings: timestamps unsupported on this queue\n";
+            return;
+        }
+
+        out << "GPU timings:\n";
+        frameHistogram.print(out, "  frame");
+        for (const auto & name: scopeOrder) {
+            std::string label = "    " + name;
+            scopeHistograms.at(name).print(out, label.c_str());
+        }
+        if (droppedScopes > 0) {
+            out << "  (" << droppedScopes << " scopes dropped, over " << MAX_SCOPES_PER_FRAME << " per frame)\n";
+        }
+
+        if (statisticsFrames > 0) {
+            auto average = [this](uint64_t sum) {
+                return sum / statisticsFrames;
+            };
+            auto line = [ & out](const char * label, uint64_t value) {
+                out << "  " << std::left << std::setw(28) << label << std::right << value << "\n";
+            };
+            out << "Pipeline statistics (mean per frame):\n";
+            line("input assembly vertices", average(statisticsSum.inputAssemblyVertices));
+            line("input assembly primitives", average(statisticsSum.inputAssemblyPrimitives));
+            line("vertex shader invocations", average(statisticsSum.vertexShaderInvocations));
+            line("clipping invocations", average(statisticsSum.clippingInvocations));
+            line("clipping primitives", average(statisticsSum.clippingPrimitives));
+            line("fragment shader invocations", average(statisticsSum.fragmentShaderInvocations));
+        }
+    }
+
+} // namespace impgine
\ No newline at end of file
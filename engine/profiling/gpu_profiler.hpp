@@ -0,0 +1,165 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "histogram.hpp"
+
+namespace impgine {
+
+    // GPU timings from timestamp queries. Every frame slot owns its own query
+    // pools, so a slot's results are read right after its in-flight fence has
+    // signaled and readback never waits on the GPU.
+    //
+    // Per frame: beginFrame() after vkBeginCommandBuffer, any number of
+    // (nested) scopes, endFrame() before vkEndCommandBuffer, and collect() once
+    // the frame's fence has been waited on. Scope names must be string
+    // literals or otherwise outlive the profiler.
+    class GpuProfiler {
+        public: static constexpr uint32_t MAX_SCOPES_PER_FRAME = 64;
+
+        // Counters from the optional pipeline statistics query
+        struct PipelineStatistics {
+            uint64_t inputAssemblyVertices = 0;
+            uint64_t inputAssemblyPrimitives = 0;
+            uint64_t vertexShaderInvocations = 0;
+            uint64_t clippingInvocations = 0;
+            uint64_t clippingPrimitives = 0;
+            uint64_t fragmentShaderInvocations = 0;
+        };
+
+        struct ScopeResult {
+            const char * name;
+            uint32_t depth;
+            // GPU clock, converted to nanoseconds
+            uint64_t beginNs;
+            uint64_t endNs;
+            double durationMs;
+        };
+
+        struct FrameResult {
+            uint64_t beginNs = 0;
+            uint64_t endNs = 0;
+            double totalMs = 0.0;
+            std::vector < ScopeResult > scopes;
+            bool hasPipelineStatistics = false;
+            PipelineStatistics pipelineStatistics;
+        };
+
+        // Scope that ends when it goes out of scope; a null profiler makes it a no-op
+        class Scope {
+            public: Scope(GpuProfiler * profiler, VkCommandBuffer commandBuffer,
+                const char * name);
+            ~Scope();
+
+            // Delete copy constructor and assignment operator
+            Scope(const Scope & ) = delete;
+            Scope & operator = (const Scope & ) = delete;
+
+            private: GpuProfiler * profiler;
+            VkCommandBuffer commandBuffer;
+            uint32_t index;
+        };
+
+        // `pipelineStatistics` needs the pipelineStatisticsQuery device feature enabled
+        GpuProfiler(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex,
+            uint32_t framesInFlight, bool pipelineStatistics);
+        ~GpuProfiler();
+
+        // Delete copy constructor and assignment operator
+        GpuProfiler(const GpuProfiler & ) = delete;
+        GpuProfiler & operator = (const GpuProfiler & ) = delete;
+
+        // False when the queue family has no timestamp support; every call is then a no-op
+        bool isSupported() const {
+            return !framePools.empty();
+        }
+        float getTimestampPeriod() const {
+            return timestampPeriod;
+        }
+
+        // Estimates steady_clock ns minus GPU ns by writing one timestamp and
+        // timing the round trip; the error is at most half of it. Blocks on the queue.
+        void calibrate(VkQueue queue, VkCommandPool commandPool);
+        bool isCalibrated() const {
+            return calibrated;
+        }
+        int64_t getCpuOffsetNs() const {
+            return cpuOffsetNs;
+        }
+
+        void beginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+        void endFrame(VkCommandBuffer commandBuffer);
+
+        // Returns an index for endScope, or NO_SCOPE when the frame is out of queries
+        uint32_t beginScope(VkCommandBuffer commandBuffer,
+            const char * name);
+        void endScope(VkCommandBuffer commandBuffer, uint32_t index);
+        static constexpr uint32_t NO_SCOPE = UINT32_MAX;
+
+        // Must bracket work outside a render pass or inside a single subpass
+        void beginPipelineStatistics(VkCommandBuffer commandBuffer);
+        void endPipelineStatistics(VkCommandBuffer commandBuffer);
+
+        // Reads the slot's results once its fence has signaled. Returns null if
+        // the slot holds no unread frame. With `accumulate` the frame is added
+        // to the statistics printed by report().
+        const FrameResult * collect(uint32_t frameIndex, bool accumulate = true);
+
+        const FrameResult & latestFrame() const {
+            return latest;
+        }
+        uint64_t droppedScopeCount() const {
+            return droppedScopes;
+        }
+
+        void resetStatistics();
+        void report(std::ostream & out) const;
+
+        private: struct ScopeRecord {
+            const char * name;
+            uint32_t depth;
+            uint32_t beginQuery;
+            uint32_t endQuery;
+        };
+
+        struct FramePool {
+            VkQueryPool timestamps = VK_NULL_HANDLE;
+            VkQueryPool statistics = VK_NULL_HANDLE;
+            std::vector < ScopeRecord > scopes;
+            uint32_t queryCount = 0;
+            bool statisticsWritten = false;
+            bool pending = false;
+        };
+
+        uint64_t toNanoseconds(uint64_t ticks) const;
+
+        VkDevice device;
+        float timestampPeriod = 0.0f;
+        uint64_t timestampMask = 0;
+        bool pipelineStatisticsEnabled;
+        bool calibrated = false;
+        int64_t cpuOffsetNs = 0;
+
+        std::vector < FramePool > framePools;
+        // Slot being recorded and the depth of the open scope stack
+        FramePool * recording = nullptr;
+        uint32_t scopeDepth = 0;
+        uint64_t droppedScopes = 0;
+
+        FrameResult latest;
+        Histogram frameHistogram;
+        // Keyed by name so repeated scopes (one per draw) share a histogram
+        std::map < std::string, Histogram > scopeHistograms;
+        std::vector < std::string > scopeOrder;
+        PipelineStatistics statisticsSum;
+        uint64_t statisticsFrames = 0;
+    };
+
+} // namespace impgine
\ No newline at end of file
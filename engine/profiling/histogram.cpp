@@ -0,0 +1,91 @@
+#include "histogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+namespace impgine {
+
+    int Histogram::bucketIndex(double microseconds) {
+        if (!(microseconds >= 1.0)) {
+            return 0;
+        }
+
+        int exponent;
+        double fraction = std::frexp(microseconds, & exponent); // [0.5, 1)
+        int octave = exponent - 1;
+        if (octave >= OCTAVES) {
+            return BUCKET_COUNT - 1;
+        }
+
+        int sub = static_cast < int > ((fraction * 2.0 - 1.0) * SUB_BUCKETS);
+        return 1 + octave * SUB_BUCKETS + std::min(sub, SUB_BUCKETS - 1);
+    }
+
+    double Histogram::bucketUpperBound(int index) {
+        if (index == 0) {
+            return 1.0;
+        }
+
+        int octave = (index - 1) / SUB_BUCKETS;
+        int sub = (index - 1) % SUB_BUCKETS;
+        return std::ldexp(1.0 + static_cast < double > (sub + 1) / SUB_BUCKETS, octave);
+    }
+
+    void Histogram::record(double microseconds) {
+        buckets[bucketIndex(microseconds)]++;
+
+        if (sampleCount == 0) {
+            minValue = maxValue = microseconds;
+        } else {
+            minValue = std::min(minValue, microseconds);
+            maxValue = std::max(maxValue, microseconds);
+        }
+        sum += microseconds;
+        sampleCount++;
+    }
+
+    void Histogram::reset() {
+        buckets.fill(0);
+        sampleCount = 0;
+        sum = 0.0;
+        minValue = maxValue = 0.0;
+    }
+
+    double Histogram::percentile(double p) const {
+        if (sampleCount == 0) {
+            return 0.0;
+        }
+
+        uint64_t rank = static_cast < uint64_t > (std::ceil(std::clamp(p, 0.0, 1.0) * sampleCount));
+        rank = std::max < uint64_t > (rank, 1);
+
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKET_COUNT; i++) {
+            seen += buckets[i];
+            if (seen >= rank) {
+                // The bucket edge can overshoot the largest real sample
+                return std::clamp(bucketUpperBound(i), minValue, maxValue);
+            }
+        }
+        return maxValue;
+    }
+
+    void Histogram::print(std::ostream & out,
+        const char * label) const {
+        auto ms = [](double us) {
+            return us / 1000.0;
+        };
+
+        out << std::fixed << std::setprecision(2) <<
+            std::left << std::setw(24) << label << std::right <<
+            " n=" << std::setw(6) << sampleCount <<
+            "  min " << std::setw(7) << ms(min()) <<
+            "  mean " << std::setw(7) << ms(mean()) <<
+            "  p50 " << std::setw(7) << ms(percentile(0.50)) <<
+            "  p95 " << std::setw(7) << ms(percentile(0.95)) <<
+            "  p99 " << std::setw(7) << ms(percentile(0.99)) <<
+            "  max " << std::setw(7) << ms(max()) << " ms\n";
+    }
+
+} // namespace impgine
\ No newline at end of file
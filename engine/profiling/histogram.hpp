@@ -0,0 +1,48 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+
+namespace impgine {
+
+    // Fixed-size log-linear histogram of durations in microseconds. Each power
+    // of two is split into SUB_BUCKETS linear buckets, which bounds the
+    // percentile error to 1 / SUB_BUCKETS while keeping record() allocation-free.
+    class Histogram {
+        public: static constexpr int SUB_BUCKETS = 8;
+        static constexpr int OCTAVES = 25; // 1us .. ~33s
+        static constexpr int BUCKET_COUNT = 1 + OCTAVES * SUB_BUCKETS;
+
+        void record(double microseconds);
+        void reset();
+
+        uint64_t count() const {
+            return sampleCount;
+        }
+        double min() const {
+            return sampleCount ? minValue : 0.0;
+        }
+        double max() const {
+            return sampleCount ? maxValue : 0.0;
+        }
+        double mean() const {
+            return sampleCount ? sum / static_cast < double > (sampleCount) : 0.0;
+        }
+        // p in [0, 1]; returns the upper edge of the bucket holding that rank
+        double percentile(double p) const;
+
+        void print(std::ostream & out,
+            const char * label) const;
+
+        private: static int bucketIndex(double microseconds);
+        static double bucketUpperBound(int index);
+
+        std::array < uint64_t, BUCKET_COUNT > buckets {};
+        uint64_t sampleCount = 0;
+        double sum = 0.0;
+        double minValue = 0.0;
+        double maxValue = 0.0;
+    };
+
+} // namespace impgine
\ No newline at end of file
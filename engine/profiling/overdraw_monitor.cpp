@@ -0,0 +1,75 @@
+#include "overdraw_monitor.hpp"
+
+#include <stdexcept>
+
+namespace impgine {
+
+    namespace {
+
+        constexpr double SMOOTHING = 0.2; // weight of the newest sample
+        // Turn the prepass back off only well below the threshold
+        constexpr double HYSTERESIS = 0.8;
+        constexpr uint64_t PROBE_INTERVAL = 120;
+
+    } // namespace
+
+    OverdrawMonitor::OverdrawMonitor(double threshold): threshold {
+        threshold
+    } {
+        if (!(threshold > 0.0)) {
+            throw std::runtime_error("invalid overdraw threshold!");
+        }
+    }
+
+    bool OverdrawMonitor::nextFrameUsesPrepass() {
+        if (!prepassEnabled) {
+            return false;
+        }
+        if (++framesSinceProbe >= PROBE_INTERVAL) {
+            framesSinceProbe = 0;
+            return false;
+        }
+        return true;
+    }
+
+    void OverdrawMonitor::record(uint64_t fragmentInvocations, uint64_t pixels, bool prepass) {
+        if (pixels == 0) {
+            return;
+        }
+
+        Totals & totals = prepass ? withPrepass : withoutPrepass;
+        totals.frames++;
+        totals.fragmentInvocations += fragmentInvocations;
+        totals.pixels += pixels;
+        if (prepass) {
+            return;
+        }
+
+        double overdraw = static_cast < double > (fragmentInvocations) / static_cast < double > (pixels);
+        smoothedOverdraw = withoutPrepass.frames == 1 ? overdraw : smoothedOverdraw + SMOOTHING * (overdraw - smoothedOverdraw);
+        if (smoothedOverdraw > threshold) {
+            prepassEnabled = true;
+        } else if (smoothedOverdraw < threshold * HYSTERESIS) {
+            prepassEnabled = false;
+        }
+    }
+
+    void OverdrawMonitor::printTotals(std::ostream & out, const char * label, const Totals & totals) {
+        out << "  " << label << ": ";
+        if (totals.frames == 0) {
+            out << "no frames\n";
+            return;
+        }
+        double frames = static_cast < double > (totals.frames);
+        out << totals.frames << " frames, " <<
+            static_cast < double > (totals.fragmentInvocations) / frames << " fragment invocations/frame, " <<
+            static_cast < double > (totals.fragmentInvocations) / static_cast < double > (totals.pixels) << "x overdraw\n";
+    }
+
+    void OverdrawMonitor::report(std::ostream & out) const {
+        out << "Overdraw (threshold " << threshold << "x):\n";
+        printTotals(out, "without prepass", withoutPrepass);
+        printTotals(out, "with prepass", withPrepass);
+    }
+
+} // namespace impgine
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+
+namespace impgine {
+
+    // Measures overdraw from pipeline statistics, as fragment shader
+    // invocations per rendered pixel, separately for frames drawn with and
+    // without the depth prepass, and decides when the prepass pays off.
+    // Frames with the prepass shade each visible pixel about once, so while it
+    // is on an occasional probe frame runs without it to keep measuring.
+    class OverdrawMonitor {
+        public: explicit OverdrawMonitor(double threshold);
+
+        // Call once per recorded frame in automatic mode
+        bool nextFrameUsesPrepass();
+
+        // Feed a collected frame's counters; `pixels` is the area it rendered
+        void record(uint64_t fragmentInvocations, uint64_t pixels, bool prepass);
+
+        // Smoothed overdraw of frames without the prepass; 0 until one is measured
+        double getOverdraw() const {
+            return smoothedOverdraw;
+        }
+
+        void report(std::ostream & out) const;
+
+        private: struct Totals {
+            uint64_t frames = 0;
+            uint64_t fragmentInvocations = 0;
+            uint64_t pixels = 0;
+        };
+
+        static void printTotals(std::ostream & out, const char * label, const Totals & totals);
+
+        double threshold;
+        bool prepassEnabled = false;
+        uint64_t framesSinceProbe = 0;
+        double smoothedOverdraw = 0.0;
+        Totals withPrepass;
+        Totals withoutPrepass;
+    };
+
+} // namespace impgine
\ No newline at end of file
@@ -0,0 +1,209 @@
+#include "stall_tracker.hpp"
+
+#include <iostream>
+#include <string>
+
+namespace impgine {
+
+    namespace {
+
+        // Stalls of the current frame on this thread, cleared by endFrame()
+        thread_local std::array < StallTracker::Clock::duration,
+            static_cast < size_t > (StallCategory::Count) > frameStalls {};
+
+        int64_t toNanoseconds(StallTracker::Clock::time_point time) {
+            return std::chrono::duration_cast < std::chrono::nanoseconds > (time.time_since_epoch()).count();
+        }
+
+        double toMilliseconds(StallTracker::Clock::duration duration) {
+            return std::chrono::duration < double, std::milli > (duration).count();
+        }
+
+    } // namespace
+
+    StallTracker::Scope::Scope(StallTracker * tracker, StallCategory category,
+        const char * site): tracker {
+        tracker
+    }, category {
+        category
+    }, site {
+        site
+    }, watchSlot {
+        -1
+    }, start {
+        Clock::now()
+    } {
+        if (tracker) {
+            watchSlot = tracker -> claimWatchSlot(site, start);
+        }
+    }
+
+    StallTracker::Scope::~Scope() {
+        if (tracker) {
+            Clock::duration duration = Clock::now() - start;
+            tracker -> releaseWatchSlot(watchSlot, duration);
+            tracker -> record(category, site, duration);
+        }
+    }
+
+    StallTracker::StallTracker(double watchdogThresholdMs): watchdogThreshold {
+        std::chrono::duration_cast < Clock::duration > (std::chrono::duration < double, std::milli > (watchdogThresholdMs))
+    } {
+        if (watchdogThreshold > Clock::duration::zero()) {
+            watchdog = std::thread( & StallTracker::watchdogLoop, this);
+        }
+    }
+
+    StallTracker::~StallTracker() {
+        if (watchdog.joinable()) {
+            {
+                std::lock_guard < std::mutex > lock(watchdogMutex);
+                stopping = true;
+            }
+            watchdogWake.notify_all();
+            watchdog.join();
+        }
+    }
+
+    void StallTracker::record(StallCategory category,
+        const char * site, Clock::duration duration) {
+        (void) site;
+        size_t index = static_cast < size_t > (category);
+        frameStalls[index] += duration;
+
+        std::lock_guard < std::mutex > lock(mutex);
+        double microseconds = std::chrono::duration < double, std::micro > (duration).count();
+        histograms[index].record(microseconds);
+        totalUs[index] += microseconds;
+    }
+
+    void StallTracker::endFrame(Clock::duration frameTime) {
+        auto stalled = [](StallCategory category) {
+            return frameStalls[static_cast < size_t > (category)];
+        };
+        Clock::duration gpuWait = stalled(StallCategory::FramePacing);
+        Clock::duration syncWait = stalled(StallCategory::Acquire) + stalled(StallCategory::Present);
+        frameStalls.fill(Clock::duration::zero());
+
+        std::lock_guard < std::mutex > lock(mutex);
+        if (gpuWait * 2 > frameTime) {
+            gpuBoundFrames++;
+        } else if (syncWait * 2 > frameTime) {
+            syncBoundFrames++;
+        } else {
+            cpuBoundFrames++;
+        }
+    }
+
+    double StallTracker::totalMilliseconds(StallCategory category) const {
+        std::lock_guard < std::mutex > lock(mutex);
+        return totalUs[static_cast < size_t > (category)] / 1000.0;
+    }
+
+    int StallTracker::claimWatchSlot(const char * site, Clock::time_point start) {
+        if (!watchdog.joinable()) {
+            return -1;
+        }
+
+        for (size_t i = 0; i < WATCH_SLOTS; i++) {
+            bool expected = false;
+            WatchSlot & slot = watchSlots[i];
+            // Own the slot before touching it, then publish the site ahead of the
+            // start time the watchdog keys on
+            if (!slot.busy.load(std::memory_order_relaxed) &&
+                slot.busy.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                slot.site.store(site, std::memory_order_release);
+                slot.startNs.store(toNanoseconds(start), std::memory_order_release);
+                return static_cast < int > (i);
+            }
+        }
+        return -1; // more concurrent waits than slots; this one goes unwatched
+    }
+
+    void StallTracker::releaseWatchSlot(int slot, Clock::duration duration) {
+        if (slot < 0) {
+            return;
+        }
+
+        WatchSlot & watch = watchSlots[slot];
+        if (watch.reportedNs.load(std::memory_order_acquire) == watch.startNs.load(std::memory_order_relaxed)) {
+            std::cerr << "stall watchdog: " << watch.site.load(std::memory_order_relaxed) <<
+                " finally returned after " << toMilliseconds(duration) << " ms" << std::endl;
+        }
+        watch.startNs.store(0, std::memory_order_relaxed);
+        watch.busy.store(false, std::memory_order_release);
+    }
+
+    void StallTracker::watchdogLoop() {
+        std::unique_lock < std::mutex > lock(watchdogMutex);
+        while (!stopping) {
+            // Poll at a fraction of the threshold so a stall is caught soon after crossing it
+            watchdogWake.wait_for(lock, watchdogThreshold / 4, [this]() {
+                return stopping;
+            });
+
+            int64_t now = toNanoseconds(Clock::now());
+            int64_t threshold = std::chrono::duration_cast < std::chrono::nanoseconds > (watchdogThreshold).count();
+            for (auto & slot: watchSlots) {
+                int64_t start = slot.startNs.load(std::memory_order_acquire);
+                if (start == 0 || now - start < threshold || slot.reportedNs.load(std::memory_order_relaxed) == start) {
+                    continue;
+                }
+
+                // The slot may have been released and reclaimed since startNs was
+                // read; a later owner's site comes with its cleared startNs, so
+                // the site is only reported if the slot still holds that wait
+                const char * site = slot.site.load(std::memory_order_acquire);
+                if (slot.startNs.load(std::memory_order_relaxed) != start) {
+                    continue;
+                }
+                slot.reportedNs.store(start, std::memory_order_release);
+                std::cerr << "stall watchdog: " << site <<
+                    " blocked for " << (now - start) / 1000000 << " ms and counting" << std::endl;
+            }
+        }
+    }
+
+    const char * StallTracker::categoryName(StallCategory category) {
+        switch (category) {
+        case StallCategory::FramePacing:
+            return "frame pacing";
+        case StallCategory::Acquire:
+            return "acquire";
+        case StallCategory::Present:
+            return "present";
+        case StallCategory::Upload:
+            return "upload";
+        case StallCategory::Resize:
+            return "resize";
+        case StallCategory::Shutdown:
+            return "shutdown";
+        default:
+            return "unknown";
+        }
+    }
+
+    void StallTracker::report(std::ostream & out) const {
+        std::lock_guard < std::mutex > lock(mutex);
+
+        out << "Blocking waits:\n";
+        for (size_t i = 0; i < CATEGORY_COUNT; i++) {
+            if (histograms[i].count() == 0) {
+                continue;
+            }
+            std::string label = std::string("  ") + categoryName(static_cast < StallCategory > (i));
+            histograms[i].print(out, label.c_str());
+        }
+
+        uint64_t frames = gpuBoundFrames + syncBoundFrames + cpuBoundFrames;
+        if (frames > 0) {
+            auto percent = [frames](uint64_t count) {
+                return 100.0 * static_cast < double > (count) / static_cast < double > (frames);
+            };
+            out << "  frames: " << percent(gpuBoundFrames) << "% GPU bound, " <<
+                percent(syncBoundFrames) << "% sync bound, " <<
+                percent(cpuBoundFrames) << "% CPU bound\n";
+        }
+    }
+
+} // namespace impgine
\ No newline at end of file
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <thread>
+
+#include "histogram.hpp"
+
+namespace impgine {
+
+    enum class StallCategory {
+        FramePacing, // in-flight fence: waiting for the GPU to finish an older frame
+        Acquire, // vkAcquireNextImageKHR and the per-image fence behind it
+        Present, // vkQueuePresentKHR, blocks under FIFO when the queue is full
+        Upload, // one-off transfers the CPU waits for (readback, clock calibration)
+        Resize, // waiting for a minimized window to come back
+        Shutdown, // device idle before teardown
+        Count
+    };
+
+    // Times every blocking Vulkan call, grouped by why the CPU was waiting.
+    // Per frame, the stall breakdown decides whether the frame was GPU bound
+    // (fence wait dominates), sync bound (acquire/present dominate) or CPU
+    // bound (little waiting at all).
+    //
+    // With a watchdog threshold set, a background thread also reports any wait
+    // that is still blocked past the threshold, so hangs show up while they
+    // happen rather than after.
+    class StallTracker {
+        public: using Clock = std::chrono::steady_clock;
+
+        // Wraps one blocking call; a null tracker makes it a no-op
+        class Scope {
+            public: Scope(StallTracker * tracker, StallCategory category,
+                const char * site);
+            ~Scope();
+
+            // Delete copy constructor and assignment operator
+            Scope(const Scope & ) = delete;
+            Scope & operator = (const Scope & ) = delete;
+
+            private: StallTracker * tracker;
+            StallCategory category;
+            const char * site;
+            int watchSlot;
+            Clock::time_point start;
+        };
+
+        // 0 disables the watchdog
+        explicit StallTracker(double watchdogThresholdMs = 0.0);
+        ~StallTracker();
+
+        // Delete copy constructor and assignment operator
+        StallTracker(const StallTracker & ) = delete;
+        StallTracker & operator = (const StallTracker & ) = delete;
+
+        void record(StallCategory category,
+            const char * site, Clock::duration duration);
+        // Classifies the frame from the stalls recorded on this thread since the last call
+        void endFrame(Clock::duration frameTime);
+
+        const Histogram & getHistogram(StallCategory category) const {
+            return histograms[static_cast < size_t > (category)];
+        }
+        double totalMilliseconds(StallCategory category) const;
+
+        void report(std::ostream & out) const;
+
+        static const char * categoryName(StallCategory category);
+
+        private: static constexpr size_t CATEGORY_COUNT = static_cast < size_t > (StallCategory::Count);
+        static constexpr size_t WATCH_SLOTS = 8;
+
+        // A wait in progress as seen by the watchdog. `busy` is the claim; the
+        // watchdog only looks at slots whose startNs is set, i.e. fully published.
+        // reportedNs is the startNs of the wait it last reported, so a report
+        // racing with the slot's reuse can't be pinned on the next wait
+        struct WatchSlot {
+            std::atomic < bool > busy {
+                false
+            };
+            std::atomic < int64_t > startNs {
+                0
+            };
+            std::atomic < const char * > site {
+                nullptr
+            };
+            std::atomic < int64_t > reportedNs {
+                0
+            };
+        };
+
+        int claimWatchSlot(const char * site, Clock::time_point start);
+        void releaseWatchSlot(int slot, Clock::duration duration);
+        void watchdogLoop();
+
+        mutable std::mutex mutex;
+        std::array < Histogram, CATEGORY_COUNT > histograms;
+        std::array < double, CATEGORY_COUNT > totalUs {};
+
+        // Frame classification
+        uint64_t gpuBoundFrames = 0;
+        uint64_t syncBoundFrames = 0;
+        uint64_t cpuBoundFrames = 0;
+
+        Clock::duration watchdogThreshold;
+        std::array < WatchSlot, WATCH_SLOTS > watchSlots;
+        std::thread watchdog;
+        std::mutex watchdogMutex;
+        std::condition_variable watchdogWake;
+        bool stopping = false;
+    };
+
+} // namespace impgine
\ No newline at end of file
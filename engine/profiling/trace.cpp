@@ -0,0 +1,152 @@
+#include "trace.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace impgine {
+
+    namespace {
+
+        struct Event {
+            const char * name;
+            uint64_t beginNs;
+            uint64_t endNs;
+        };
+
+        // Written by one thread only; `written` publishes each event
+        struct ThreadBuffer {
+            std::vector < Event > events;
+            std::atomic < uint64_t > written {
+                0
+            };
+            const char * name = nullptr;
+            uint32_t trackId = 0;
+        };
+
+        struct Registry {
+            std::mutex mutex;
+            std::vector < std::unique_ptr < ThreadBuffer >> buffers;
+        };
+
+        Registry & registry() {
+            static Registry instance;
+            return instance;
+        }
+
+        // Buffers outlive their threads so zones of finished threads still export
+        ThreadBuffer * registerBuffer(const char * name) {
+            auto buffer = std::make_unique < ThreadBuffer > ();
+            buffer -> events.resize(Trace::EVENTS_PER_THREAD);
+            buffer -> name = name;
+
+            Registry & reg = registry();
+            std::lock_guard < std::mutex > lock(reg.mutex);
+            buffer -> trackId = static_cast < uint32_t > (reg.buffers.size() + 1);
+            reg.buffers.push_back(std::move(buffer));
+            return reg.buffers.back().get();
+        }
+
+        ThreadBuffer * threadBuffer() {
+            thread_local ThreadBuffer * buffer = registerBuffer(nullptr);
+            return buffer;
+        }
+
+        void append(ThreadBuffer & buffer,
+            const char * name, uint64_t beginNs, uint64_t endNs) {
+            uint64_t index = buffer.written.load(std::memory_order_relaxed);
+            buffer.events[index % Trace::EVENTS_PER_THREAD] = {
+                name, beginNs, endNs
+            };
+            buffer.written.store(index + 1, std::memory_order_release);
+        }
+
+        void writeEscaped(std::ostream & out,
+            const char * text) {
+            for (; * text != '\0'; text++) {
+                if ( * text == '"' || * text == '\\') {
+                    out << '\\';
+                }
+                out << * text;
+            }
+        }
+
+    } // namespace
+
+    void Trace::setThreadName(const char * name) {
+        threadBuffer() -> name = name;
+    }
+
+    void Trace::recordZone(const char * name, uint64_t beginNs, uint64_t endNs) {
+        append( * threadBuffer(), name, beginNs, endNs);
+    }
+
+    void Trace::recordGpuZone(const char * name, uint64_t beginNs, uint64_t endNs) {
+        // Only the thread collecting GPU results writes here
+        static ThreadBuffer * gpuBuffer = registerBuffer("GPU");
+        append( * gpuBuffer, name, beginNs, endNs);
+    }
+
+    void Trace::writeChromeTrace(const std::string & filepath) {
+        std::ofstream file(filepath);
+        if (!file) {
+            throw std::runtime_error("failed to open " + filepath + " for writing!");
+        }
+
+        Registry & reg = registry();
+        std::lock_guard < std::mutex > lock(reg.mutex);
+
+        // Timestamps are relative to the earliest zone to keep the numbers small
+        uint64_t origin = UINT64_MAX;
+        for (const auto & buffer: reg.buffers) {
+            uint64_t written = buffer -> written.load(std::memory_order_acquire);
+            uint64_t first = written > EVENTS_PER_THREAD ? written - EVENTS_PER_THREAD : 0;
+            for (uint64_t i = first; i < written; i++) {
+                origin = std::min(origin, buffer -> events[i % EVENTS_PER_THREAD].beginNs);
+            }
+        }
+
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        bool firstEvent = true;
+        auto separator = [ & ]() {
+            if (!firstEvent) {
+                file << ",\n";
+            }
+            firstEvent = false;
+        };
+
+        file.setf(std::ios::fixed);
+        file.precision(3);
+        for (const auto & buffer: reg.buffers) {
+            separator();
+            file << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << buffer -> trackId << ",\"args\":{\"name\":\"";
+            if (buffer -> name != nullptr) {
+                writeEscaped(file, buffer -> name);
+            } else {
+                file << "thread " << buffer -> trackId;
+            }
+            file << "\"}}";
+
+            uint64_t written = buffer -> written.load(std::memory_order_acquire);
+            uint64_t first = written > EVENTS_PER_THREAD ? written - EVENTS_PER_THREAD : 0;
+            for (uint64_t i = first; i < written; i++) {
+                const Event & event = buffer -> events[i % EVENTS_PER_THREAD];
+                separator();
+                file << "{\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer -> trackId << ",\"name\":\"";
+                writeEscaped(file, event.name);
+                file << "\",\"ts\":" << static_cast < double > (event.beginNs - origin) / 1000.0 <<
+                    ",\"dur\":" << static_cast < double > (event.endNs - event.beginNs) / 1000.0 << "}";
+            }
+        }
+        file << "\n]}\n";
+
+        if (!file) {
+            throw std::runtime_error("failed to write " + filepath + "!");
+        }
+    }
+
+} // namespace impgine
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace impgine {
+
+    // CPU zone tracing exported as Chrome trace JSON (chrome://tracing, Perfetto).
+    //
+    // Each thread appends completed zones to its own fixed-size ring, so
+    // recording takes no lock and never allocates after the first zone on a
+    // thread; when a ring wraps the oldest zones are overwritten. Zones are
+    // recorded through the IMPGINE_TRACE_* macros below, which compile to
+    // nothing unless IMPGINE_ENABLE_TRACING is defined.
+    //
+    // GPU zones can be added on a separate track once converted to the same
+    // clock (see GpuProfiler::getCpuOffsetNs).
+    class Trace {
+        public: using Clock = std::chrono::steady_clock;
+        static constexpr size_t EVENTS_PER_THREAD = 1 << 16;
+
+        // Nanoseconds on Clock, the timebase of every recorded zone
+        static uint64_t nowNs() {
+            return static_cast < uint64_t > (std::chrono::duration_cast < std::chrono::nanoseconds > (
+                Clock::now().time_since_epoch()).count());
+        }
+
+        // Names must outlive the trace (string literals, __func__)
+        static void setThreadName(const char * name);
+        static void recordZone(const char * name, uint64_t beginNs, uint64_t endNs);
+        static void recordGpuZone(const char * name, uint64_t beginNs, uint64_t endNs);
+
+        // Call while traced threads are idle or joined; a ring being written
+        // to during the export may yield a torn zone
+        static void writeChromeTrace(const std::string & filepath);
+
+        class Zone {
+            public: explicit Zone(const char * name): name {
+                name
+            }, beginNs {
+                nowNs()
+            } {}
+            ~Zone() {
+                recordZone(name, beginNs, nowNs());
+            }
+
+            // Delete copy constructor and assignment operator
+            Zone(const Zone & ) = delete;
+            Zone & operator = (const Zone & ) = delete;
+
+            private: const char * name;
+            uint64_t beginNs;
+        };
+    };
+
+} // namespace impgine
+
+#define IMPGINE_TRACE_CONCAT_INNER(a, b) a##b
+#define IMPGINE_TRACE_CONCAT(a, b) IMPGINE_TRACE_CONCAT_INNER(a, b)
+
+#ifdef IMPGINE_ENABLE_TRACING
+#define IMPGINE_TRACE_SCOPE(name) ::impgine::Trace::Zone IMPGINE_TRACE_CONCAT(traceZone, __LINE__) {name}
+#define IMPGINE_TRACE_FUNCTION() IMPGINE_TRACE_SCOPE(__func__)
+#define IMPGINE_TRACE_THREAD(name) ::impgine::Trace::setThreadName(name)
+#else
+#define IMPGINE_TRACE_SCOPE(name) static_cast < void > (0)
+#define IMPGINE_TRACE_FUNCTION() static_cast < void > (0)
+#define IMPGINE_TRACE_THREAD(name) static_cast < void > (0)
+#endif
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include "snapshot_queue.hpp"
+
+#include <chrono>
+#include <utility>
+
+namespace impgine {
+
+    void SnapshotQueue::setLossless(bool lossless) {
+        std::lock_guard < std::mutex > lock(mutex);
+        maxPending = lossless ? CAPACITY : 1;
+    }
+
+    bool SnapshotQueue::push(FrameSnapshot && snapshot) {
+        std::unique_lock < std::mutex > lock(mutex);
+        notFull.wait(lock, [this]() {
+            return count < maxPending || closed;
+        });
+        if (closed) {
+            return false;
+        }
+
+        Slot & slot = slots[(head + count) % CAPACITY];
+        slot.snapshot = std::move(snapshot);
+        slot.publishTime = Clock::now();
+        count++;
+
+        lock.unlock();
+        notEmpty.notify_one();
+        return true;
+    }
+
+    bool SnapshotQueue::pop(FrameSnapshot & snapshot) {
+        std::unique_lock < std::mutex > lock(mutex);
+        notEmpty.wait(lock, [this]() {
+            return count > 0 || closed;
+        });
+        if (count == 0) {
+            return false;
+        }
+
+        depthSamples[count]++;
+
+        Slot & oldest = slots[head];
+        snapshot = std::move(oldest.snapshot);
+        handoffLatencyUs.record(
+            std::chrono::duration < double, std::micro > (Clock::now() - oldest.publishTime).count());
+
+        head = (head + 1) % CAPACITY;
+        count--;
+
+        lock.unlock();
+        notFull.notify_one();
+        return true;
+    }
+
+    void SnapshotQueue::close() {
+        {
+            std::lock_guard < std::mutex > lock(mutex);
+            closed = true;
+        }
+        notEmpty.notify_all();
+        notFull.notify_all();
+    }
+
+    void SnapshotQueue::report(std::ostream & out) const {
+        out << "Render thread handoff (" << handoffLatencyUs.count() << " frames)\n";
+        handoffLatencyUs.print(out, "  publish -> consume");
+
+        out << "  queue depth at consume:";
+        for (size_t depth = 1; depth <= CAPACITY; depth++) {
+            out << "  " << depth << ": " << depthSamples[depth];
+        }
+        out << "\n";
+    }
+
+} // namespace impgine
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+
+#include "frame_snapshot.hpp"
+#include "profiling/histogram.hpp"
+
+namespace impgine {
+
+    // Hands frame snapshots from the simulation thread to the render thread
+    // through three fixed slots, oldest first; none is ever dropped, so every
+    // produced snapshot is a rendered frame. By default the producer may only
+    // be one snapshot ahead, which paces it to the consumer and keeps input
+    // latency to a frame. Lossless runs (a frame limit, a camera path, a
+    // capture) let it fill every slot instead, so short stalls don't stop it.
+    class SnapshotQueue {
+        public: static constexpr size_t CAPACITY = 3;
+        using Clock = FrameLatencyTracker::Clock;
+
+        SnapshotQueue() = default;
+
+        // Delete copy constructor and assignment operator
+        SnapshotQueue(const SnapshotQueue & ) = delete;
+        SnapshotQueue & operator = (const SnapshotQueue & ) = delete;
+
+        // Call before either thread uses the queue
+        void setLossless(bool lossless);
+
+        // Blocks while the producer is as far ahead as allowed; returns false
+        // once the queue is closed
+        bool push(FrameSnapshot && snapshot);
+        // Blocks until a snapshot is available; returns false once closed and drained
+        bool pop(FrameSnapshot & snapshot);
+        // Wakes both sides; further pushes are rejected
+        void close();
+
+        // Publish -> consume time of every snapshot
+        const Histogram & handoffLatency() const {
+            return handoffLatencyUs;
+        }
+        // How many snapshots were pending each time the consumer popped
+        const std::array < uint64_t, CAPACITY + 1 > & depthCounts() const {
+            return depthSamples;
+        }
+
+        // Call after both threads are done with the queue
+        void report(std::ostream & out) const;
+
+        private: struct Slot {
+            FrameSnapshot snapshot;
+            Clock::time_point publishTime;
+        };
+
+        std::mutex mutex;
+        std::condition_variable notEmpty;
+        std::condition_variable notFull;
+        std::array < Slot, CAPACITY > slots;
+        size_t head = 0;
+        size_t count = 0;
+        size_t maxPending = 1;
+        bool closed = false;
+
+        Histogram handoffLatencyUs;
+        std::array < uint64_t, CAPACITY + 1 > depthSamples {};
+    };
+
+} // namespace impgine
\ No newline at end of file
@@ -0,0 +1,23 @@
+#version 450
+
+// Depth prepass: the same transform as shader.vert over the position-only
+// stream. Both declare gl_Position invariant so the main pass's EQUAL depth
+// test sees bit-identical depths
+layout(binding = 0) uniform UniformBufferObject {
+    mat4 view;
+    mat4 proj;
+} ubo;
+
+layout(push_constant) uniform Push {
+    mat4 model;
+    uint objectIndex;
+    uint materialIndex;
+} push;
+
+layout(location = 0) in vec3 inPosition;
+
+invariant gl_Position;
+
+void main() {
+    gl_Position = ubo.proj * ubo.view * push.model * vec4(inPosition, 1.0);
+}
\ No newline at end of file
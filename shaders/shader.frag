@@ -1,12 +1,148 @@
 #version 450
 
-layout(binding = 1) uniform sampler2D texSampler;
+// Also compiled with -DBINDLESS to frag_bindless.spv, which picks the texture
+// from one array in set 3 instead of a set per texture. The build does both
+// when it finds glslc; by hand:
+//     glslc shaders/shader.frag -o shaders/frag.spv
+//     glslc -DBINDLESS shaders/shader.frag -o shaders/frag_bindless.spv
+#ifdef BINDLESS
+#extension GL_EXT_nonuniform_qualifier : require
+#endif
+
+// Must match LightCulling and ShadowMaps
+const uint CLUSTER_COUNT = 16 * 9 * 24;
+const uint MAX_LIGHTS_PER_CLUSTER = 128;
+const uint CASCADE_COUNT = 4;
+
+const vec3 AMBIENT = vec3(0.05);
+
+struct PointLight {
+    vec4 positionRadius;
+    vec4 colorIntensity;
+};
+
+layout(push_constant) uniform Push {
+    mat4 model;
+    uint objectIndex;
+    uint materialIndex;
+    uint textureIndex; // slot in the bindless array
+    vec4 baseColor;
+} push;
+
+#ifdef BINDLESS
+// Must match BindlessTextures; the index is uniform per draw
+layout(set = 3, binding = 0) uniform sampler textureSampler;
+layout(set = 3, binding = 1) uniform texture2D textures[];
+#else
+layout(set = 3, binding = 0) uniform sampler2D texSampler;
+#endif
+
+layout(set = 1, binding = 0) uniform LightingParams {
+    mat4 view;
+    mat4 inverseProjection;
+    vec4 cameraPosition;
+    uvec4 gridSize; // w = light count
+    vec4 screen; // render width, render height, near, far
+} lighting;
+
+layout(std430, set = 1, binding = 1) readonly buffer Lights {
+    PointLight lights[];
+};
+
+layout(std430, set = 1, binding = 2) readonly buffer Clusters {
+    uint lightCounts[CLUSTER_COUNT];
+    uint lightIndices[];
+};
+
+layout(set = 2, binding = 0) uniform SunParams {
+    mat4 cascadeViewProjections[CASCADE_COUNT];
+    vec4 cascadeSplits; // view depth at which each cascade ends
+    vec4 lightDirection; // w = 1 when casting shadows
+    vec4 lightColor;
+} sun;
+
+layout(set = 2, binding = 1) uniform sampler2DArrayShadow shadowMaps;
 
 layout(location = 0) in vec3 fragColor;
 layout(location = 1) in vec2 fragTexCoord;
+layout(location = 2) in vec3 fragWorldPosition;
+layout(location = 3) in float fragViewDepth;
+layout(location = 4) in vec3 fragNormal;
 
 layout(location = 0) out vec4 outColor;
 
+// Inverse square, windowed to reach zero at the radius the culling tested against
+float attenuation(float distance, float radius) {
+    float ratio = distance / radius;
+    float window = clamp(1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0);
+    return window * window / (distance * distance + 1.0);
+}
+
+// Fraction of the sun reaching this point: 3x3 taps of the hardware-filtered
+// comparison from the cascade covering this depth
+float sunVisibility() {
+    if (sun.lightDirection.w == 0.0 || fragViewDepth > sun.cascadeSplits[CASCADE_COUNT - 1]) {
+        return 1.0;
+    }
+
+    uint cascade = 0;
+    while (cascade < CASCADE_COUNT - 1 && fragViewDepth > sun.cascadeSplits[cascade]) {
+        cascade++;
+    }
+    vec4 shadowPosition = sun.cascadeViewProjections[cascade] * vec4(fragWorldPosition, 1.0);
+    vec2 uv = shadowPosition.xy * 0.5 + 0.5;
+    vec2 texelSize = 1.0 / vec2(textureSize(shadowMaps, 0).xy);
+
+    float visibility = 0.0;
+    for (int y = -1; y <= 1; y++) {
+        for (int x = -1; x <= 1; x++) {
+            visibility += texture(shadowMaps, vec4(uv + vec2(x, y) * texelSize, float(cascade), shadowPosition.z));
+        }
+    }
+    return visibility / 9.0;
+}
+
 void main() {
-    outColor = texture(texSampler, fragTexCoord);
+#ifdef BINDLESS
+    vec4 albedo = texture(sampler2D(textures[push.textureIndex], textureSampler), fragTexCoord) * push.baseColor;
+#else
+    vec4 albedo = texture(texSampler, fragTexCoord) * push.baseColor;
+#endif
+
+    vec3 normal = normalize(fragNormal);
+
+    // The vertex color holds baked ambient occlusion (white when not baked)
+    float occlusion = fragColor.x;
+
+    // Without lights the scene stays unlit
+    if (lighting.gridSize.w == 0 && sun.lightColor.rgb == vec3(0.0)) {
+        outColor = vec4(albedo.rgb * occlusion, albedo.a);
+        return;
+    }
+
+    vec3 light = AMBIENT * occlusion;
+    if (sun.lightColor.rgb != vec3(0.0)) {
+        light += sun.lightColor.rgb * max(dot(normal, -sun.lightDirection.xyz), 0.0) * sunVisibility();
+    }
+
+    // The clusters are stale while there are no point lights
+    if (lighting.gridSize.w > 0) {
+        uvec3 grid = lighting.gridSize.xyz;
+        uvec2 tile = min(uvec2(gl_FragCoord.xy / lighting.screen.xy * vec2(grid.xy)), grid.xy - 1);
+        float near = lighting.screen.z;
+        float far = lighting.screen.w;
+        float slice = log(fragViewDepth / near) / log(far / near) * float(grid.z);
+        uint clusterIndex = tile.x + grid.x * (tile.y + grid.y * uint(clamp(slice, 0.0, float(grid.z - 1))));
+
+        uint count = lightCounts[clusterIndex];
+        for (uint i = 0; i < count; i++) {
+            PointLight pointLight = lights[lightIndices[clusterIndex * MAX_LIGHTS_PER_CLUSTER + i]];
+            vec3 toLight = pointLight.positionRadius.xyz - fragWorldPosition;
+            float distance = length(toLight);
+            float diffuse = max(dot(normal, toLight / max(distance, 1e-4)), 0.0);
+            light += pointLight.colorIntensity.rgb * pointLight.colorIntensity.w * diffuse *
+                attenuation(distance, pointLight.positionRadius.w);
+        }
+    }
+    outColor = vec4(albedo.rgb * light, albedo.a);
 }
\ No newline at end of file
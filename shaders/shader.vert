@@ -1,20 +1,40 @@
 #version 450
 
 layout(binding = 0) uniform UniformBufferObject {
-    mat4 model;
     mat4 view;
     mat4 proj;
 } ubo;
 
+layout(push_constant) uniform Push {
+    mat4 model;
+    uint objectIndex;
+    uint materialIndex;
+} push;
+
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
 layout(location = 2) in vec2 inTexCoord;
+layout(location = 3) in vec3 inNormal;
+layout(location = 4) in vec4 inTangent;
 
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) out vec3 fragWorldPosition;
+layout(location = 3) out float fragViewDepth;
+layout(location = 4) out vec3 fragNormal;
+
+// Must match depth.vert exactly for the prepass's EQUAL depth test
+invariant gl_Position;
 
 void main() {
-    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 1.0);
+    gl_Position = ubo.proj * ubo.view * push.model * vec4(inPosition, 1.0);
     fragColor = inColor;
     fragTexCoord = inTexCoord;
+
+    // Separate from gl_Position, whose expression has to stay identical to depth.vert's
+    vec4 worldPosition = push.model * vec4(inPosition, 1.0);
+    fragWorldPosition = worldPosition.xyz;
+    fragViewDepth = -(ubo.view * worldPosition).z;
+    // Models are only rotated, translated and uniformly scaled
+    fragNormal = mat3(push.model) * inNormal;
 }
\ No newline at end of file
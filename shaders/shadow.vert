@@ -0,0 +1,12 @@
+#version 450
+
+// Shadow map depth; the cascade's light matrix is premultiplied into the model's
+layout(push_constant) uniform Push {
+    mat4 lightTransform;
+} push;
+
+layout(location = 0) in vec3 inPosition;
+
+void main() {
+    gl_Position = push.lightTransform * vec4(inPosition, 1.0);
+}
\ No newline at end of file
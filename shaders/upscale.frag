@@ -0,0 +1,57 @@
+#version 450
+
+// Lanczos-2 upscale of the top-left renderSize corner of the scene image
+layout(binding = 0) uniform sampler2D sceneColor;
+
+layout(push_constant) uniform Push {
+    vec2 renderSize;
+} push;
+
+layout(location = 0) in vec2 fragUv;
+
+layout(location = 0) out vec4 outColor;
+
+const float PI = 3.14159265;
+
+float lanczos2(float x) {
+    x = abs(x);
+    if (x < 1e-5) {
+        return 1.0;
+    }
+    if (x >= 2.0) {
+        return 0.0;
+    }
+    float px = PI * x;
+    return 2.0 * sin(px) * sin(px * 0.5) / (px * px);
+}
+
+void main() {
+    // Texel centers sit at integer coordinates in this space
+    vec2 position = fragUv * push.renderSize - 0.5;
+    vec2 base = floor(position);
+    vec2 f = position - base;
+    ivec2 maxTexel = ivec2(push.renderSize) - 1;
+
+    vec3 sum = vec3(0.0);
+    float weightSum = 0.0;
+    vec3 minColor = vec3(1.0e9);
+    vec3 maxColor = vec3(-1.0e9);
+    for (int y = -1; y <= 2; y++) {
+        float wy = lanczos2(float(y) - f.y);
+        for (int x = -1; x <= 2; x++) {
+            float w = lanczos2(float(x) - f.x) * wy;
+            ivec2 texel = clamp(ivec2(base) + ivec2(x, y), ivec2(0), maxTexel);
+            vec3 color = texelFetch(sceneColor, texel, 0).rgb;
+            sum += color * w;
+            weightSum += w;
+            if (x >= 0 && x <= 1 && y >= 0 && y <= 1) {
+                minColor = min(minColor, color);
+                maxColor = max(maxColor, color);
+            }
+        }
+    }
+
+    // The negative lobes overshoot at hard edges; clamping to the four nearest
+    // texels removes the halos while keeping the sharpening elsewhere
+    outColor = vec4(clamp(sum / weightSum, minColor, maxColor), 1.0);
+}
\ No newline at end of file